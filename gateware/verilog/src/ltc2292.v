@@ -15,8 +15,13 @@ module ltc2292 #(
 ) (
    input wire        clk,
    input wire [11:0] di,
+   // Overflow/underflow flags. LSB is channel A, MSB channel B.
+   input wire [1:0]  ofi,
    output reg [11:0] dao = 12'd0,
-   output reg [11:0] dbo = 12'd0
+   output reg [11:0] dbo = 12'd0,
+   // Overflow flags aligned with dao and dbo.
+   output reg        ofao = 1'b0,
+   output reg        ofbo = 1'b0
 );
 
    // TODO verify this is correct. It's not clear, and Henrik does it
@@ -25,14 +30,18 @@ module ltc2292 #(
    // sampled on the clock's rising edge.
 
    reg [11:0] dbuf = 12'd0;
+   reg        ofbbuf = 1'b0;
 
    always @(posedge clk) begin
-      dao <= di;
-      dbo <= dbuf;
+      dao  <= di;
+      dbo  <= dbuf;
+      ofao <= ofi[0];
+      ofbo <= ofbbuf;
    end
 
    always @(negedge clk) begin
-      dbuf <= di;
+      dbuf   <= di;
+      ofbbuf <= ofi[1];
    end
 
 endmodule
@@ -0,0 +1,140 @@
+`ifndef _MTI_V_
+`define _MTI_V_
+
+`default_nettype none
+`timescale 1ns/1ps
+
+`include "ff_sync.v"
+
+// Moving target indication pulse canceller. Each output sample is the
+// difference between the input sample and the sample at the same
+// position in the previous sweep (2-pulse), or the second difference
+// over the previous two sweeps (3-pulse), which removes stationary
+// clutter. The previous two sweeps are always kept in block RAM, so
+// the canceller can be enabled without waiting for history.
+//
+// Samples are passed through unchanged until enough sweeps have been
+// stored for the selected mode. `active' reports whether the current
+// sweep was cancelled.
+//
+// The history read is registered, so samples must be at least 2
+// clock periods apart.
+
+module mti #(
+   parameter N          = 1024,
+   parameter DATA_WIDTH = 13
+) (
+   input wire                         clk,
+   input wire                         arst_n,
+   input wire                         en,
+   input wire                         clk_en,
+   input wire [1:0]                   mode,
+   input wire signed [DATA_WIDTH-1:0] di,
+   output reg                         dvalid = 1'b0,
+   output reg signed [DATA_WIDTH-1:0] dout = {DATA_WIDTH{1'b0}},
+   output reg                         active = 1'b0
+);
+
+   localparam OFF         = 2'd0,
+              TWO_PULSE   = 2'd1,
+              THREE_PULSE = 2'd2;
+
+   // The 3-pulse canceller has a gain of up to 4.
+   localparam INTERNAL_WIDTH = DATA_WIDTH + 2;
+   /* verilator lint_off WIDTH */
+   localparam [$clog2(N)-1:0] N_CMP = N - 1;
+   /* verilator lint_on WIDTH */
+
+   wire                               srst_n;
+   ff_sync #(
+      .WIDTH  (1),
+      .STAGES (2)
+   ) rst_sync (
+      .dest_clk (clk    ),
+      .d        (arst_n ),
+      .q        (srst_n )
+   );
+
+   function [DATA_WIDTH-1:0] saturate(input [INTERNAL_WIDTH-1:0] expr);
+      if (expr[INTERNAL_WIDTH-1:DATA_WIDTH-1] == {3{1'b0}}
+          | expr[INTERNAL_WIDTH-1:DATA_WIDTH-1] == {3{1'b1}})
+        saturate = expr[DATA_WIDTH-1:0];
+      else if (expr[INTERNAL_WIDTH-1])
+        saturate = {1'b1, {DATA_WIDTH-1{1'b0}}};
+      else
+        saturate = {1'b0, {DATA_WIDTH-1{1'b1}}};
+   endfunction
+
+   // Previous sweep in the upper half, the one before in the lower.
+   reg [2*DATA_WIDTH-1:0] hist [0:N-1];
+   reg [2*DATA_WIDTH-1:0] hist_rd = {2*DATA_WIDTH{1'b0}};
+   reg [$clog2(N)-1:0]    ctr     = {$clog2(N){1'b0}};
+   // Complete sweeps stored, saturating at 2.
+   reg [1:0]              primed  = 2'd0;
+   reg [1:0]              sweep_mode = OFF;
+
+   integer i;
+   initial begin
+      for (i=0; i<N; i=i+1)
+        hist[i] = {2*DATA_WIDTH{1'b0}};
+   end
+
+   wire sample = clk_en & en;
+
+   // The mode only changes between sweeps.
+   wire [1:0] cur_mode = ctr == {$clog2(N){1'b0}} ? mode : sweep_mode;
+   wire       cur_active = (cur_mode == TWO_PULSE & primed != 2'd0)
+                           | (cur_mode == THREE_PULSE & primed == 2'd2);
+
+   wire signed [DATA_WIDTH-1:0]     x1 = hist_rd[2*DATA_WIDTH-1:DATA_WIDTH];
+   wire signed [DATA_WIDTH-1:0]     x2 = hist_rd[DATA_WIDTH-1:0];
+   wire signed [INTERNAL_WIDTH-1:0] di_ext = di;
+   wire signed [INTERNAL_WIDTH-1:0] x1_ext = x1;
+   wire signed [INTERNAL_WIDTH-1:0] x2_ext = x2;
+   wire signed [INTERNAL_WIDTH-1:0] diff = cur_mode == THREE_PULSE ? di_ext - (x1_ext <<< 1) + x2_ext
+                                                                   : di_ext - x1_ext;
+
+   always @(posedge clk) begin
+      hist_rd <= hist[ctr];
+      if (sample) hist[ctr] <= {di, x1};
+   end
+
+   always @(posedge clk) begin
+      if (~srst_n) begin
+         ctr    <= {$clog2(N){1'b0}};
+         primed <= 2'd0;
+         dvalid <= 1'b0;
+         active <= 1'b0;
+      end else if (clk_en) begin
+         dvalid <= en;
+         if (en) begin
+            if (cur_active) dout <= saturate(diff);
+            else            dout <= di;
+
+            if (ctr == {$clog2(N){1'b0}}) begin
+               sweep_mode <= mode;
+               active     <= cur_active;
+            end
+
+            if (ctr == N_CMP) begin
+               ctr <= {$clog2(N){1'b0}};
+               if (primed != 2'd2) primed <= primed + 1'b1;
+            end else begin
+               ctr <= ctr + 1'b1;
+            end
+         end
+      end
+   end
+
+`ifdef COCOTB_SIM
+   `ifdef MTI
+   initial begin
+      $dumpfile ("cocotb/build/mti.vcd");
+      $dumpvars (0, mti);
+      #1;
+   end
+   `endif
+`endif
+
+endmodule
+`endif
@@ -15,6 +15,7 @@
 `include "clk_enable.v"
 `include "fir.v"
 `include "window.v"
+`include "mti.v"
 `include "fft.v"
 
 `default_nettype none
@@ -171,15 +172,6 @@ module top #(
       .ctr     (clk80_40_phase_ctr )
    );
 
-   wire [2:0] clk80_10_phase_ctr;
-   pll_sync_ctr #(
-      .RATIO (8)
-   ) clk80_10_sync_ctr (
-      .fst_clk (clk80              ),
-      .slw_clk (clk10              ),
-      .ctr     (clk80_10_phase_ctr )
-   );
-
    /* verilator lint_off PINMISSING */
    wire clk2_pos_en;
    clk_enable #(
@@ -284,13 +276,19 @@ module top #(
       .q        (use_chan_b       )
    );
 
+   wire                              adc_of_a;
+   wire                              adc_of_b;
    ltc2292 ltc2292 (
-      .clk (clk_i      ),
-      .di  (adc_d_i    ),
-      .dao (adc_chan_a ),
-      .dbo (adc_chan_b )
+      .clk  (clk_i      ),
+      .di   (adc_d_i    ),
+      .ofi  (adc_of_i   ),
+      .dao  (adc_chan_a ),
+      .dbo  (adc_chan_b ),
+      .ofao (adc_of_a   ),
+      .ofbo (adc_of_b   )
    );
    wire signed [`ADC_DATA_WIDTH-1:0] adc_single_chan = use_chan_a ? adc_chan_a : adc_chan_b;
+   wire                              adc_single_chan_of = use_chan_a ? adc_of_a : adc_of_b;
 
    assign adc_single_chan_msb = {4'd0, adc_single_chan[`ADC_DATA_WIDTH-1:8]};
    assign adc_single_chan_lsb = adc_single_chan[7:0];
@@ -312,6 +310,18 @@ module top #(
       .q        (out       )
    );
 
+   // Pulse canceller mode, see mti.v.
+   reg [1:0]  mti_ftclk = 2'd0;
+   wire [1:0] mti_mode;
+   ff_sync #(
+      .WIDTH  (2),
+      .STAGES (2)
+   ) mti_sync (
+      .dest_clk (clk_i     ),
+      .d        (mti_ftclk ),
+      .q        (mti_mode  )
+   );
+
    reg fir_en = 1'b0;
    reg fir_en_next;
 
@@ -330,6 +340,54 @@ module top #(
       fir_en <= fir_en_next;
    end
 
+   // Number of ADC overflows during the last sweep. This saturates
+   // and, with the pulse canceller flag above it, leaves the MSB of a
+   // 16-bit word clear so that the frame trailer can never be
+   // mistaken for a flag.
+   localparam OVERFLOW_WIDTH = 14;
+   localparam [OVERFLOW_WIDTH-1:0] OVERFLOW_MAX = {OVERFLOW_WIDTH{1'b1}};
+   reg [OVERFLOW_WIDTH-1:0] overflow_ctr   = {OVERFLOW_WIDTH{1'b0}};
+   reg [OVERFLOW_WIDTH-1:0] overflow_sweep = {OVERFLOW_WIDTH{1'b0}};
+   wire                     mti_active;
+   reg                      mti_sweep      = 1'b0;
+   always @(posedge clk_i) begin
+      case (1'b1)
+      state[WAIT]: overflow_ctr <= {OVERFLOW_WIDTH{1'b0}};
+      state[SAMPLE]:
+        begin
+           if (fir_en & adc_single_chan_of & overflow_ctr != OVERFLOW_MAX)
+             overflow_ctr <= overflow_ctr + 1'b1;
+        end
+      // Stable from here until the trailer has been sent, since the
+      // next sweep is not sampled until TX completes.
+      state[PROC_FILTER]:
+        begin
+           overflow_sweep <= overflow_ctr;
+           mti_sweep      <= mti_active & (out == WINDOW | out == FFT);
+        end
+      endcase
+   end
+
+   wire [OVERFLOW_WIDTH-1:0] overflow_sweep_ftclk;
+   ff_sync #(
+      .WIDTH  (OVERFLOW_WIDTH ),
+      .STAGES (2              )
+   ) overflow_sweep_sync (
+      .dest_clk (ft_clkout_i          ),
+      .d        (overflow_sweep       ),
+      .q        (overflow_sweep_ftclk )
+   );
+
+   wire mti_sweep_ftclk;
+   ff_sync #(
+      .WIDTH  (1 ),
+      .STAGES (2 )
+   ) mti_sweep_sync (
+      .dest_clk (ft_clkout_i     ),
+      .d        (mti_sweep       ),
+      .q        (mti_sweep_ftclk )
+   );
+
    wire signed [FIR_OUTPUT_WIDTH-1:0] fir_out;
    wire                               fir_dvalid;
    fir #(
@@ -391,11 +449,28 @@ module top #(
       .dout   (window_out    )
    );
 
+   wire                               mti_dvalid;
+   wire signed [FIR_OUTPUT_WIDTH-1:0] mti_out;
+   mti #(
+      .N          (FFT_N            ),
+      .DATA_WIDTH (FIR_OUTPUT_WIDTH )
+   ) mti (
+      .clk    (clk_i         ),
+      .arst_n (~stop_ftclk   ),
+      .en     (window_dvalid ),
+      .clk_en (clk2_pos_en   ),
+      .mode   (mti_mode      ),
+      .di     (window_out    ),
+      .dvalid (mti_dvalid    ),
+      .dout   (mti_out       ),
+      .active (mti_active    )
+   );
+
    wire                            window_fifo_empty;
    wire                            window_fifo_full;
    reg                             window_fifo_ren = 1'b0;
    wire [FIR_OUTPUT_WIDTH-1:0]     window_fifo_rdata;
-   wire                            window_fifo_wen = window_dvalid;
+   wire                            window_fifo_wen = mti_dvalid;
    sync_fifo #(
       .WIDTH (FIR_OUTPUT_WIDTH ),
       .DEPTH (FFT_N            )
@@ -403,7 +478,7 @@ module top #(
       .clk    (clk_i                         ),
       .srst_n (~stop                         ),
       .wen    (window_fifo_wen & clk2_pos_en ),
-      .wdata  (window_out                    ),
+      .wdata  (mti_out                       ),
       .ren    (window_fifo_ren               ),
       .empty  (window_fifo_empty             ),
       .full   (window_fifo_full              ),
@@ -465,7 +540,7 @@ module top #(
       end
    end
 
-   always @(posedge clk10) begin
+   always @(posedge clk_i) begin
       if (stop) begin
          fft_ram_raddr  <= {$clog2(FFT_N){1'b0}};
          fft_ram_empty <= 1'b1;
@@ -492,29 +567,40 @@ module top #(
       .wren   (fft_valid            ),
       .wraddr (fft_ctr              ),
       .wrdata ({fft_re_o, fft_im_o} ),
-      .rdclk  (clk10                ),
-      .rden   (fft_ram_ren         ),
+      .rdclk  (clk_i                ),
+      .rden   (fft_ram_ren          ),
       .rdaddr (fft_ram_raddr        ),
-      .rddata (fft_ram_rdata       )
+      .rddata (fft_ram_rdata        )
    );
 
-   // TODO this is not properly parameterized. Currently, we assume
-   // FIR_OUTPUT_WIDTH = 13, which gives FFT_OUTPUT_WIDTH = 24.
-   // localparam FFT_REM_WIDTH = 64 - (2 * FFT_OUTPUT_WIDTH);
-   reg [`USB_DATA_WIDTH-1:0] ft_fft_ram_data;
-   always @(*) begin
-      case (clk80_10_phase_ctr)
-      3'd0: ft_fft_ram_data = 8'd0;
-      3'd1: ft_fft_ram_data = 8'd0;
-      3'd2: ft_fft_ram_data = fft_ram_rdata[47:40];
-      3'd3: ft_fft_ram_data = fft_ram_rdata[39:32];
-      3'd4: ft_fft_ram_data = fft_ram_rdata[31:24];
-      3'd5: ft_fft_ram_data = fft_ram_rdata[23:16];
-      3'd6: ft_fft_ram_data = fft_ram_rdata[15:8];
-      3'd7: ft_fft_ram_data = fft_ram_rdata[7:0];
-      endcase
+   // The bit-reversed result is moved a whole word per clk_i cycle
+   // into its own FIFO and serialized into bytes on the FT clock, so
+   // the transfer out of the RAM no longer runs at a byte per clk80
+   // cycle.
+   reg                            fft_fifo_wen = 1'b0;
+   wire                           fft_fifo_ren;
+   wire                           fft_fifo_empty;
+   wire [2*FFT_OUTPUT_WIDTH-1:0]  fft_fifo_rdata;
+   always @(posedge clk_i) begin
+      fft_fifo_wen <= fft_ram_ren & ~fft_ram_empty;
    end
 
+   /* verilator lint_off PINMISSING */
+   async_fifo #(
+      .WIDTH (2*FFT_OUTPUT_WIDTH ),
+      .DEPTH (FFT_N              )
+   ) fft_fifo (
+      .wclk  (clk_i          ),
+      .rst_n (~stop_ftclk    ),
+      .wen   (fft_fifo_wen   ),
+      .wdata (fft_ram_rdata  ),
+      .rclk  (ft_clkout_i    ),
+      .ren   (fft_fifo_ren   ),
+      .empty (fft_fifo_empty ),
+      .rdata (fft_fifo_rdata )
+   );
+   /* verilator lint_on PINMISSING */
+
    // ============== System clock (40MHz) state machine ==============
    initial begin
       state       = {NUM_STATES{1'b0}};
@@ -547,7 +633,7 @@ module top #(
         end
       FFT:
         begin
-           ft_fifo_wdata  = ft_fft_ram_data;
+           ft_fifo_wdata  = {`USB_DATA_WIDTH{1'b0}};
            out_fifo_empty = fft_ram_empty;
         end
       endcase
@@ -679,18 +765,13 @@ module top #(
                    window_fifo_ren <= 1'b1;
                    if (window_fifo_ren) ft_fifo_wen <= 1'b1;
                 end
-              FFT: if (fft_ram_ren & (ft_fifo_wen | clk80_10_phase_ctr == 3'd7)) ft_fifo_wen <= 1'b1;
               endcase
            end
         end
-      next[TX]:
-        begin
-           if (out == FFT & fft_ram_ren & clk80_10_phase_ctr < 3'd7) ft_fifo_wen <= 1'b1;
-        end
       endcase
    end
 
-   always @(posedge clk10) begin
+   always @(posedge clk_i) begin
       fft_ram_ren <= 1'b0;
       case (1'b1)
       next[TX_LOAD]: if (out == FFT) fft_ram_ren <= 1'b1;
@@ -701,6 +782,8 @@ module top #(
    wire                            ft_fifo_empty;
    reg                             ft_fifo_ren = 1'b0;
    wire [`USB_DATA_WIDTH-1:0]      ft_fifo_rdata;
+   wire                            ft_tx_empty;
+   wire [`USB_DATA_WIDTH-1:0]      ft_tx_rdata;
 
    localparam FLAG_WIDTH = $clog2(8);
    reg [FLAG_WIDTH-1:0] flag_ctr = {FLAG_WIDTH{1'b0}};
@@ -720,19 +803,157 @@ module top #(
       .WIDTH (`USB_DATA_WIDTH ),
       .DEPTH (FT_FIFO_DEPTH   )
    ) ft_fifo (
-      .wclk  (clk80         ),
-      .rst_n (~stop_ftclk   ),
-      .wen   (ft_fifo_wen   ),
-      .wdata (ft_fifo_wdata ),
-      .rclk  (ft_clkout_i   ),
-      .ren   (ft_fifo_ren   ),
-      .empty (ft_fifo_empty ),
-      .rdata (ft_fifo_rdata )
+      .wclk  (clk80                          ),
+      .rst_n (~stop_ftclk                    ),
+      .wen   (ft_fifo_wen                    ),
+      .wdata (ft_fifo_wdata                  ),
+      .rclk  (ft_clkout_i                    ),
+      .ren   (ft_fifo_ren & out_ftclk != FFT ),
+      .empty (ft_fifo_empty                  ),
+      .rdata (ft_fifo_rdata                  )
    );
    /* verilator lint_on PINMISSING */
 
+   // Present the FFT FIFO to the TX logic as a byte FIFO with the
+   // same registered-read behavior as ft_fifo. Each 48-bit word is
+   // sent as 8 bytes, MSB first, led by two zero bytes. A word is
+   // popped on its first (zero) byte, so it is available by the time
+   // its first data byte is read.
+   // TODO this is not properly parameterized. Currently, we assume
+   // FIR_OUTPUT_WIDTH = 13, which gives FFT_OUTPUT_WIDTH = 24.
+   reg [FLAG_WIDTH-1:0]      fft_byte_idx   = {FLAG_WIDTH{1'b0}};
+   reg [`USB_DATA_WIDTH-1:0] fft_byte_rdata = `USB_DATA_WIDTH'd0;
+   wire                      fft_byte_empty = fft_fifo_empty & fft_byte_idx == {FLAG_WIDTH{1'b0}};
+   wire                      fft_byte_ren   = ft_fifo_ren & out_ftclk == FFT & ~fft_byte_empty;
+   assign fft_fifo_ren = fft_byte_ren & fft_byte_idx == {FLAG_WIDTH{1'b0}};
+
+   always @(posedge ft_clkout_i) begin
+      if (stop_ftclk) begin
+         fft_byte_idx <= {FLAG_WIDTH{1'b0}};
+      end else if (fft_byte_ren) begin
+         fft_byte_idx <= fft_byte_idx + 1'b1;
+         case (fft_byte_idx)
+         3'd0: fft_byte_rdata <= 8'd0;
+         3'd1: fft_byte_rdata <= 8'd0;
+         3'd2: fft_byte_rdata <= fft_fifo_rdata[47:40];
+         3'd3: fft_byte_rdata <= fft_fifo_rdata[39:32];
+         3'd4: fft_byte_rdata <= fft_fifo_rdata[31:24];
+         3'd5: fft_byte_rdata <= fft_fifo_rdata[23:16];
+         3'd6: fft_byte_rdata <= fft_fifo_rdata[15:8];
+         3'd7: fft_byte_rdata <= fft_fifo_rdata[7:0];
+         endcase
+      end
+   end
+
+   assign ft_tx_empty = out_ftclk == FFT ? fft_byte_empty : ft_fifo_empty;
+   assign ft_tx_rdata = out_ftclk == FFT ? fft_byte_rdata : ft_fifo_rdata;
+
+   // ======================== control channel =======================
+   // FT2232H interface B drives the FPGA's JTAG port. Besides
+   // configuration, the host can shift commands into the USER1 data
+   // register, so that they never interrupt the data stream on
+   // interface A. Each 40-bit scan holds an interface A command byte
+   // in its low byte and the command's payload, LSB first, above it.
+   //
+   // Commands wait in ctl_fifo until the current frame has been sent,
+   // so a burst can fill it. Capture-DR loads a busy bit into bit 0 of
+   // the scan, which the host reads back on TDO. A scan that captured
+   // busy is discarded, and so is every scan after it until the TAP
+   // passes through Test-Logic-Reset, so that the host can resend from
+   // the first discarded command without reordering any.
+   localparam CTL_WIDTH = 40;
+   wire                 jtag_tdo;
+   reg [CTL_WIDTH-1:0]  ctl_sr = {CTL_WIDTH{1'b0}};
+`ifdef TOP
+   reg jtag_tck     = 1'b0;
+   reg jtag_sel     = 1'b0;
+   reg jtag_capture = 1'b0;
+   reg jtag_shift   = 1'b0;
+   reg jtag_update  = 1'b0;
+   reg jtag_reset   = 1'b0;
+   reg jtag_tdi     = 1'b0;
+`elsif TOP_SIMULATE
+   reg jtag_tck     = 1'b0;
+   reg jtag_sel     = 1'b0;
+   reg jtag_capture = 1'b0;
+   reg jtag_shift   = 1'b0;
+   reg jtag_update  = 1'b0;
+   reg jtag_reset   = 1'b0;
+   reg jtag_tdi     = 1'b0;
+`else
+   wire jtag_tck;
+   wire jtag_sel;
+   wire jtag_capture;
+   wire jtag_shift;
+   wire jtag_update;
+   wire jtag_reset;
+   wire jtag_tdi;
+   /* verilator lint_off PINMISSING */
+   BSCANE2 #(
+      .JTAG_CHAIN (1 )
+   ) ctl_bscan (
+      .TCK     (jtag_tck     ),
+      .SEL     (jtag_sel     ),
+      .CAPTURE (jtag_capture ),
+      .SHIFT   (jtag_shift   ),
+      .UPDATE  (jtag_update  ),
+      .RESET   (jtag_reset   ),
+      .TDI     (jtag_tdi     ),
+      .TDO     (jtag_tdo     )
+   );
+   /* verilator lint_on PINMISSING */
+`endif
+   assign jtag_tdo = ctl_sr[0];
+
+   wire ctl_full;
+   reg  ctl_reject = 1'b0;
+   reg  ctl_take   = 1'b0;
+   wire ctl_busy   = ctl_full | ctl_reject;
+
+   always @(posedge jtag_tck) begin
+      if (jtag_sel & jtag_capture)    ctl_sr <= {{CTL_WIDTH-1{1'b0}}, ctl_busy};
+      else if (jtag_sel & jtag_shift) ctl_sr <= {jtag_tdi, ctl_sr[CTL_WIDTH-1:1]};
+   end
+
+   // Only reads can change ctl_full between Capture-DR and Update-DR,
+   // so a scan that captured a free slot always has one to write.
+   always @(posedge jtag_tck) begin
+      if (jtag_reset)                              ctl_reject <= 1'b0;
+      else if (jtag_sel & jtag_update & ~ctl_take) ctl_reject <= 1'b1;
+      if (jtag_sel & jtag_capture) ctl_take <= ~ctl_busy;
+   end
+
+   wire                 ctl_empty;
+   wire                 ctl_ren;
+   wire [CTL_WIDTH-1:0] ctl_rdata;
+   /* verilator lint_off PINMISSING */
+   async_fifo #(
+      .WIDTH (CTL_WIDTH ),
+      .DEPTH (16        )
+   ) ctl_fifo (
+      .wclk  (jtag_tck                          ),
+      .rst_n (1'b1                              ),
+      .wen   (jtag_sel & jtag_update & ctl_take ),
+      .full  (ctl_full                          ),
+      .wdata (ctl_sr                            ),
+      .rclk  (ft_clkout_i                       ),
+      .ren   (ctl_ren                           ),
+      .empty (ctl_empty                         ),
+      .rdata (ctl_rdata                         )
+   );
+   /* verilator lint_on PINMISSING */
+
+   // One command is popped and held until the FT state machine is
+   // between frames with nothing to read on interface A.
+   reg                        ctl_popped   = 1'b0;
+   reg                        ctl_held     = 1'b0;
+   reg                        ctl_adf_send = 1'b0;
+   wire [`USB_DATA_WIDTH-1:0] ctl_cmd = ctl_rdata[7:0];
+   wire [31:0]                ctl_val = ctl_rdata[CTL_WIDTH-1:8];
+   assign ctl_ren = ~ctl_empty & ~ctl_held & ~ctl_popped;
+
    // ==================== FT clock state machine ====================
-   localparam FTCLK_NUM_STATES = 29;
+   localparam FTCLK_NUM_STATES = 32;
    localparam FTCLK_IDLE            = 0,
               FTCLK_READ_OE         = 1,
               FTCLK_READ_CMD_PRE    = 2,
@@ -745,23 +966,26 @@ module top #(
               FTCLK_READ_CHANB      = 9,
               FTCLK_READ_OUTPUT_PRE = 10,
               FTCLK_READ_OUTPUT     = 11,
-              FTCLK_READ_ADF0_PRE   = 12,
-              FTCLK_READ_ADF0       = 13,
-              FTCLK_READ_ADF1_PRE   = 14,
-              FTCLK_READ_ADF1       = 15,
-              FTCLK_READ_ADF2_PRE   = 16,
-              FTCLK_READ_ADF2       = 17,
-              FTCLK_READ_ADF3_PRE   = 18,
-              FTCLK_READ_ADF3       = 19,
-              FTCLK_READ_ADF_SEND   = 20,
-              FTCLK_TX_LOAD         = 21,
-              FTCLK_TX_START        = 22,
-              FTCLK_TX_DATA         = 23,
-              FTCLK_TX_TXE          = 24,
-              FTCLK_TX_LAST         = 25,
-              FTCLK_TX_STOP         = 26,
-              FTCLK_TX_DELAY        = 27,
-              FTCLK_TX_WAIT         = 28;
+              FTCLK_READ_MTI_PRE    = 12,
+              FTCLK_READ_MTI        = 13,
+              FTCLK_READ_ADF0_PRE   = 14,
+              FTCLK_READ_ADF0       = 15,
+              FTCLK_READ_ADF1_PRE   = 16,
+              FTCLK_READ_ADF1       = 17,
+              FTCLK_READ_ADF2_PRE   = 18,
+              FTCLK_READ_ADF2       = 19,
+              FTCLK_READ_ADF3_PRE   = 20,
+              FTCLK_READ_ADF3       = 21,
+              FTCLK_READ_ADF_SEND   = 22,
+              FTCLK_TX_LOAD         = 23,
+              FTCLK_TX_START        = 24,
+              FTCLK_TX_DATA         = 25,
+              FTCLK_TX_TXE          = 26,
+              FTCLK_TX_LAST         = 27,
+              FTCLK_TX_STOP         = 28,
+              FTCLK_TX_DELAY        = 29,
+              FTCLK_TX_WAIT         = 30,
+              FTCLK_TX_TRAILER      = 31;
    reg [FTCLK_NUM_STATES-1:0] ftclk_state;
    reg [FTCLK_NUM_STATES-1:0] ftclk_next;
    initial begin
@@ -784,12 +1008,25 @@ module top #(
    localparam [$clog2(DELAY)-1:0] DELAY_MAX = DELAY - 1;
    reg [$clog2(DELAY)-1:0] delay_ctr;
 
+   wire ctl_apply = ctl_held & ft_rxf_n_i & (ftclk_state[FTCLK_IDLE] | ftclk_state[FTCLK_TX_WAIT]);
+   wire ctl_start = ctl_apply & ctl_cmd == 8'h00;
+   wire ctl_stop  = ctl_apply & ctl_cmd == 8'hFF;
+
+   always @(posedge ft_clkout_i) begin
+      ctl_popped   <= ctl_ren;
+      ctl_adf_send <= ctl_apply & ctl_cmd[7] & ~ctl_stop;
+      if (ctl_popped)     ctl_held <= 1'b1;
+      else if (ctl_apply) ctl_held <= 1'b0;
+   end
+
    reg [`USB_DATA_WIDTH-1:0] ft_rd_data;
    always @(*) begin
       ftclk_next = {FTCLK_NUM_STATES{1'b0}};
       case (1'b1)
-      ftclk_state[FTCLK_IDLE]          : if (~ft_rxf_n_i) ftclk_next[FTCLK_READ_OE] = 1'b1;
-                                         else             ftclk_next[FTCLK_IDLE]    = 1'b1;
+      ftclk_state[FTCLK_IDLE]          : if (~ft_rxf_n_i)   ftclk_next[FTCLK_READ_OE]    = 1'b1;
+                                         else if (ctl_start) ftclk_next[FTCLK_READ_START] = 1'b1;
+                                         else if (ctl_stop)  ftclk_next[FTCLK_READ_STOP]  = 1'b1;
+                                         else                ftclk_next[FTCLK_IDLE]       = 1'b1;
 
       // Read states
       ftclk_state[FTCLK_READ_OE]         :                                 ftclk_next[FTCLK_READ_CMD_PRE]    = 1'b1;
@@ -801,6 +1038,7 @@ module top #(
                                            else if (ft_rd_data == 8'h01)   ftclk_next[FTCLK_READ_CHANA_PRE]  = 1'b1;
                                            else if (ft_rd_data == 8'h02)   ftclk_next[FTCLK_READ_CHANB_PRE]  = 1'b1;
                                            else if (ft_rd_data == 8'h03)   ftclk_next[FTCLK_READ_OUTPUT_PRE] = 1'b1;
+                                           else if (ft_rd_data == 8'h04)   ftclk_next[FTCLK_READ_MTI_PRE]    = 1'b1;
                                            // TODO this should never occur and can bring the state
                                            // machine into a temporary bad state
                                            else                            ftclk_next[FTCLK_IDLE]            = 1'b1;
@@ -820,6 +1058,10 @@ module top #(
                                            else                            ftclk_next[FTCLK_READ_OUTPUT_PRE] = 1'b1;
       ftclk_state[FTCLK_READ_OUTPUT]     : if (ftclk_ctr == CTR_MAX)       ftclk_next[FTCLK_READ_CMD_PRE]    = 1'b1;
                                            else                            ftclk_next[FTCLK_READ_OUTPUT]     = 1'b1;
+      ftclk_state[FTCLK_READ_MTI_PRE]    : if (~ft_rd_n_o)                 ftclk_next[FTCLK_READ_MTI]        = 1'b1;
+                                           else                            ftclk_next[FTCLK_READ_MTI_PRE]    = 1'b1;
+      ftclk_state[FTCLK_READ_MTI]        : if (ftclk_ctr == CTR_MAX)       ftclk_next[FTCLK_READ_CMD_PRE]    = 1'b1;
+                                           else                            ftclk_next[FTCLK_READ_MTI]        = 1'b1;
       ftclk_state[FTCLK_READ_ADF0_PRE]   : if (~ft_rd_n_o)                 ftclk_next[FTCLK_READ_ADF0]       = 1'b1;
                                            else                            ftclk_next[FTCLK_READ_ADF0_PRE]   = 1'b1;
       ftclk_state[FTCLK_READ_ADF0]       :                                 ftclk_next[FTCLK_READ_ADF1_PRE]   = 1'b1;
@@ -836,19 +1078,23 @@ module top #(
 
       // TX states
       ftclk_state[FTCLK_TX_WAIT]         : if (~ft_rxf_n_i)                             ftclk_next[FTCLK_READ_OE]  = 1'b1;
+                                           else if (ctl_start)                          ftclk_next[FTCLK_READ_START] = 1'b1;
+                                           else if (ctl_stop)                           ftclk_next[FTCLK_READ_STOP]  = 1'b1;
                                            else if (state_ftclk_domain[TX_LOAD])        ftclk_next[FTCLK_TX_LOAD]  = 1'b1;
                                            else                                         ftclk_next[FTCLK_TX_WAIT]  = 1'b1;
       ftclk_state[FTCLK_TX_LOAD]         : if (out_ftclk == RAW | out_fifo_empty_ftclk) ftclk_next[FTCLK_TX_START] = 1'b1;
                                            else                                         ftclk_next[FTCLK_TX_LOAD]  = 1'b1;
       ftclk_state[FTCLK_TX_START]        : if (flag_ctr == max_flag_ctr)                ftclk_next[FTCLK_TX_DATA]  = 1'b1;
                                            else                                         ftclk_next[FTCLK_TX_START] = 1'b1;
-      ftclk_state[FTCLK_TX_DATA]         : if (ft_fifo_empty)                           ftclk_next[FTCLK_TX_LAST]  = 1'b1;
+      ftclk_state[FTCLK_TX_DATA]         : if (ft_tx_empty)                             ftclk_next[FTCLK_TX_LAST]  = 1'b1;
                                            else if (ft_txe_n_i)                         ftclk_next[FTCLK_TX_TXE]   = 1'b1;
                                            else                                         ftclk_next[FTCLK_TX_DATA]  = 1'b1;
       ftclk_state[FTCLK_TX_TXE]          : if (~ft_txe_n_i)                             ftclk_next[FTCLK_TX_DATA]  = 1'b1;
                                            else                                         ftclk_next[FTCLK_TX_TXE]   = 1'b1;
-      ftclk_state[FTCLK_TX_LAST]         : if (~ft_txe_n_i)                             ftclk_next[FTCLK_TX_STOP]  = 1'b1;
-                                           else                                         ftclk_next[FTCLK_TX_LAST]  = 1'b1;
+      ftclk_state[FTCLK_TX_LAST]         : if (~ft_txe_n_i)                             ftclk_next[FTCLK_TX_TRAILER] = 1'b1;
+                                           else                                         ftclk_next[FTCLK_TX_LAST]    = 1'b1;
+      ftclk_state[FTCLK_TX_TRAILER]      : if (flag_ctr == max_flag_ctr & ~ft_txe_n_i)  ftclk_next[FTCLK_TX_STOP]    = 1'b1;
+                                           else                                         ftclk_next[FTCLK_TX_TRAILER] = 1'b1;
       ftclk_state[FTCLK_TX_STOP]         : if (flag_ctr == max_flag_ctr)                ftclk_next[FTCLK_TX_DELAY] = 1'b1;
                                            else                                         ftclk_next[FTCLK_TX_STOP]  = 1'b1;
       ftclk_state[FTCLK_TX_DELAY]        : if (delay_ctr == DELAY_MAX)                  ftclk_next[FTCLK_TX_WAIT]  = 1'b1;
@@ -862,6 +1108,22 @@ module top #(
       if (~ft_rxf_n_i & ~ft_rd_n_o) ft_rd_data <= ft_data_io;
    end
 
+   // The frame trailer is one sample-width word, sent MSB first,
+   // holding the sweep's ADC overflow count and, in bit 14, whether
+   // the pulse canceller was applied to the sweep. flag_ctr counts the
+   // trailer bytes accepted by the FT2232H, so the byte to present
+   // next is one ahead of it whenever the current byte is accepted.
+   reg [FLAG_WIDTH-1:0]      trailer_idx;
+   reg [`USB_DATA_WIDTH-1:0] trailer_byte;
+   always @(*) begin
+      if (ftclk_state[FTCLK_TX_TRAILER] & ~ft_txe_n_i) trailer_idx = flag_ctr + 1'b1;
+      else                                             trailer_idx = flag_ctr;
+
+      if (trailer_idx == max_flag_ctr)             trailer_byte = overflow_sweep_ftclk[7:0];
+      else if (trailer_idx == max_flag_ctr - 1'b1) trailer_byte = {1'b0, mti_sweep_ftclk, overflow_sweep_ftclk[OVERFLOW_WIDTH-1:8]};
+      else                                         trailer_byte = `USB_DATA_WIDTH'd0;
+   end
+
    reg [`USB_DATA_WIDTH-1:0] ft_wr_data         = `USB_DATA_WIDTH'd0;
    reg [`USB_DATA_WIDTH-1:0] ft_fifo_rdata_last = `USB_DATA_WIDTH'd0;
    reg                       ft_txe_last        = 1'b0;
@@ -907,6 +1169,12 @@ module top #(
            if (~ft_rxf_n_i) ft_rd_n_o <= 1'b0;
         end
       ftclk_next[FTCLK_READ_OUTPUT]: ft_oe_n_o <= 1'b0;
+      ftclk_next[FTCLK_READ_MTI_PRE]:
+        begin
+           ft_oe_n_o <= 1'b0;
+           if (~ft_rxf_n_i) ft_rd_n_o <= 1'b0;
+        end
+      ftclk_next[FTCLK_READ_MTI]: ft_oe_n_o <= 1'b0;
       ftclk_next[FTCLK_READ_ADF0_PRE]:
         begin
            ft_oe_n_o <= 1'b0;
@@ -950,7 +1218,7 @@ module top #(
         end
       ftclk_next[FTCLK_TX_TXE] & ftclk_state[FTCLK_TX_DATA]:
         begin
-           ft_fifo_rdata_last <= ft_fifo_rdata;
+           ft_fifo_rdata_last <= ft_tx_rdata;
         end
       ftclk_next[FTCLK_TX_DATA] & ftclk_state[FTCLK_TX_TXE]:
         begin
@@ -959,10 +1227,15 @@ module top #(
       (ftclk_next[FTCLK_TX_DATA] | ftclk_next[FTCLK_TX_LAST]) & ~ftclk_state[FTCLK_TX_TXE]:
         begin
            if (ft_txe_last2) ft_wr_data <= ft_fifo_rdata_last;
-           else              ft_wr_data <= ft_fifo_rdata;
+           else              ft_wr_data <= ft_tx_rdata;
            ft_wr_n_o          <= 1'b0;
            ft_fifo_ren        <= 1'b1;
         end
+      ftclk_next[FTCLK_TX_TRAILER]:
+        begin
+           ft_wr_data <= trailer_byte;
+           ft_wr_n_o  <= 1'b0;
+        end
       ftclk_next[FTCLK_TX_STOP]:
         begin
            ft_wr_data <= STOP_FLAG;
@@ -970,6 +1243,9 @@ module top #(
            tx_done    <= 1'b1;
         end
       endcase
+
+      // ADF registers from the control channel, see below
+      if (ctl_adf_send) adf_reg_fifo_wen <= 1'b1;
    end
 
    always @(posedge ft_clkout_i) begin
@@ -1006,6 +1282,11 @@ module top #(
            ftclk_ctr <= ftclk_ctr + 1'b1;
            if (ftclk_ctr == {CTR_WIDTH{1'b0}}) out_ftclk <= ft_rd_data[1:0];
         end
+      ftclk_state[FTCLK_READ_MTI]:
+        begin
+           ftclk_ctr <= ftclk_ctr + 1'b1;
+           if (ftclk_ctr == {CTR_WIDTH{1'b0}}) mti_ftclk <= ft_rd_data[1:0];
+        end
       ftclk_state[FTCLK_READ_ADF0]: adf_val[7:0] <= ft_rd_data;
       ftclk_state[FTCLK_READ_ADF1]: adf_val[15:8] <= ft_rd_data;
       ftclk_state[FTCLK_READ_ADF2]: adf_val[23:16] <= ft_rd_data;
@@ -1017,6 +1298,12 @@ module top #(
            if (~ft_txe_n_i) flag_ctr <= flag_ctr + 1'b1;
            else             flag_ctr <= flag_ctr;
         end
+      ftclk_state[FTCLK_TX_TRAILER]:
+        begin
+           // wraps to 0 for the stop flags once the last byte is accepted
+           if (ft_txe_n_i)                    flag_ctr <= flag_ctr;
+           else if (flag_ctr != max_flag_ctr) flag_ctr <= flag_ctr + 1'b1;
+        end
       ftclk_state[FTCLK_TX_STOP]:
         begin
            if (~ft_txe_n_i) flag_ctr <= flag_ctr + 1'b1;
@@ -1024,6 +1311,19 @@ module top #(
         end
       ftclk_state[FTCLK_TX_DELAY]: delay_ctr <= delay_ctr + 1'b1;
       endcase
+
+      // Start and stop are applied by moving to the read states above,
+      // and ADF registers are pushed to adf_reg_fifo on the next cycle.
+      if (ctl_apply) begin
+         if (ctl_cmd == 8'h01)                       use_chan_a_ftclk <= ctl_val[0];
+         else if (ctl_cmd == 8'h02)                  use_chan_b_ftclk <= ctl_val[0];
+         else if (ctl_cmd == 8'h03)                  out_ftclk        <= ctl_val[1:0];
+         else if (ctl_cmd == 8'h04)                  mti_ftclk        <= ctl_val[1:0];
+         else if (ctl_cmd[7] & ctl_cmd != 8'hFF) begin
+            adf_reg <= ctl_cmd[2:0];
+            adf_val <= ctl_val;
+         end
+      end
    end
    // ================================================================
 
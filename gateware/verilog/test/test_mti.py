@@ -0,0 +1,121 @@
+#!/usr/bin/env python
+"""
+Unit tests for mti.
+"""
+
+import numpy as np
+
+from cocotb_helpers import Clock, ClockEnable, random_samples
+
+import cocotb
+from cocotb.triggers import RisingEdge, FallingEdge, ReadOnly
+from cocotb.result import TestFailure
+
+OFF = 0
+TWO_PULSE = 1
+THREE_PULSE = 2
+
+
+class MtiTB:
+    """
+    MTI testbench class.
+    """
+
+    def __init__(self, dut, num_samples, input_width, modes):
+        self.clk = Clock(dut.clk, 40)
+        self.clk_en = ClockEnable(dut.clk, dut.clk_en, 20)
+        self.dut = dut
+        self.modes = modes
+        self.inputs = [
+            random_samples(input_width, num_samples) for _ in modes
+        ]
+        self.outputs, self.active = self.gen_outputs(input_width)
+
+    @cocotb.coroutine
+    async def setup(self):
+        """
+        Initialize mti.
+        """
+        cocotb.fork(self.clk.start())
+        cocotb.fork(self.clk_en.start())
+        self.dut.en <= 0
+        self.dut.di <= 0
+        self.dut.mode <= OFF
+        await self.reset()
+
+    @cocotb.coroutine
+    async def reset(self):
+        """
+        Start mti in a known state.
+        """
+        await RisingEdge(self.dut.clk)
+        self.dut.arst_n <= 0
+        await RisingEdge(self.dut.clk)
+        self.dut.arst_n <= 1
+        # wait out the reset synchronizer
+        await FallingEdge(self.dut.clk_en)
+        await RisingEdge(self.dut.clk)
+
+    def gen_outputs(self, input_width):
+        """
+        Generate expected outputs. A mode only takes effect once enough
+        sweeps have been stored.
+        """
+        lo = -(2 ** (input_width - 1))
+        hi = 2 ** (input_width - 1) - 1
+        outputs = []
+        active = []
+        for i, mode in enumerate(self.modes):
+            x = self.inputs[i]
+            if mode == TWO_PULSE and i >= 1:
+                outputs.append(np.clip(x - self.inputs[i - 1], lo, hi))
+                active.append(1)
+            elif mode == THREE_PULSE and i >= 2:
+                y = x - 2 * self.inputs[i - 1] + self.inputs[i - 2]
+                outputs.append(np.clip(y, lo, hi))
+                active.append(1)
+            else:
+                outputs.append(x)
+                active.append(0)
+        return outputs, active
+
+
+@cocotb.test()
+async def check_results(dut):
+    """
+    Compare outputs with expected values over sweeps that switch
+    between canceller modes.
+    """
+    num_samples = 1024
+    input_width = 13
+    modes = [THREE_PULSE, THREE_PULSE, THREE_PULSE, TWO_PULSE, OFF]
+    tb = MtiTB(dut, num_samples, input_width, modes)
+    await tb.setup()
+
+    for sweep, mode in enumerate(modes):
+        dut.mode <= mode
+        for i in range(num_samples):
+            dut.di <= tb.inputs[sweep][i].item()
+            dut.en <= 1
+            await FallingEdge(dut.clk_en)
+            await ReadOnly()
+
+            if dut.dvalid.value.integer != 1:
+                raise TestFailure("Output not valid.")
+            if dut.active.value.integer != tb.active[sweep]:
+                raise TestFailure(
+                    "Active flag is %d, expected %d. Sweep %d."
+                    % (dut.active.value.integer, tb.active[sweep], sweep)
+                )
+            out_val = dut.dout.value.signed_integer
+            out_exp = tb.outputs[sweep][i].item()
+            if out_val != out_exp:
+                raise TestFailure(
+                    (
+                        "Actual output differs from expected."
+                        " Actual: %d, expected: %d. Sweep %d, sample %d."
+                    )
+                    % (out_val, out_exp, sweep, i)
+                )
+
+            await RisingEdge(dut.clk)
@@ -10,8 +10,9 @@ from fir import FIR
 import bit
 
 import cocotb
-from cocotb.triggers import RisingEdge, FallingEdge, ReadOnly
+from cocotb.triggers import RisingEdge, FallingEdge, ReadOnly, Timer
 from cocotb.result import TestFailure
+from cocotb.utils import get_sim_time
 
 
 class TopTb:
@@ -99,8 +100,9 @@ class TopTb:
             await RisingEdge(self.dut.ft_clkout_i)
 
     @cocotb.coroutine
-    async def write_configuration(self):
+    async def write_configuration(self, output: int = 0x03):
         """
+        :param output: Output selection, 0x00 (raw) to 0x03 (FFT).
         """
         cfg_ctr = 0
         cfg_arr = [
@@ -112,7 +114,7 @@ class TopTb:
             0x01,
             # output
             0x03,
-            0x03,
+            output,
             # adf reg 0
             0x80,
             0x00,
@@ -178,6 +180,126 @@ class TopTb:
 
         self.dut.ft_rxf_n_i.setimmediatevalue(1)
 
+    @cocotb.coroutine
+    async def clock_jtag(self, ncycles: int = 1):
+        """
+        Run TCK at 3MHz, as the host does.
+        """
+        half_period = 167
+        for _ in range(ncycles):
+            await Timer(half_period, "ns")
+            self.dut.jtag_tck <= 1
+            await Timer(half_period, "ns")
+            self.dut.jtag_tck <= 0
+
+    @cocotb.coroutine
+    async def reset_control(self):
+        """
+        Pass through Test-Logic-Reset, which the host does before every
+        batch of commands.
+        """
+        self.dut.jtag_reset <= 1
+        await self.clock_jtag()
+        self.dut.jtag_reset <= 0
+        await self.clock_jtag()
+
+    @cocotb.coroutine
+    async def write_control(self, cmd: int, val: int) -> bool:
+        """
+        Shift a command into the USER1 register, as the BSCANE2
+        primitive would present it. Returns the busy bit captured at
+        the start of the scan, which is set when the command was
+        discarded.
+        """
+        word = (val << 8) | cmd
+        self.dut.jtag_sel <= 1
+        self.dut.jtag_capture <= 1
+        await self.clock_jtag()
+        self.dut.jtag_capture <= 0
+        busy = bool(self.dut.jtag_tdo.value.integer)
+        self.dut.jtag_shift <= 1
+        for i in range(40):
+            self.dut.jtag_tdi <= (word >> i) & 1
+            await self.clock_jtag()
+        self.dut.jtag_shift <= 0
+        self.dut.jtag_update <= 1
+        await self.clock_jtag()
+        self.dut.jtag_update <= 0
+        self.dut.jtag_sel <= 0
+        # TCK runs on in Run-Test/Idle, which moves the write pointer
+        # through the FIFO's reset synchronizer.
+        await self.clock_jtag(4)
+        return busy
+
+    @cocotb.coroutine
+    async def write_controls(self, commands: list) -> int:
+        """
+        Write (command, value) pairs as the host does: shift all of
+        them, then resend from the first one the gateware discarded
+        until every one is taken. Returns the number of resends.
+        """
+        nresend = 0
+        ndone = 0
+        while True:
+            await self.reset_control()
+            busy = [await self.write_control(cmd, val) for cmd, val in commands[ndone:]]
+            if True not in busy:
+                return nresend
+            ndone += busy.index(True)
+            nresend += 1
+            await Timer(20, "us")
+
+    @cocotb.coroutine
+    async def monitor_control(self, applied: list, adf_writes: list):
+        """
+        Record each control command as it is applied, and each ADF
+        register write it leads to.
+        """
+        while True:
+            await RisingEdge(self.dut.ft_clkout_i)
+            if self.dut.ctl_apply.value.integer:
+                applied.append(
+                    (self.dut.ctl_cmd.value.integer, self.dut.ctl_val.value.integer)
+                )
+            if self.dut.adf_reg_fifo_wen.value.integer:
+                adf_writes.append(
+                    (self.dut.adf_reg.value.integer, self.dut.adf_val.value.integer)
+                )
+
+    @cocotb.coroutine
+    async def read_frame(self) -> list:
+        """
+        Collect the bytes accepted by the FT2232H for the next frame
+        and return those between its start and stop flags. A byte is
+        accepted on the rising FT clock edge when WR# and TXE# are both
+        low, so both are sampled on the preceding falling edge.
+        """
+        start_flag = 0xFF
+        stop_flag = 0x8F
+        nflags = 2
+        data = []
+        started = False
+        while True:
+            await FallingEdge(self.dut.ft_clkout_i)
+            if not (
+                self.dut.ft_wr_n_o.value.is_resolvable
+                and self.dut.ft_wr_n_o.value.integer == 0
+                and self.dut.ft_txe_n_i.value.integer == 0
+            ):
+                continue
+            # ft_data_io carries ft_wr_data while OE# is high, but
+            # the configuration writes leave a value deposited on it
+            byte = self.dut.ft_wr_data.value.integer
+            if not started:
+                data.append(byte)
+                if data[-nflags:] == [start_flag] * nflags:
+                    started = True
+                    data = []
+                continue
+            data.append(byte)
+            if data[-nflags:] == [stop_flag] * nflags:
+                return data[:-nflags]
+
     @cocotb.coroutine
     async def write_inputs(self):
         """
@@ -204,6 +326,23 @@ class TopTb:
 
             await RisingEdge(self.dut.clk_i)
 
+    @cocotb.coroutine
+    async def measure_fft_latency(self):
+        """
+        Count clk_i cycles from the last window sample of the first
+        sweep to the last FFT byte of that sweep being sent.
+        """
+        await RisingEdge(self.dut.window_fifo_full)
+        start = get_sim_time("ns")
+        # tx_done is a single FT clock pulse, so it's sampled on that
+        # clock rather than clk_i.
+        while True:
+            await RisingEdge(self.dut.ft_clkout_i)
+            await ReadOnly()
+            if self.dut.tx_done.value.integer == 1:
+                break
+        self.fft_latency = int((get_sim_time("ns") - start) / 25)
+
     def gen_outputs(self):
         """
         Generate expected outputs.
@@ -303,6 +442,7 @@ async def check_sequence(dut):
     await tb.setup()
     await tb.write_configuration()
     cocotb.fork(tb.write_inputs())
+    latency = cocotb.fork(tb.measure_fft_latency())
 
     fir_tol = 1
     fir_ctr = 0
@@ -346,9 +486,158 @@ async def check_sequence(dut):
 
         await RisingEdge(dut.clk_i)
 
+    # The FFT itself takes about FFT_N clk_i cycles and the transfer
+    # out of the bit-reversal RAM another FFT_N. After that, the 8
+    # bytes per bin are limited by the 60MHz FT clock and the
+    # periodic TXE deassertion from gen_ft_txe.
+    await latency.join()
+    fft_n = 1024
+    tx_cycles = int(fft_n * 8 * (40 / 60) * (505 / 500))
+    latency_max = tx_cycles + 2 * fft_n + fft_n // 2
+    dut._log.info("FFT latency: %d clk_i cycles" % tb.fft_latency)
+    if tb.fft_latency > latency_max:
+        raise TestFailure(
+            (
+                "FFT latency exceeds the limit."
+                " Actual: %d cycles, limit: %d cycles."
+            )
+            % (tb.fft_latency, latency_max)
+        )
+
     # continue after everything checked. Ideally, we should perform
     # the check twice.
     muxout_ctr = 0
     while muxout_ctr < 2:
         await RisingEdge(dut.adf_muxout_i)
         muxout_ctr += 1
+
+
+@cocotb.test()
+async def check_control_channel(dut):
+    """
+    Commands shifted in over JTAG are applied without interface A, in
+    order and only between frames, and none are lost when a frame
+    holds them back for longer than the FIFO can buffer.
+    """
+    tb = TopTb(dut)
+    await tb.setup()
+    dut.ft_rxf_n_i.setimmediatevalue(1)
+    dut.adc_d_i.setimmediatevalue(0)
+    # the first scans bring the write side out of reset
+    await tb.clock_jtag(4)
+    applied = []
+    adf_writes = []
+    cocotb.fork(tb.monitor_control(applied, adf_writes))
+
+    # the configuration that write_configuration sends on interface A
+    adf_regs = [
+        0x788C0000,
+        0x00000001,
+        0x10608052,
+        0x00008043,
+        0x00780084,
+        0x00200085,
+        0x00003E86,
+        0x00037D07,
+    ]
+    registers = [
+        (0x01, 0x00, "use_chan_a_ftclk"),
+        (0x02, 0x01, "use_chan_b_ftclk"),
+        (0x03, 0x00, "out_ftclk"),
+        (0x04, 0x02, "mti_ftclk"),
+    ]
+    commands = [(cmd, val) for cmd, val, _ in registers]
+    commands += [(0x80 | reg, val) for reg, val in enumerate(adf_regs)]
+    commands.append((0x00, 0x00))
+    await tb.write_controls(commands)
+    for _ in range(100):
+        await RisingEdge(dut.ft_clkout_i)
+
+    await ReadOnly()
+    for cmd, val, name in registers:
+        act_val = getattr(dut, name).value.integer
+        if act_val != val:
+            raise TestFailure(
+                (
+                    "Control command 0x%02X not applied."
+                    " %s is %d, expected %d."
+                )
+                % (cmd, name, act_val, val)
+            )
+    exp_adf_writes = list(enumerate(adf_regs))
+    if adf_writes != exp_adf_writes:
+        raise TestFailure(
+            "ADF register writes %s, expected %s." % (adf_writes, exp_adf_writes)
+        )
+
+    # hold back a burst, longer than the FIFO, behind a frame
+    await tb.read_frame()
+    while dut.ft_wr_n_o.value.integer:
+        await FallingEdge(dut.ft_clkout_i)
+    burst = [(0x02, i & 1) for i in range(24)]
+    nresend = await tb.write_controls(burst)
+    if nresend == 0:
+        raise TestFailure("A frame did not hold back the burst.")
+    commands += burst
+
+    # stop, then start again
+    await tb.write_controls([(0xFF, 0x00)])
+    for _ in range(100):
+        await RisingEdge(dut.ft_clkout_i)
+    await ReadOnly()
+    if not dut.ftclk_state.value.integer & 1:
+        raise TestFailure("Stop command did not return to IDLE.")
+    await RisingEdge(dut.ft_clkout_i)
+    await tb.write_controls([(0x00, 0x00)])
+    await tb.read_frame()
+    commands += [(0xFF, 0x00), (0x00, 0x00)]
+
+    if applied != commands:
+        raise TestFailure(
+            "Applied control commands %s, expected %s." % (applied, commands)
+        )
+
+
+@cocotb.test()
+async def check_overflow_trailer(dut):
+    """
+    The frame trailer, between the last sample and the stop flags,
+    holds the number of samples the ADC overflowed on during the sweep.
+    """
+    num_overflows = 100
+    tb = TopTb(dut)
+    await tb.setup()
+    dut.adc_d_i.setimmediatevalue(0)
+    # raw output, so that the sample bytes can never look like flags
+    await tb.write_configuration(0x00)
+    frame = cocotb.fork(tb.read_frame())
+
+    # overflow for a run of cycles well inside the first sweep
+    sample = 3
+    while not (
+        dut.state.value.is_resolvable and dut.state.value.integer == 1 << sample
+    ):
+        await RisingEdge(dut.clk_i)
+    for _ in range(1000):
+        await RisingEdge(dut.clk_i)
+    dut.adc_of_i <= 0x3
+    for _ in range(num_overflows):
+        await RisingEdge(dut.clk_i)
+    dut.adc_of_i <= 0x0
+
+    data = await frame.join()
+    if len(data) <= 2:
+        raise TestFailure(
+            "Frame of %d bytes has no samples before its trailer." % len(data)
+        )
+    trailer = (data[-2] << 8) | data[-1]
+    # the low 14 bits hold the count, and bit 14 the pulse canceller
+    act_overflows = trailer & 0x3FFF
+    if act_overflows != num_overflows or trailer & 0xC000:
+        raise TestFailure(
+            (
+                "Frame trailer does not match the overflows."
+                " Trailer: 0x%04X, expected: 0x%04X."
+            )
+            % (trailer, num_overflows)
+        )
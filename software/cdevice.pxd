@@ -1,7 +1,267 @@
+cdef extern from "src/sweep.h":
+    cdef unsigned int SWEEP_FLAG_INTERFERENCE
+    cdef unsigned int SWEEP_FLAG_OVERFLOW
+    cdef unsigned int SWEEP_FLAG_MTI
+    struct sweep_meta "SweepMeta":
+        unsigned long long seq
+        double time
+        unsigned int flags
+        int interference
+        int overflow
+        double noise_floor
+
+cdef extern from "src/perf.h":
+    struct perf_counts "PerfCounts":
+        unsigned long long bytes
+        unsigned long long cycles
+        unsigned long long instructions
+        unsigned long long cache_misses
+        unsigned long long branch_misses
+    struct Perf:
+        pass
+    Perf *perf_new(int nstages)
+    void perf_free(Perf *perf)
+    void perf_begin(Perf *perf)
+    void perf_end(Perf *perf, int stage, unsigned long long bytes)
+    void perf_read(Perf *perf, int stage, perf_counts *counts)
+
+cdef extern from "src/discovery.h":
+    enum: DISCOVERY_MAX_DEVICES
+    struct fmcw_device_info "FmcwDeviceInfo":
+        char serial[64]
+        char manufacturer[64]
+        char product[64]
+        char path[32]
+        int bus
+        int address
+        unsigned short release
+    int discovery_list(fmcw_device_info *info, int max)
+
+cdef extern from "src/fmcw_plugin.h":
+    cdef int FMCW_SAMPLE_DOUBLE
+    cdef int FMCW_DOMAIN_TIME
+    cdef int FMCW_DOMAIN_SPECTRUM
+    cdef int FMCW_DOMAIN_DB
+    cdef int FMCW_PLUGIN_OK
+    cdef int FMCW_PLUGIN_DROP
+    struct fmcw_format "FmcwFormat":
+        int len
+        int type
+        int domain
+        double spacing
+        double sweep_rate
+
+cdef extern from "src/plugin.h":
+    struct Plugin:
+        pass
+    Plugin *plugin_load(const char *path, const char *args, const fmcw_format *inp, bint resize)
+    void plugin_free(Plugin *plugin)
+    const char *plugin_name(const Plugin *plugin)
+    const fmcw_format *plugin_format(const Plugin *plugin)
+    int plugin_process(Plugin *plugin, void *buf, void **out, sweep_meta *meta)
+
+cdef extern from "src/zone.h":
+    enum: ZONE_LATENCY_BUCKETS
+    struct zone_event "ZoneEvent":
+        int zone
+        int entered
+        int bin
+        double peak
+        sweep_meta meta
+        double latency
+    struct zone_latency "ZoneLatency":
+        unsigned long long count
+        double mean
+        double max
+        unsigned long long hist[ZONE_LATENCY_BUCKETS]
+    struct Zones:
+        pass
+    Zones *zones_new()
+    void zones_free(Zones *zones)
+    int zones_add(Zones *zones, int lo, int hi, double on, double off)
+    void zones_set_cfar(Zones *zones, bint cfar)
+    int zones_eventfd(Zones *zones)
+    int zones_eval(Zones *zones, const double *spec, int len, const sweep_meta *meta)
+    bint zones_pop(Zones *zones, zone_event *ev)
+    void zones_latency(Zones *zones, zone_latency *lat)
+
+cdef extern from "src/noise.h":
+    enum: NOISE_FLOOR_PCT
+    double noise_floor(const double *spec, int len, double pct)
+
+cdef extern from "src/grid.h":
+    struct RangeGrid:
+        pass
+    RangeGrid *grid_new(double start, double step, int len)
+    void grid_free(RangeGrid *grid)
+    bint grid_map(RangeGrid *grid, const double *inp, int nbins, double bin_dist, double *out)
+    int grid_nweights(const RangeGrid *grid)
+
+cdef extern from "src/integrate.h":
+    enum: INTEGRATE_COHERENT
+    enum: INTEGRATE_MAGNITUDE
+    enum: INTEGRATE_POWER
+    struct integrate_meta "IntegrateMeta":
+        unsigned long long first_seq
+        unsigned long long last_seq
+        int nsweeps
+        unsigned int flags
+    struct Integrator:
+        pass
+    Integrator *integrator_new(int mode, int len, bint cplx, int window, int stride)
+    void integrator_free(Integrator *integ)
+    bint integrator_push(Integrator *integ, const double *inp, const sweep_meta *meta)
+    bint integrator_result(Integrator *integ, double *out, integrate_meta *meta)
+    void integrator_reset(Integrator *integ)
+
+cdef extern from "src/accum.h":
+    enum: ACCUM_MAX_HOLD
+    enum: ACCUM_MIN_HOLD
+    enum: ACCUM_EMA
+    struct Accumulator:
+        pass
+    Accumulator *accum_new(int mode, int len, double param)
+    void accum_free(Accumulator *acc)
+    void accum_update(Accumulator *acc, const double *inp, double now)
+    bint accum_trace(const Accumulator *acc, double *out)
+    void accum_reset(Accumulator *acc)
+
+cdef extern from "src/tbd.h":
+    enum: TBD_MAX_DETECTIONS
+    struct tbd_detection "TbdDetection":
+        int bin
+        double rate
+        double score
+    struct tbd_stats "TbdStats":
+        unsigned long long sweeps
+        unsigned long long evaluated
+        unsigned long long deferred
+        unsigned long long over_budget
+        double mean
+        double max
+    struct Tbd:
+        pass
+    Tbd *tbd_new(int len, int window, double max_rate, double threshold, int nthreads, double budget)
+    void tbd_free(Tbd *tbd)
+    int tbd_nrates(const Tbd *tbd)
+    int tbd_process(Tbd *tbd, const double *spec, const sweep_meta *meta, tbd_detection *dets)
+    void c_tbd_stats "tbd_stats"(const Tbd *tbd, tbd_stats *stats)
+
+cdef extern from "src/pool.h":
+    enum: POOL_SWEEP
+    enum: POOL_COMMANDS
+    enum: POOL_DSP
+    enum: POOL_LOG
+    struct pool_stats "PoolStats":
+        size_t used
+        size_t peak
+        unsigned long long allocs
+        unsigned long long fresh
+        unsigned long long failures
+    bint pool_set_budget(size_t budget)
+    size_t pool_budget()
+    size_t pool_carved()
+    void c_pool_stats "pool_stats"(int subsys, pool_stats *stats)
+
+cdef extern from "src/codec.h":
+    enum: CODEC_HEADER_LEN
+    enum: CODEC_FLAG_KEY
+    struct codec_frame "CodecFrame":
+        unsigned char flags
+        int len
+        unsigned int seq
+        unsigned char counter
+        double db_min
+        double db_max
+    struct CodecEncoder:
+        pass
+    struct CodecDecoder:
+        pass
+    size_t codec_max_size(int len)
+    CodecEncoder *codec_encoder_new(int key_interval)
+    void codec_encoder_free(CodecEncoder *enc)
+    size_t codec_encode(CodecEncoder *enc, const double *db, int len, double db_min, double db_max, unsigned int seq, unsigned char *out)
+    void codec_encoder_reset(CodecEncoder *enc)
+    CodecDecoder *codec_decoder_new()
+    void codec_decoder_free(CodecDecoder *dec)
+    size_t codec_peek(const unsigned char *buf, size_t size, codec_frame *frame)
+    int codec_decode(CodecDecoder *dec, const unsigned char *buf, size_t size, double *out, int maxlen, codec_frame *frame)
+
+cdef extern from "src/soak.h":
+    struct soak_sample "SoakSample":
+        unsigned long long rss
+        unsigned long long heap_used
+        unsigned long long heap_free
+        unsigned long long mmap_bytes
+    bint c_soak_sample "soak_sample"(soak_sample *sample)
+
 cdef extern from "src/device.h":
+    enum: FMCW_PERF_NUM_STAGES
+    struct fmcw_stats "FmcwStats":
+        unsigned long long sweeps
+        unsigned long long overflow_sweeps
+        unsigned long long overflow_samples
+        unsigned long long dropped_overflow
+        unsigned long long skipped_bytes
+        unsigned long long resyncs
+        unsigned long long dropped_plugin
+        unsigned long long stalls
+        unsigned long long recover_purge
+        unsigned long long recover_reset
+        unsigned long long recover_reopen
+        unsigned long long recover_failed
+        unsigned long long detaches
+        unsigned long long attaches
+        unsigned long long governor_changes
     bint fmcw_open()
+    bint fmcw_open_serial(const char *serial)
+    bint fmcw_open_emulated(const char *replay_path, double sweep_rate)
+    bint fmcw_set_hotplug(bint enable)
+    bint fmcw_set_control(bint enable)
+    void fmcw_set_profile(bint enable)
+    bint fmcw_get_profile(int stage, perf_counts *counts)
     void fmcw_close()
     bint fmcw_start_acquisition(char *log_path, int sample_bits, int sweep_len, bint fft)
-    int fmcw_read_sweep(int *arr)
+    int fmcw_read_sweep(int *arr, sweep_meta *meta)
     bint fmcw_add_write(int val, int nbytes)
     bint fmcw_write_pending()
+    void fmcw_set_max_overflow(int max_overflow)
+    void fmcw_get_stats(fmcw_stats *stats)
+    void fmcw_set_watchdog(double timeout)
+    bint fmcw_set_governor(double step_time, int min_steps, int max_steps)
+    bint fmcw_add_plugin(const char *path, const char *args, double spacing, double sweep_rate)
+    void fmcw_set_zones(Zones *zones)
+    int fmcw_sweep_eventfd()
+    unsigned long long fmcw_submit_pending()
+    int fmcw_command_eventfd()
+    bint fmcw_pop_command(unsigned long long *id, int *ok)
+
+cdef extern from "src/vibration.h":
+    cdef int VIBRATION_DETREND_NONE
+    cdef int VIBRATION_DETREND_DC
+    cdef int VIBRATION_DETREND_LINEAR
+    struct Vibration:
+        pass
+    Vibration *vibration_new(const int *bins, int nbins, int nwin, double wavelength, double sweep_rate, int detrend)
+    void vibration_free(Vibration *vib)
+    void vibration_push(Vibration *vib, const double *spec, int nspec, const sweep_meta *meta)
+    bint vibration_peak(Vibration *vib, int idx, double *freq, double *amp)
+    double vibration_displacement(Vibration *vib, int idx)
+
+cdef extern from "src/chirp.h":
+    struct Chirp:
+        pass
+    Chirp *chirp_new(const double *pos, int len)
+    void chirp_free(Chirp *chirp)
+    int chirp_len(Chirp *chirp)
+    void chirp_apply(Chirp *chirp, const double *inp, double *out)
+
+cdef extern from "src/interference.h":
+    cdef int INTERFERENCE_ZERO
+    cdef int INTERFERENCE_TAPER
+    cdef int INTERFERENCE_INTERPOLATE
+    struct Interference:
+        pass
+    Interference *interference_new(int len, int win, double threshold, int guard, int mode)
+    void interference_free(Interference *intf)
+    int interference_repair(Interference *intf, double *seq, int len, sweep_meta *meta)
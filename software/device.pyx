@@ -2,15 +2,155 @@
 # cython: c_string_type=str, c_string_encoding=ascii
 
 # cimport numpy as np
+import asyncio
+import os
 import numpy as np
-from typing import List
+from typing import List, Optional, Tuple
 from cdevice cimport (
+    sweep_meta,
+    SWEEP_FLAG_INTERFERENCE,
+    SWEEP_FLAG_OVERFLOW,
+    SWEEP_FLAG_MTI,
+    fmcw_stats,
+    perf_counts,
+    Perf,
+    perf_new as c_perf_new,
+    perf_free as c_perf_free,
+    perf_begin as c_perf_begin,
+    perf_end as c_perf_end,
+    perf_read as c_perf_read,
+    DISCOVERY_MAX_DEVICES,
+    fmcw_device_info,
+    discovery_list as c_discovery_list,
+    FMCW_SAMPLE_DOUBLE,
+    FMCW_DOMAIN_TIME,
+    FMCW_DOMAIN_SPECTRUM,
+    FMCW_DOMAIN_DB,
+    FMCW_PLUGIN_OK,
+    FMCW_PLUGIN_DROP,
+    fmcw_format,
+    Plugin,
+    plugin_load as c_plugin_load,
+    plugin_free as c_plugin_free,
+    plugin_name as c_plugin_name,
+    plugin_format as c_plugin_format,
+    plugin_process as c_plugin_process,
+    ZONE_LATENCY_BUCKETS,
+    zone_event,
+    zone_latency,
+    Zones,
+    zones_new as c_zones_new,
+    zones_free as c_zones_free,
+    zones_add as c_zones_add,
+    zones_set_cfar as c_zones_set_cfar,
+    zones_eventfd as c_zones_eventfd,
+    zones_eval as c_zones_eval,
+    zones_pop as c_zones_pop,
+    zones_latency as c_zones_latency,
+    RangeGrid,
+    grid_new as c_grid_new,
+    grid_free as c_grid_free,
+    grid_map as c_grid_map,
+    grid_nweights as c_grid_nweights,
+    INTEGRATE_COHERENT,
+    INTEGRATE_MAGNITUDE,
+    INTEGRATE_POWER,
+    integrate_meta,
+    Integrator as CIntegrator,
+    integrator_new as c_integrator_new,
+    integrator_free as c_integrator_free,
+    integrator_push as c_integrator_push,
+    integrator_result as c_integrator_result,
+    integrator_reset as c_integrator_reset,
+    ACCUM_MAX_HOLD,
+    ACCUM_MIN_HOLD,
+    ACCUM_EMA,
+    Accumulator as CAccumulator,
+    accum_new as c_accum_new,
+    accum_free as c_accum_free,
+    accum_update as c_accum_update,
+    accum_trace as c_accum_trace,
+    accum_reset as c_accum_reset,
+    TBD_MAX_DETECTIONS,
+    tbd_detection,
+    tbd_stats,
+    Tbd,
+    tbd_new as c_tbd_new,
+    tbd_free as c_tbd_free,
+    tbd_nrates as c_tbd_nrates,
+    tbd_process as c_tbd_process,
+    c_tbd_stats,
+    POOL_SWEEP,
+    POOL_COMMANDS,
+    POOL_DSP,
+    POOL_LOG,
+    pool_stats,
+    pool_set_budget as c_pool_set_budget,
+    pool_budget as c_pool_budget,
+    pool_carved as c_pool_carved,
+    c_pool_stats,
+    CODEC_HEADER_LEN,
+    CODEC_FLAG_KEY,
+    codec_frame,
+    CodecEncoder,
+    CodecDecoder,
+    codec_max_size as c_codec_max_size,
+    codec_encoder_new as c_codec_encoder_new,
+    codec_encoder_free as c_codec_encoder_free,
+    codec_encode as c_codec_encode,
+    codec_encoder_reset as c_codec_encoder_reset,
+    codec_decoder_new as c_codec_decoder_new,
+    codec_decoder_free as c_codec_decoder_free,
+    codec_peek as c_codec_peek,
+    codec_decode as c_codec_decode,
+    NOISE_FLOOR_PCT,
+    noise_floor as c_noise_floor,
+    soak_sample,
+    c_soak_sample,
     fmcw_open as c_fmcw_open,
+    fmcw_open_serial as c_fmcw_open_serial,
+    fmcw_open_emulated as c_fmcw_open_emulated,
+    fmcw_set_hotplug as c_fmcw_set_hotplug,
+    fmcw_set_control as c_fmcw_set_control,
+    FMCW_PERF_NUM_STAGES,
+    fmcw_set_profile as c_fmcw_set_profile,
+    fmcw_get_profile as c_fmcw_get_profile,
     fmcw_close as c_fmcw_close,
     fmcw_start_acquisition as c_fmcw_start_acquisition,
     fmcw_read_sweep as c_fmcw_read_sweep,
     fmcw_add_write as c_fmcw_add_write,
     fmcw_write_pending as c_fmcw_write_pending,
+    fmcw_set_max_overflow as c_fmcw_set_max_overflow,
+    fmcw_get_stats as c_fmcw_get_stats,
+    fmcw_set_watchdog as c_fmcw_set_watchdog,
+    fmcw_set_governor as c_fmcw_set_governor,
+    fmcw_add_plugin as c_fmcw_add_plugin,
+    fmcw_set_zones as c_fmcw_set_zones,
+    fmcw_sweep_eventfd as c_fmcw_sweep_eventfd,
+    fmcw_submit_pending as c_fmcw_submit_pending,
+    fmcw_command_eventfd as c_fmcw_command_eventfd,
+    fmcw_pop_command as c_fmcw_pop_command,
+    Vibration,
+    VIBRATION_DETREND_NONE,
+    VIBRATION_DETREND_DC,
+    VIBRATION_DETREND_LINEAR,
+    vibration_new as c_vibration_new,
+    vibration_free as c_vibration_free,
+    vibration_push as c_vibration_push,
+    vibration_peak as c_vibration_peak,
+    vibration_displacement as c_vibration_displacement,
+    Chirp,
+    chirp_new as c_chirp_new,
+    chirp_free as c_chirp_free,
+    chirp_len as c_chirp_len,
+    chirp_apply as c_chirp_apply,
+    Interference,
+    INTERFERENCE_ZERO,
+    INTERFERENCE_TAPER,
+    INTERFERENCE_INTERPOLATE,
+    interference_new as c_interference_new,
+    interference_free as c_interference_free,
+    interference_repair as c_interference_repair,
 )
 
 def param_mask(length: int) -> int:
@@ -374,15 +514,230 @@ class ADF4158:
         return regs
 
 
+# producer thread stages, in FMCW_PERF_* order
+DEVICE_PROFILE_STAGES = [
+    "parse",
+    "unpack",
+    "magnitude",
+    "log write",
+    "plugins",
+    "noise floor",
+    "zones",
+]
+
+
+cdef dict perf_counts_dict(perf_counts *counts):
+    return {
+        "bytes": counts.bytes,
+        "cycles": counts.cycles,
+        "instructions": counts.instructions,
+        "cache_misses": counts.cache_misses,
+        "branch_misses": counts.branch_misses,
+    }
+
+
+def list_devices() -> List[dict]:
+    """
+    Attached radars. Descriptor strings are empty for boards that
+    cannot be opened, for instance because of permissions.
+    """
+    cdef fmcw_device_info info[DISCOVERY_MAX_DEVICES]
+    ndev = c_discovery_list(info, DISCOVERY_MAX_DEVICES)
+    if ndev < 0:
+        raise RuntimeError("Failed to enumerate USB devices.")
+    devices = []
+    for i in range(min(ndev, DISCOVERY_MAX_DEVICES)):
+        devices.append(
+            {
+                "serial": info[i].serial,
+                "manufacturer": info[i].manufacturer,
+                "product": info[i].product,
+                "path": info[i].path,
+                "bus": info[i].bus,
+                "address": info[i].address,
+                "release": "{:x}.{:02x}".format(
+                    info[i].release >> 8, info[i].release & 0xFF
+                ),
+            }
+        )
+    return devices
+
+
+def noise_floor(
+    double[::1] spec, SweepMeta meta=None, double pct=NOISE_FLOOR_PCT
+) -> float:
+    """
+    Estimate the noise floor of the magnitude spectrum ``spec`` as its
+    ``pct`` percentile, without sorting. The estimate is also stored in
+    ``meta``.
+    """
+    floor = c_noise_floor(&spec[0], len(spec), pct)
+    if meta is not None:
+        meta.meta.noise_floor = floor
+    return floor
+
+
+def memory_sample() -> dict:
+    """
+    Resident set size and malloc heap usage of this process (bytes).
+    """
+    cdef soak_sample sample
+    if not c_soak_sample(&sample):
+        raise RuntimeError("Failed to read process memory usage.")
+    return {
+        "rss": sample.rss,
+        "heap_used": sample.heap_used,
+        "heap_free": sample.heap_free,
+        "mmap_bytes": sample.mmap_bytes,
+    }
+
+
+POOL_SUBSYSTEMS = {
+    "sweep": POOL_SWEEP,
+    "commands": POOL_COMMANDS,
+    "dsp": POOL_DSP,
+    "log": POOL_LOG,
+}
+
+
+def set_memory_budget(nbytes: int):
+    """
+    Draw native buffers from an arena of ``nbytes`` reserved up front,
+    or from malloc if ``nbytes`` is 0. Must be called while no buffers
+    are allocated from a previous arena.
+    """
+    if nbytes < 0:
+        raise ValueError("Memory budget must be non-negative.")
+    if not c_pool_set_budget(nbytes):
+        raise RuntimeError("Failed to set the memory budget.")
+
+
+def memory_stats() -> dict:
+    """
+    Native buffer pool usage: the ``budget`` and bytes ``carved`` from
+    it, and for each subsystem bytes ``used`` and their ``peak``, and
+    counts of ``allocs``, ``fresh`` allocations that could not reuse a
+    freed buffer, and ``failures``.
+    """
+    cdef pool_stats stats
+    subsystems = {}
+    for name, subsys in POOL_SUBSYSTEMS.items():
+        c_pool_stats(subsys, &stats)
+        subsystems[name] = {
+            "used": stats.used,
+            "peak": stats.peak,
+            "allocs": stats.allocs,
+            "fresh": stats.fresh,
+            "failures": stats.failures,
+        }
+    return {
+        "budget": c_pool_budget(),
+        "carved": c_pool_carved(),
+        "subsystems": subsystems,
+    }
+
+
+cdef class SweepMeta:
+    """
+    Metadata accompanying a sweep. Pass an instance to
+    ``Device.read_sweep`` to have it filled in, and on to native
+    processing stages, which may update it.
+    """
+    cdef sweep_meta meta
+
+    @property
+    def seq(self) -> int:
+        """
+        Number of sweeps parsed before this one.
+        """
+        return self.meta.seq
+
+    @property
+    def time(self) -> float:
+        """
+        Monotonic receive time (s).
+        """
+        return self.meta.time
+
+    @property
+    def flags(self) -> int:
+        """
+        """
+        return self.meta.flags
+
+    @property
+    def interference(self) -> int:
+        """
+        Number of samples repaired by the interference stage.
+        """
+        return self.meta.interference
+
+    @property
+    def overflow(self) -> int:
+        """
+        Number of ADC overflows during the sweep.
+        """
+        return self.meta.overflow
+
+    @property
+    def noise_floor(self) -> float:
+        """
+        Noise floor of the sweep's magnitude spectrum, or 0 if it has not
+        been estimated.
+        """
+        return self.meta.noise_floor
+
+    def interference_p(self) -> bool:
+        """
+        True if an interference burst was repaired in this sweep.
+        """
+        return self.meta.flags & SWEEP_FLAG_INTERFERENCE != 0
+
+    def overflow_p(self) -> bool:
+        """
+        True if the ADC overflowed during this sweep.
+        """
+        return self.meta.flags & SWEEP_FLAG_OVERFLOW != 0
+
+    def mti_p(self) -> bool:
+        """
+        True if the gateware pulse canceller removed stationary returns
+        from this sweep.
+        """
+        return self.meta.flags & SWEEP_FLAG_MTI != 0
+
+
 class Device:
     """
     Interface to physical radar.
     """
 
-    def __init__(self):
+    def __init__(
+        self,
+        serial: Optional[str] = None,
+        emulate: bool = False,
+        replay: Optional[str] = None,
+        sweep_rate: float = 0,
+    ):
         """
+        :param serial: Serial number of the radar to open. The first
+            radar found is used if this is None.
+        :param emulate: Generate frames in software instead of opening
+            a radar.
+        :param replay: Path of a log to replay in a loop instead of
+            generated frames. Implies ``emulate``.
+        :param sweep_rate: Emulated sweeps per second, or 0 to emit
+            sweeps as fast as they can be parsed.
         """
-        self._open()
+        if emulate or replay is not None:
+            if replay is None:
+                ok = c_fmcw_open_emulated(NULL, sweep_rate)
+            else:
+                ok = c_fmcw_open_emulated(replay, sweep_rate)
+        else:
+            ok = self._open(serial)
+        if not ok:
+            raise RuntimeError("Failed to open device.")
         self.adf = ADF4158()
 
     def __enter__(self):
@@ -391,8 +746,10 @@ class Device:
     def __exit__(self, exc_type, exc_value, traceback):
         self._close()
 
-    def _open(self):
-        return c_fmcw_open()
+    def _open(self, serial: Optional[str]):
+        if serial is None:
+            return c_fmcw_open()
+        return c_fmcw_open_serial(serial)
 
     def _close(self):
         self._set_stop()
@@ -403,20 +760,175 @@ class Device:
         self._set_start()
         self._write()
         if log_path is None:
-            return c_fmcw_start_acquisition(NULL, sample_bits, sweep_len, fft)
-        return c_fmcw_start_acquisition(log_path, sample_bits, sweep_len, fft)
+            ok = c_fmcw_start_acquisition(NULL, sample_bits, sweep_len, fft)
+        else:
+            ok = c_fmcw_start_acquisition(log_path, sample_bits, sweep_len, fft)
+        if not ok:
+            raise RuntimeError("Failed to start acquisition.")
 
-    def read_sweep(self, sweep_len: int):
-        arr = np.empty(sweep_len, dtype=np.int32)
+    def read_sweep(
+        self, sweep_len: int, SweepMeta meta=None, out: np.ndarray = None
+    ):
+        """
+        Returns the next sweep, or None if there is none. It is read
+        into ``out``, an int32 array of ``sweep_len`` that is reused
+        from sweep to sweep, if given.
+        """
+        if out is None:
+            arr = np.empty(sweep_len, dtype=np.int32)
+        elif len(out) != sweep_len or out.dtype != np.int32:
+            raise ValueError("Sweep buffer must be sweep_len int32 values.")
+        else:
+            arr = out
         # TODO necessary?
         if not arr.flags["C_CONTIGUOUS"]:
             arr = np.ascontiguousarray(arr)
         cdef int[::1] arr_memview = arr
-        ret = c_fmcw_read_sweep(&arr_memview[0])
+        cdef sweep_meta *meta_ptr = NULL
+        if meta is not None:
+            meta_ptr = &meta.meta
+        ret = c_fmcw_read_sweep(&arr_memview[0], meta_ptr)
         if ret:
             return arr
         return None
 
+    def set_max_overflow(self, max_overflow: Optional[int]):
+        """
+        Drop sweeps with more than ``max_overflow`` ADC overflows. None
+        keeps every sweep.
+        """
+        if max_overflow is None:
+            c_fmcw_set_max_overflow(-1)
+        elif max_overflow < 0:
+            raise ValueError("Maximum overflow count must be non-negative.")
+        else:
+            c_fmcw_set_max_overflow(max_overflow)
+
+    def stats(self) -> dict:
+        """
+        Acquisition counters since the last call to
+        ``start_acquisition``.
+        """
+        cdef fmcw_stats stats
+        c_fmcw_get_stats(&stats)
+        return {
+            "sweeps": stats.sweeps,
+            "overflow_sweeps": stats.overflow_sweeps,
+            "overflow_samples": stats.overflow_samples,
+            "dropped_overflow": stats.dropped_overflow,
+            "skipped_bytes": stats.skipped_bytes,
+            "resyncs": stats.resyncs,
+            "dropped_plugin": stats.dropped_plugin,
+            "stalls": stats.stalls,
+            "recover_purge": stats.recover_purge,
+            "recover_reset": stats.recover_reset,
+            "recover_reopen": stats.recover_reopen,
+            "recover_failed": stats.recover_failed,
+            "detaches": stats.detaches,
+            "attaches": stats.attaches,
+            "governor_changes": stats.governor_changes,
+        }
+
+    def set_profile(self, enable: bool):
+        """
+        Count hardware events per host library stage from the next
+        ``start_acquisition``.
+        """
+        c_fmcw_set_profile(enable)
+
+    def profile(self) -> Optional[List[dict]]:
+        """
+        Hardware event totals for each of ``DEVICE_PROFILE_STAGES``, or
+        None if profiling is disabled or unavailable.
+        """
+        cdef perf_counts counts
+        stages = []
+        for stage in range(FMCW_PERF_NUM_STAGES):
+            if not c_fmcw_get_profile(stage, &counts):
+                return None
+            stages.append(perf_counts_dict(&counts))
+        return stages
+
+    def set_hotplug(self, enable: bool):
+        """
+        Follow the radar across unplug and replug, reconfiguring it
+        when it reappears.
+        """
+        if not c_fmcw_set_hotplug(enable):
+            raise RuntimeError("Hotplug is not available for this radar.")
+
+    def set_control(self, enable: bool):
+        """
+        Send commands over the FT2232H's second interface, the FPGA's
+        JTAG port, instead of on the data stream. Call before
+        ``start_acquisition``.
+        """
+        if not c_fmcw_set_control(enable):
+            raise RuntimeError("Could not open the control channel.")
+
+    def set_watchdog(self, timeout: Optional[float]):
+        """
+        Recover the USB link after ``timeout`` seconds without a
+        complete frame. None disables the watchdog.
+        """
+        if timeout is None:
+            c_fmcw_set_watchdog(0)
+        elif timeout <= 0:
+            raise ValueError("Watchdog timeout must be positive.")
+        else:
+            c_fmcw_set_watchdog(timeout)
+
+    def set_governor(self, max_tdelay: Optional[float]):
+        """
+        Lengthen the delay between ramps, up to ``max_tdelay``
+        seconds, when sweeps are dropped because they are not read
+        fast enough, and shorten it again, down to ``adf.tdelay``, when
+        they are read promptly. None disables the governor. Call after
+        setting the ADF registers.
+        """
+        if max_tdelay is None:
+            c_fmcw_set_governor(0, 0, 0)
+            return
+        timer = self.adf.timer
+        min_steps = self.adf.get_param("del_steps")
+        max_steps = min(
+            int(round(max_tdelay / timer, 0)),
+            self.adf._max_param("del_steps"),
+        )
+        if max_steps < min_steps:
+            raise ValueError("Maximum ramp delay is below adf.tdelay.")
+        if not c_fmcw_set_governor(timer, min_steps, max_steps):
+            raise RuntimeError("The governor is not available for this radar.")
+
+    def add_plugin(
+        self,
+        path: str,
+        args: str = "",
+        spacing: float = 0,
+        sweep_rate: float = 0,
+    ):
+        """
+        Run a native plugin on each sweep in the producer thread,
+        before it is read. Takes effect at ``start_acquisition``.
+
+        :param spacing: Sample rate or FFT bin spacing (Hz).
+        :param sweep_rate: Sweeps per second.
+        """
+        if not c_fmcw_add_plugin(path, args, spacing, sweep_rate):
+            raise RuntimeError("Too many sweep plugins.")
+
+    def set_zones(self, ZoneMonitor zones=None):
+        """
+        Evaluate ``zones`` on each FFT sweep in the producer thread, as
+        soon as it arrives. None stops evaluation.
+        """
+        # keep the monitor alive while the library refers to it
+        self._zones = zones
+        if zones is None:
+            c_fmcw_set_zones(NULL)
+        else:
+            c_fmcw_set_zones(zones._zones)
+
     def set_chan(self, chan: str):
         """
         """
@@ -458,6 +970,19 @@ class Device:
         else:
             c_fmcw_add_write(3, 1)
 
+    def set_mti(self, pulses: int):
+        """
+        Cancel stationary returns in the gateware, between the window
+        and the FFT, by subtracting the previous sweep (2 pulses) or
+        the second difference over the previous two sweeps (3
+        pulses). 0 disables the canceller. This applies to WINDOW and
+        FFT output.
+        """
+        if pulses not in [0, 2, 3]:
+            raise ValueError("Pulse canceller must use 0, 2 or 3 pulses.")
+        c_fmcw_add_write(4, 1)
+        c_fmcw_add_write(max(pulses - 1, 0), 1)
+
     def _write(self):
         """
         """
@@ -468,3 +993,953 @@ class Device:
 
     def _set_stop(self):
         c_fmcw_add_write(0xFF, 1)
+
+
+def drain_eventfd(fd: int):
+    """
+    Clear a nonblocking eventfd.
+    """
+    try:
+        os.read(fd, 8)
+    except BlockingIOError:
+        pass
+
+
+class AsyncDevice(Device):
+    """
+    Device for asyncio programs. Sweeps are read with ``async for`` over
+    ``sweeps``, and the command methods are coroutines that return once
+    the radar has accepted the command.
+
+    The host library signals an eventfd when a sweep is ready and
+    another when a command completes, and both are watched with
+    ``loop.add_reader``. Nothing runs in an executor and nothing polls:
+    sweeps and command completions are handled on the event loop as
+    the producer thread delivers them. All methods must be called from
+    the loop's thread.
+    """
+
+    def __init__(self, *args, **kwargs):
+        super().__init__(*args, **kwargs)
+        self._loop = None
+        self._sweep_fd = -1
+        self._command_fd = -1
+        self._sweep_waiter = None
+        self._closed = False
+        # future for each submitted command, by identifier
+        self._commands = {}
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self, exc_type, exc_value, traceback):
+        self._close()
+
+    def _watch(self):
+        """
+        Register the eventfds with the running loop.
+        """
+        if self._closed:
+            raise RuntimeError("Device closed.")
+        if self._loop is not None:
+            return
+        self._sweep_fd = c_fmcw_sweep_eventfd()
+        self._command_fd = c_fmcw_command_eventfd()
+        if self._sweep_fd < 0 or self._command_fd < 0:
+            raise OSError("Failed to create device eventfds.")
+        self._loop = asyncio.get_running_loop()
+        self._loop.add_reader(self._sweep_fd, self._on_sweep)
+        self._loop.add_reader(self._command_fd, self._on_command)
+
+    def _close(self):
+        if self._loop is not None:
+            self._loop.remove_reader(self._sweep_fd)
+            self._loop.remove_reader(self._command_fd)
+            self._loop = None
+        self._closed = True
+        # closing the device discards its completions and eventfds
+        self._on_command()
+        super()._close()
+        self._sweep_fd = -1
+        self._command_fd = -1
+        for fut in self._commands.values():
+            if not fut.done():
+                fut.set_exception(RuntimeError("Device closed."))
+        self._commands = {}
+        # wake the sweep reader to end its iteration
+        if self._sweep_waiter is not None and not self._sweep_waiter.done():
+            self._sweep_waiter.set_result(None)
+
+    def _on_sweep(self):
+        drain_eventfd(self._sweep_fd)
+        if self._sweep_waiter is not None and not self._sweep_waiter.done():
+            self._sweep_waiter.set_result(None)
+
+    def _on_command(self):
+        cdef unsigned long long cid
+        cdef int ok
+        if self._command_fd >= 0:
+            drain_eventfd(self._command_fd)
+        while c_fmcw_pop_command(&cid, &ok):
+            fut = self._commands.pop(cid, None)
+            if fut is None or fut.done():
+                continue
+            if ok:
+                fut.set_result(None)
+            else:
+                fut.set_exception(OSError("Failed to write command."))
+
+    async def submit(self):
+        """
+        Write the queued commands, returning once they are written.
+        """
+        self._watch()
+        cid = c_fmcw_submit_pending()
+        if cid == 0:
+            raise RuntimeError("Too many commands in flight.")
+        fut = self._loop.create_future()
+        self._commands[cid] = fut
+        # commands written synchronously have already completed
+        self._on_command()
+        await fut
+
+    async def set_chan(self, chan: str):
+        """
+        """
+        Device.set_chan(self, chan)
+        await self.submit()
+
+    async def set_adf_regs(self):
+        """
+        """
+        Device.set_adf_regs(self)
+        await self.submit()
+
+    async def set_output(self, output: str):
+        """
+        """
+        Device.set_output(self, output)
+        await self.submit()
+
+    async def set_mti(self, pulses: int):
+        """
+        """
+        Device.set_mti(self, pulses)
+        await self.submit()
+
+    def sweeps(self, sweep_len: int) -> "SweepStream":
+        """
+        Async iterator over (sweep, SweepMeta) pairs, from
+        ``start_acquisition`` until the device is closed.
+        """
+        return SweepStream(self, sweep_len)
+
+    async def _next_sweep(self, sweep_len: int):
+        self._watch()
+        while not self._closed:
+            meta = SweepMeta()
+            # the eventfd counts sweeps that may already have been read,
+            # so try a read before every wait
+            sweep = self.read_sweep(sweep_len, meta)
+            if sweep is not None:
+                return sweep, meta
+            self._sweep_waiter = self._loop.create_future()
+            try:
+                await self._sweep_waiter
+            finally:
+                self._sweep_waiter = None
+        raise StopAsyncIteration
+
+
+class SweepStream:
+    """
+    Sweeps of an ``AsyncDevice``.
+    """
+
+    def __init__(self, device: AsyncDevice, sweep_len: int):
+        self._device = device
+        self._sweep_len = sweep_len
+
+    def __aiter__(self):
+        return self
+
+    async def __anext__(self):
+        return await self._device._next_sweep(self._sweep_len)
+
+
+cdef class Profiler:
+    """
+    Hardware event counters for consecutive processing stages. Must
+    only be used from the thread that created it.
+    """
+    cdef Perf *_perf
+    cdef int _nstages
+
+    def __cinit__(self, nstages: int):
+        """
+        :param nstages: Number of stages.
+        """
+        self._nstages = nstages
+        self._perf = c_perf_new(nstages)
+        if self._perf is NULL:
+            raise RuntimeError("Hardware performance counters are unavailable.")
+
+    def __dealloc__(self):
+        c_perf_free(self._perf)
+
+    def begin(self):
+        """
+        Start attributing counts.
+        """
+        c_perf_begin(self._perf)
+
+    def end(self, stage: int, nbytes: int):
+        """
+        Attribute the counts since the last ``begin`` or ``end`` to
+        ``stage``, which processed ``nbytes`` bytes.
+        """
+        if stage < 0 or stage >= self._nstages:
+            raise IndexError("Invalid profiler stage.")
+        c_perf_end(self._perf, stage, nbytes)
+
+    def counts(self) -> List[dict]:
+        """
+        Hardware event totals for each stage.
+        """
+        cdef perf_counts counts
+        stages = []
+        for stage in range(self._nstages):
+            c_perf_read(self._perf, stage, &counts)
+            stages.append(perf_counts_dict(&counts))
+        return stages
+
+
+# plugin sample domains by name
+PLUGIN_DOMAINS = {
+    "time": FMCW_DOMAIN_TIME,
+    "spectrum": FMCW_DOMAIN_SPECTRUM,
+    "db": FMCW_DOMAIN_DB,
+}
+
+
+cdef class PluginStage:
+    """
+    Native processing plugin (see src/fmcw_plugin.h) run on float64
+    sweeps.
+    """
+    cdef Plugin *_plugin
+    cdef int _in_len
+    cdef int _out_len
+
+    def __cinit__(
+        self,
+        path: str,
+        args: str,
+        sweep_len: int,
+        domain: str,
+        spacing: float,
+        sweep_rate: float,
+        resize: bool = False,
+    ):
+        """
+        :param sweep_len: Samples in each input sweep.
+        :param domain: time, spectrum or db.
+        :param spacing: Sample rate or bin spacing (Hz).
+        :param resize: Allow the plugin to change the sweep length.
+        """
+        cdef fmcw_format fmt
+        fmt.len = sweep_len
+        fmt.type = FMCW_SAMPLE_DOUBLE
+        fmt.domain = PLUGIN_DOMAINS[domain]
+        fmt.spacing = spacing
+        fmt.sweep_rate = sweep_rate
+        self._plugin = c_plugin_load(path, args, &fmt, resize)
+        if self._plugin is NULL:
+            raise RuntimeError("Failed to load plugin {}.".format(path))
+        self._in_len = sweep_len
+        self._out_len = c_plugin_format(self._plugin).len
+
+    def __dealloc__(self):
+        c_plugin_free(self._plugin)
+
+    @property
+    def name(self) -> str:
+        return c_plugin_name(self._plugin)
+
+    def process(self, double[::1] seq, SweepMeta meta=None):
+        """
+        Process ``seq`` (a contiguous float64 array). In-place plugins
+        modify and return ``seq`` itself, others return a new array.
+        Returns None if the plugin drops the sweep.
+        """
+        cdef sweep_meta *meta_ptr = NULL
+        cdef void *out
+        if len(seq) != self._in_len:
+            raise ValueError("Sweep length does not match the plugin.")
+        if meta is not None:
+            meta_ptr = &meta.meta
+        ret = c_plugin_process(self._plugin, &seq[0], &out, meta_ptr)
+        if ret == FMCW_PLUGIN_DROP:
+            return None
+        if ret != FMCW_PLUGIN_OK:
+            raise RuntimeError("Plugin {} failed.".format(self.name))
+        if out == <void *>&seq[0]:
+            return np.asarray(seq)
+        return np.asarray(<double[:self._out_len]> out).copy()
+
+
+cdef class ZoneMonitor:
+    """
+    Range-band detection zones with hysteresis, evaluated natively on
+    magnitude spectra.
+    """
+    cdef Zones *_zones
+
+    def __cinit__(self):
+        self._zones = c_zones_new()
+        if self._zones is NULL:
+            raise MemoryError("Failed to create detection zones.")
+
+    def __dealloc__(self):
+        c_zones_free(self._zones)
+
+    def add_zone(self, lo: int, hi: int, on: float, off: float) -> int:
+        """
+        Add a zone over bins ``lo`` to ``hi`` inclusive, entered when a
+        bin exceeds ``on`` and left when all fall below ``off``.
+        Returns the zone index.
+        """
+        idx = c_zones_add(self._zones, lo, hi, on, off)
+        if idx < 0:
+            raise ValueError("Invalid zone.")
+        return idx
+
+    def set_cfar(self, cfar: bool):
+        """
+        Treat zone thresholds as ratios to each sweep's noise floor.
+        """
+        c_zones_set_cfar(self._zones, cfar)
+
+    def fileno(self) -> int:
+        """
+        An eventfd that is readable while events are pending, for use
+        with select or an event loop.
+        """
+        fd = c_zones_eventfd(self._zones)
+        if fd < 0:
+            raise OSError("Failed to create zone eventfd.")
+        return fd
+
+    def evaluate(self, double[::1] spec, SweepMeta meta=None) -> int:
+        """
+        Evaluate the magnitude spectrum ``spec``. Returns the number of
+        events.
+        """
+        cdef sweep_meta *meta_ptr = NULL
+        if meta is not None:
+            meta_ptr = &meta.meta
+        return c_zones_eval(self._zones, &spec[0], len(spec), meta_ptr)
+
+    def events(self) -> List[dict]:
+        """
+        Remove and return the pending events, oldest first.
+        """
+        cdef zone_event ev
+        cdef SweepMeta meta
+        fd = c_zones_eventfd(self._zones)
+        if fd >= 0:
+            drain_eventfd(fd)
+        events = []
+        while c_zones_pop(self._zones, &ev):
+            meta = SweepMeta()
+            meta.meta = ev.meta
+            events.append(
+                {
+                    "zone": ev.zone,
+                    "entered": bool(ev.entered),
+                    "bin": ev.bin,
+                    "peak": ev.peak,
+                    "latency": ev.latency,
+                    "meta": meta,
+                }
+            )
+        return events
+
+    def latency(self) -> dict:
+        """
+        Stop flag to alert latency (s) over all events, with a
+        histogram of counts below 2, 4, 8, ... us.
+        """
+        cdef zone_latency lat
+        c_zones_latency(self._zones, &lat)
+        return {
+            "count": lat.count,
+            "mean": lat.mean,
+            "max": lat.max,
+            "hist": [lat.hist[i] for i in range(ZONE_LATENCY_BUCKETS)],
+        }
+
+
+cdef class DistanceGrid:
+    """
+    Maps range profiles onto fixed distances with precomputed sparse
+    weights, so that profiles from different waveforms line up. The
+    weights are rebuilt only when the profile length or bin spacing
+    changes.
+    """
+    cdef RangeGrid *_grid
+    cdef readonly int length
+    cdef readonly double start
+    cdef readonly double step
+
+    def __cinit__(self, start: float, step: float, length: int):
+        """
+        :param start: Distance of the first point (m).
+        :param step: Distance between points (m).
+        :param length: Number of points.
+        """
+        self._grid = c_grid_new(start, step, length)
+        if self._grid is NULL:
+            raise ValueError("Invalid distance grid.")
+        self.length = length
+        self.start = start
+        self.step = step
+
+    def __dealloc__(self):
+        c_grid_free(self._grid)
+
+    def map(self, double[::1] profile, double bin_dist) -> np.ndarray:
+        """
+        Resample the magnitude profile ``profile``, whose bins are
+        ``bin_dist`` meters apart, onto the grid.
+        """
+        out = np.empty(self.length, dtype=np.double)
+        cdef double[::1] out_memview = out
+        if not c_grid_map(
+            self._grid, &profile[0], len(profile), bin_dist, &out_memview[0]
+        ):
+            raise MemoryError("Failed to build distance grid weights.")
+        return out
+
+    def distances(self) -> np.ndarray:
+        """
+        Distance of each point (m).
+        """
+        return self.start + self.step * np.arange(self.length)
+
+    def nweights(self) -> int:
+        """
+        """
+        return c_grid_nweights(self._grid)
+
+
+INTEGRATE_MODES = {
+    "coherent": INTEGRATE_COHERENT,
+    "magnitude": INTEGRATE_MAGNITUDE,
+    "power": INTEGRATE_POWER,
+}
+
+
+cdef class Integrator:
+    """
+    Averages spectra over ``window`` sweeps and emits a result every
+    ``stride`` sweeps. Consecutive blocks when ``stride`` equals
+    ``window``, otherwise a sliding window updated in constant time per
+    bin. Coherent integration averages the complex spectra, and
+    magnitude and power integration average ``abs(x)`` and
+    ``abs(x)**2``.
+    """
+    cdef CIntegrator *_integ
+    cdef readonly str mode
+    cdef readonly int length
+    cdef readonly bint cplx
+    cdef readonly int window
+    cdef readonly int stride
+
+    def __cinit__(
+        self, mode: str, length: int, cplx: bool, window: int, stride: int
+    ):
+        """
+        :param mode: coherent, magnitude or power.
+        :param length: Bins per spectrum.
+        :param cplx: Whether spectra are complex. Coherent integration
+            requires complex spectra.
+        """
+        if mode not in INTEGRATE_MODES:
+            raise ValueError("Integration mode must be coherent, magnitude or power.")
+        self._integ = c_integrator_new(
+            INTEGRATE_MODES[mode], length, cplx, window, stride
+        )
+        if self._integ is NULL:
+            raise ValueError("Invalid integration.")
+        self.mode = mode
+        self.length = length
+        self.cplx = cplx
+        self.window = window
+        self.stride = stride
+
+    def __dealloc__(self):
+        c_integrator_free(self._integ)
+
+    def push(self, spec: np.ndarray, SweepMeta meta=None) -> bool:
+        """
+        Add ``spec``, a complex128 array if the integrator is complex
+        and a double array otherwise. Returns True when a result is
+        ready.
+        """
+        cdef double[::1] data
+        if self.cplx:
+            data = np.ascontiguousarray(spec, dtype=np.complex128).view(np.double)
+        else:
+            data = np.ascontiguousarray(spec, dtype=np.double)
+        if len(data) != (2 if self.cplx else 1) * self.length:
+            raise ValueError("Spectrum length does not match the integrator.")
+        if meta is None:
+            return c_integrator_push(self._integ, &data[0], NULL)
+        return c_integrator_push(self._integ, &data[0], &meta.meta)
+
+    def result(self) -> Optional[Tuple[np.ndarray, dict]]:
+        """
+        The mean over the current window, complex for coherent
+        integration, and the sweeps that contributed to it. None if
+        nothing has been pushed since the last block.
+        """
+        cdef integrate_meta meta
+        coherent = self.mode == "coherent"
+        out = np.empty(
+            2 * self.length if coherent else self.length, dtype=np.double
+        )
+        cdef double[::1] out_memview = out
+        if not c_integrator_result(self._integ, &out_memview[0], &meta):
+            return None
+        if coherent:
+            out = out.view(np.complex128)
+        return (
+            out,
+            {
+                "first_seq": meta.first_seq,
+                "last_seq": meta.last_seq,
+                "nsweeps": meta.nsweeps,
+                "flags": meta.flags,
+            },
+        )
+
+    def reset(self):
+        """
+        Forget all sweeps.
+        """
+        c_integrator_reset(self._integ)
+
+
+ACCUM_MODES = {
+    "max": ACCUM_MAX_HOLD,
+    "min": ACCUM_MIN_HOLD,
+    "ema": ACCUM_EMA,
+}
+
+
+cdef class DisplayAccumulator:
+    """
+    A max-hold, min-hold or exponentially averaged trace, updated with
+    every spectrum and read by the plot at its frame rate. ``param`` is
+    the hold decay in units per second (0 holds indefinitely) or the
+    average's time constant in seconds.
+    """
+    cdef CAccumulator *_acc
+    cdef readonly str mode
+    cdef readonly int length
+    cdef readonly double param
+
+    def __cinit__(self, mode: str, length: int, param: float):
+        """
+        :param mode: max, min or ema.
+        :param length: Bins per spectrum.
+        """
+        if mode not in ACCUM_MODES:
+            raise ValueError("Accumulation mode must be max, min or ema.")
+        self._acc = c_accum_new(ACCUM_MODES[mode], length, param)
+        if self._acc is NULL:
+            raise ValueError("Invalid display accumulator.")
+        self.mode = mode
+        self.length = length
+        self.param = param
+
+    def __dealloc__(self):
+        c_accum_free(self._acc)
+
+    def update(self, spec: np.ndarray, now: float):
+        """
+        Add ``spec``, received at ``now`` (s).
+        """
+        cdef double[::1] data = np.ascontiguousarray(spec, dtype=np.double)
+        if len(data) != self.length:
+            raise ValueError("Spectrum length does not match the accumulator.")
+        c_accum_update(self._acc, &data[0], now)
+
+    def trace(self) -> Optional[np.ndarray]:
+        """
+        The accumulated trace, or None before the first update.
+        """
+        out = np.empty(self.length, dtype=np.double)
+        cdef double[::1] out_memview = out
+        if not c_accum_trace(self._acc, &out_memview[0]):
+            return None
+        return out
+
+    def reset(self):
+        """
+        Start over with the next spectrum.
+        """
+        c_accum_reset(self._acc)
+
+
+cdef class TrackBeforeDetect:
+    """
+    Detects faint targets by integrating magnitude spectra along
+    straight range-rate tracks over the last ``window`` sweeps.
+    Hypotheses are evaluated on a pool of ``nthreads`` threads within
+    ``budget`` seconds per sweep (0 for no limit).
+    """
+    cdef Tbd *_tbd
+    cdef readonly int length
+
+    def __cinit__(
+        self,
+        length: int,
+        window: int,
+        max_rate: float,
+        threshold: float,
+        nthreads: int,
+        budget: float,
+    ):
+        """
+        :param length: Bins per spectrum.
+        :param max_rate: Largest range rate searched, in bins per
+            sweep.
+        :param threshold: Mean level along a track, relative to the
+            noise floor, at which it is detected.
+        """
+        self._tbd = c_tbd_new(
+            length, window, max_rate, threshold, nthreads, budget
+        )
+        if self._tbd is NULL:
+            raise ValueError("Invalid track-before-detect configuration.")
+        self.length = length
+
+    def __dealloc__(self):
+        c_tbd_free(self._tbd)
+
+    @property
+    def nrates(self) -> int:
+        """
+        Number of range-rate hypotheses.
+        """
+        return c_tbd_nrates(self._tbd)
+
+    def process(self, spec: np.ndarray, SweepMeta meta=None) -> list:
+        """
+        Add the magnitude spectrum ``spec`` and return the detections,
+        strongest first, as dicts of ``bin``, ``rate`` (bins per
+        sweep) and ``score``.
+        """
+        cdef double[::1] data = np.ascontiguousarray(spec, dtype=np.double)
+        cdef tbd_detection dets[TBD_MAX_DETECTIONS]
+        cdef const sweep_meta *cmeta = NULL
+        cdef int ndets
+        if len(data) != self.length:
+            raise ValueError("Spectrum length does not match the detector.")
+        if meta is not None:
+            cmeta = &meta.meta
+        ndets = c_tbd_process(self._tbd, &data[0], cmeta, dets)
+        return [
+            {"bin": dets[i].bin, "rate": dets[i].rate, "score": dets[i].score}
+            for i in range(ndets)
+        ]
+
+    def stats(self) -> dict:
+        """
+        Processing cost over all sweeps.
+        """
+        cdef tbd_stats stats
+        c_tbd_stats(self._tbd, &stats)
+        return {
+            "sweeps": stats.sweeps,
+            "evaluated": stats.evaluated,
+            "deferred": stats.deferred,
+            "over_budget": stats.over_budget,
+            "mean": stats.mean,
+            "max": stats.max,
+        }
+
+
+PROFILE_HEADER_LEN = CODEC_HEADER_LEN
+
+
+cdef class ProfileEncoder:
+    """
+    Encodes dB range profiles into compact frames for remote displays:
+    8-bit levels within the display's dB range, delta coded against the
+    previous frame and Rice coded. A key frame, decodable on its own,
+    is sent every ``key_interval`` frames.
+    """
+    cdef CodecEncoder *_enc
+
+    def __cinit__(self, key_interval: int):
+        self._enc = c_codec_encoder_new(key_interval)
+        if self._enc is NULL:
+            raise ValueError("Invalid profile encoder.")
+
+    def __dealloc__(self):
+        c_codec_encoder_free(self._enc)
+
+    def encode(
+        self, profile: np.ndarray, db_min: float, db_max: float, seq: int
+    ) -> bytes:
+        """
+        Encode the dB ``profile``, clamped to [``db_min``, ``db_max``],
+        of the sweep numbered ``seq``.
+        """
+        cdef double[::1] data = np.ascontiguousarray(profile, dtype=np.double)
+        cdef int length = len(data)
+        out = bytearray(c_codec_max_size(length))
+        cdef unsigned char[::1] out_memview = out
+        cdef size_t size = c_codec_encode(
+            self._enc,
+            &data[0],
+            length,
+            db_min,
+            db_max,
+            seq & 0xFFFFFFFF,
+            &out_memview[0],
+        )
+        if size == 0:
+            raise ValueError("Profile cannot be encoded.")
+        return bytes(out[:size])
+
+    def reset(self):
+        """
+        Make the next frame a key frame.
+        """
+        c_codec_encoder_reset(self._enc)
+
+
+cdef class ProfileDecoder:
+    """
+    Decodes frames from ``ProfileEncoder``. After a lost frame, delta
+    frames are skipped until the next key frame.
+    """
+    cdef CodecDecoder *_dec
+
+    def __cinit__(self):
+        self._dec = c_codec_decoder_new()
+        if self._dec is NULL:
+            raise MemoryError()
+
+    def __dealloc__(self):
+        c_codec_decoder_free(self._dec)
+
+    @staticmethod
+    def frame_size(header: bytes) -> int:
+        """
+        Size of the frame starting with ``header``, of at least
+        ``PROFILE_HEADER_LEN`` bytes, or 0 if it is not a frame header.
+        """
+        cdef const unsigned char[::1] buf = header
+        cdef codec_frame frame
+        return c_codec_peek(&buf[0], len(buf), &frame)
+
+    def decode(self, data: bytes) -> Optional[Tuple[np.ndarray, dict]]:
+        """
+        The dB profile in the frame ``data`` and its header, or None if
+        it is a delta frame that cannot be decoded yet.
+        """
+        cdef const unsigned char[::1] buf = data
+        cdef codec_frame frame
+        if c_codec_peek(&buf[0], len(buf), &frame) == 0:
+            raise ValueError("Not a profile frame.")
+        out = np.empty(frame.len, dtype=np.double)
+        cdef double[::1] out_memview = out
+        cdef int length = c_codec_decode(
+            self._dec, &buf[0], len(buf), &out_memview[0], frame.len, &frame
+        )
+        if length < 0:
+            raise ValueError("Malformed profile frame.")
+        if length == 0:
+            return None
+        return (
+            out,
+            {
+                "key": bool(frame.flags & CODEC_FLAG_KEY),
+                "seq": frame.seq,
+                "db_min": frame.db_min,
+                "db_max": frame.db_max,
+            },
+        )
+
+
+cdef class VibrationMonitor:
+    """
+    Tracks the sweep-to-sweep phase of a set of range bins and
+    reports the dominant displacement frequency and amplitude of each.
+    """
+    cdef Vibration *_vib
+    cdef int _nbins
+
+    def __cinit__(
+        self,
+        bins: List[int],
+        nwin: int,
+        wavelength: float,
+        sweep_rate: float,
+        detrend: str = "linear",
+    ):
+        """
+        :param bins: Range bins to track.
+        :param nwin: Number of sweeps in the displacement window.
+        :param wavelength: Carrier wavelength (m).
+        :param sweep_rate: Sweep repetition rate (Hz).
+        :param detrend: none, dc or linear.
+        """
+        detrend = detrend.lower()
+        if detrend == "none":
+            c_detrend = VIBRATION_DETREND_NONE
+        elif detrend == "dc":
+            c_detrend = VIBRATION_DETREND_DC
+        elif detrend == "linear":
+            c_detrend = VIBRATION_DETREND_LINEAR
+        else:
+            raise ValueError("Detrend must be none, dc or linear.")
+
+        bins_arr = np.ascontiguousarray(bins, dtype=np.int32)
+        cdef int[::1] bins_memview = bins_arr
+        self._nbins = len(bins_arr)
+        self._vib = c_vibration_new(
+            &bins_memview[0], self._nbins, nwin, wavelength, sweep_rate, c_detrend
+        )
+        if self._vib is NULL:
+            raise MemoryError("Failed to create vibration monitor.")
+
+    def __dealloc__(self):
+        c_vibration_free(self._vib)
+
+    def push(self, spectrum, SweepMeta meta=None):
+        """
+        Add the complex range spectrum of the next sweep. ``meta``
+        supplies its sequence number, so that missing sweeps are
+        filled in rather than shortening the window.
+        """
+        spec = np.ascontiguousarray(spectrum, dtype=np.complex128).view(np.float64)
+        cdef double[::1] spec_memview = spec
+        if meta is None:
+            c_vibration_push(self._vib, &spec_memview[0], len(spec) // 2, NULL)
+        else:
+            c_vibration_push(self._vib, &spec_memview[0], len(spec) // 2, &meta.meta)
+
+    def peaks(self) -> List[Optional[Tuple[float, float]]]:
+        """
+        (frequency (Hz), amplitude (m)) for each tracked bin, or None
+        if the displacement window is not yet full.
+        """
+        cdef double freq
+        cdef double amp
+        ret = []
+        for i in range(self._nbins):
+            if c_vibration_peak(self._vib, i, &freq, &amp):
+                ret.append((freq, amp))
+            else:
+                ret.append(None)
+        return ret
+
+    def displacements(self) -> List[float]:
+        """
+        Latest displacement (m) of each tracked bin.
+        """
+        return [c_vibration_displacement(self._vib, i) for i in range(self._nbins)]
+
+
+cdef class ChirpCorrector:
+    """
+    Resamples each sweep onto a linear frequency ramp using a
+    precomputed interpolation table.
+    """
+    cdef Chirp *_chirp
+
+    def __cinit__(self, positions):
+        """
+        :param positions: Fractional input sample position for each
+            output sample (see ``fit_chirp_positions`` in fmcw.py).
+        """
+        pos = np.ascontiguousarray(positions, dtype=np.double)
+        cdef double[::1] pos_memview = pos
+        self._chirp = c_chirp_new(&pos_memview[0], len(pos))
+        if self._chirp is NULL:
+            raise MemoryError("Failed to create chirp correction table.")
+
+    def __dealloc__(self):
+        c_chirp_free(self._chirp)
+
+    def __len__(self):
+        return c_chirp_len(self._chirp)
+
+    def apply(self, seq):
+        """
+        Return the linearized copy of ``seq``.
+        """
+        inp = np.ascontiguousarray(seq, dtype=np.double)
+        if len(inp) != c_chirp_len(self._chirp):
+            raise ValueError("Sweep length does not match chirp correction table.")
+        out = np.empty_like(inp)
+        cdef double[::1] in_memview = inp
+        cdef double[::1] out_memview = out
+        c_chirp_apply(self._chirp, &in_memview[0], &out_memview[0])
+        return out
+
+
+cdef class InterferenceRepair:
+    """
+    Detects interference bursts in time-domain sweeps and repairs them
+    in place.
+    """
+    cdef Interference *_intf
+
+    def __cinit__(
+        self,
+        sweep_len: int,
+        win: int,
+        threshold: float,
+        guard: int,
+        mode: str = "taper",
+    ):
+        """
+        :param sweep_len: Maximum sweep length.
+        :param win: Sliding power window length (samples).
+        :param threshold: Window power, relative to the sweep power,
+            above which a burst is detected.
+        :param guard: Samples repaired on either side of a burst.
+        :param mode: zero, taper or interpolate.
+        """
+        mode = mode.lower()
+        if mode == "zero":
+            c_mode = INTERFERENCE_ZERO
+        elif mode == "taper":
+            c_mode = INTERFERENCE_TAPER
+        elif mode == "interpolate":
+            c_mode = INTERFERENCE_INTERPOLATE
+        else:
+            raise ValueError("Mode must be zero, taper or interpolate.")
+        self._intf = c_interference_new(sweep_len, win, threshold, guard, c_mode)
+        if self._intf is NULL:
+            raise MemoryError("Failed to create interference stage.")
+
+    def __dealloc__(self):
+        c_interference_free(self._intf)
+
+    def repair(self, double[::1] seq, SweepMeta meta=None) -> int:
+        """
+        Repair ``seq`` (a contiguous float64 array) in place. Returns
+        the number of repaired samples.
+        """
+        cdef sweep_meta *meta_ptr = NULL
+        if meta is not None:
+            meta_ptr = &meta.meta
+        return c_interference_repair(self._intf, &seq[0], len(seq), meta_ptr)
@@ -1,19 +1,45 @@
 #!/usr/bin/env python
 from __future__ import annotations
-from time import clock_gettime, CLOCK_MONOTONIC
+from time import clock_gettime, CLOCK_MONOTONIC, process_time
+import os
+import csv
+import itertools
 import sys
 from enum import IntEnum, auto
-from typing import Union, Optional, Callable, List, Tuple
+from typing import Union, Optional, Callable, List, Tuple, Iterator
 from pathlib import Path
 from shutil import rmtree
 from multiprocessing import Process, Pipe
 from multiprocessing.connection import Connection
 from queue import Queue
+from threading import Thread, Condition
 import numpy as np
 from pyqtgraph.Qt import QtGui
 import pyqtgraph as pg
-from scipy import signal
-from device import Device
+from scipy import signal, stats as sstats
+from device import (
+    Device,
+    DEVICE_PROFILE_STAGES,
+    list_devices,
+    memory_sample,
+    memory_stats,
+    set_memory_budget,
+    PluginStage,
+    Profiler,
+    SweepMeta,
+    VibrationMonitor,
+    ChirpCorrector,
+    InterferenceRepair,
+    ZoneMonitor,
+    DistanceGrid,
+    Integrator,
+    DisplayAccumulator,
+    TrackBeforeDetect,
+    PROFILE_HEADER_LEN,
+    ProfileEncoder,
+    ProfileDecoder,
+    noise_floor,
+)
 
 BITMODE_SYNCFF = 0x40
 CHUNKSIZE = 0x10000
@@ -41,7 +67,99 @@ HIST_RANGE = 3000
 # dB min and max if no other value is set
 DB_MIN = -180
 DB_MAX = 0
+# spectrum plot redraws per second while display accumulators are on
+PLOT_FRAME_RATE = 30
+# pen of each display accumulator trace, and the time constant (s) of
+# an exponential average given without one
+DISPLAY_HOLD_PENS = {"max": "r", "min": "c", "ema": "g"}
+DISPLAY_HOLD_EMA_TAU = 1.0
+# fraction of the sweep period track-before-detect may spend per sweep,
+# and its thread pool, which leaves a core for acquisition
+TBD_BUDGET = 0.5
+TBD_THREADS = max(1, (os.cpu_count() or 1) - 1)
+# a track is reported when no track was detected within this many bins
+# on the previous sweep
+TBD_REPORT_BINS = 2
+# frames between key frames of the profile stream
+STREAM_KEY_INTERVAL = 64
 DIST_INIT = 235
+# number of sweeps in the vibration monitor displacement window
+VIBRATION_WINDOW = 256
+# polynomial order of the fitted beat phase used for chirp calibration
+CHIRP_FIT_ORDER = 7
+# beat-frequency band (in bins) kept around the calibration reflector
+CHIRP_FIT_HALFWIDTH = 20
+# sliding power window (samples) for interference burst detection
+INTERFERENCE_WINDOW = 16
+# window power, relative to the sweep power, that indicates a burst
+INTERFERENCE_THRESHOLD = 16
+# samples repaired on either side of a detected burst
+INTERFERENCE_GUARD = 32
+# sweeps between covariance snapshots handed to the super-resolution
+# worker
+SUPERRES_BATCH = 16
+# forgetting factor of the incrementally updated window covariance
+SUPERRES_FORGET = 0.95
+# MUSIC pseudo-spectrum points per FFT bin
+SUPERRES_GRID = 16
+SUPERRES_METHODS = ["music", "esprit"]
+# Proc stages reported by the profiler. FIR through FFT follow the
+# Data order so that the processing chain can index them directly.
+PROC_PROFILE_STAGES = [
+    "interference",
+    "chirp",
+    "fir",
+    "decimate",
+    "window",
+    "fft",
+    "integrate",
+    "dB",
+    "tbd",
+]
+PROC_STAGE_INTERFERENCE = 0
+PROC_STAGE_CHIRP = 1
+PROC_STAGE_FIR = 2
+PROC_STAGE_FFT = 5
+PROC_STAGE_INTEGRATE = 6
+PROC_STAGE_DB = 7
+PROC_STAGE_TBD = 8
+# default gap (dB) between a zone's on and off thresholds
+ZONE_HYSTERESIS_DB = 3
+ZONE_THRESHOLDS = ["dBFS", "cfar"]
+# With an auto dB range, the display starts this far below the noise
+# floor...
+AUTO_DB_BELOW = 10
+# ...and is only moved once the smoothed floor has drifted this far.
+AUTO_DB_STEP = 3
+# weight of the previous value in the smoothed noise floor
+AUTO_DB_SMOOTH = 0.9
+# pipeline points at which native plugins can be inserted, in order
+PLUGIN_POINTS = ["sweep", "input", "output"]
+# significance level at which a soak test metric is reported as drifting
+SOAK_DRIFT_P = 0.01
+# fewest soak samples needed to test for drift
+SOAK_MIN_SAMPLES = 8
+# latency percentiles reported for each soak sample
+SOAK_PERCENTILES = [50, 99]
+# result key, column heading and scale of each bench metric, with the
+# CPU cycles per delivered sweep of every profiled stage last
+BENCH_METRICS = [
+    ("sweep_rate", "sweeps/s set", 1),
+    ("achieved_rate", "sweeps/s", 1),
+    ("usb_mbps", "USB MB/s", 1),
+    ("dropped", "dropped", 1),
+    ("cpu", "CPU %", 100),
+] + [
+    ("latency_p{}".format(pct), "latency p{} ms".format(pct), 1e3)
+    for pct in SOAK_PERCENTILES
+] + [
+    (stage, "{} cycles/sweep".format(stage), 1)
+    for stage in DEVICE_PROFILE_STAGES + PROC_PROFILE_STAGES
+]
+BENCH_COLUMNS = [heading for _, heading, _ in BENCH_METRICS]
+# bench grid key choosing the radar, and its values
+BENCH_RADAR = "radar"
+BENCH_RADARS = ["hardware", "emulated"]
 
 
 def dist_to_freq(dist: float, bw: float, ts: float) -> float:
@@ -284,6 +402,474 @@ def avg_value(avg: float) -> str:
     return "Average Value : {:.2f}".format(avg)
 
 
+def interference_report(nflagged: int, nsweep: int) -> str:
+    """
+    :param nflagged: Number of sweeps with repaired interference.
+    :param nsweep: Total number of processed sweeps.
+    """
+    pct = 0
+    if nsweep:
+        pct = 100 * nflagged / nsweep
+    return "Interference  : {} sweeps ({:.2f}%)".format(nflagged, pct)
+
+
+def overflow_report(stats: dict) -> str:
+    """
+    :param stats: Acquisition counters from ``Device.stats``.
+    """
+    pct = 0
+    if stats["sweeps"]:
+        pct = 100 * stats["overflow_sweeps"] / stats["sweeps"]
+    return (
+        "ADC Overflow  : {} sweeps ({:.2f}%), {} samples, {} dropped".format(
+            stats["overflow_sweeps"],
+            pct,
+            stats["overflow_samples"],
+            stats["dropped_overflow"],
+        )
+    )
+
+
+def profile_report(stages: List[str], counts: List[dict]) -> str:
+    """
+    :param stages: Stage names.
+    :param counts: Hardware event totals for each stage.
+    """
+    report = ""
+    for stage, count in zip(stages, counts):
+        if not count["cycles"]:
+            continue
+        cpb = count["cycles"] / count["bytes"] if count["bytes"] else 0
+        report += (
+            "Profile {:<12}: {:>8.2f} cycles/B, IPC {:.2f}, "
+            "{} cache misses, {} branch misses\n".format(
+                stage,
+                cpb,
+                count["instructions"] / count["cycles"],
+                count["cache_misses"],
+                count["branch_misses"],
+            )
+        )
+    return report
+
+
+def recovery_report(stats: dict) -> str:
+    """
+    :param stats: Acquisition counters from ``Device.stats``.
+    """
+    return (
+        "USB Recovery  : {} stalls, {} purge, {} reset, {} reopen, "
+        "{} failed, {} unplugged, {} replugged".format(
+            stats["stalls"],
+            stats["recover_purge"],
+            stats["recover_reset"],
+            stats["recover_reopen"],
+            stats["recover_failed"],
+            stats["detaches"],
+            stats["attaches"],
+        )
+    )
+
+
+def devices_report(devices: List[dict]) -> str:
+    """
+    :param devices: Attached radars from ``list_devices``.
+    """
+    if not devices:
+        return "No radars attached.\n"
+    report = ""
+    for dev in devices:
+        report += "{:<12} {:<10} {} {} (release {})\n".format(
+            dev["serial"] or "(no serial)",
+            dev["path"],
+            dev["manufacturer"],
+            dev["product"],
+            dev["release"],
+        )
+    return report
+
+
+def drift_test(vals: List[float]) -> Tuple[float, float]:
+    """
+    Mann-Kendall test for a monotonic trend in equally spaced samples.
+
+    :param vals: Samples in time order.
+    :returns: Theil-Sen slope per sample and the two-sided p-value.
+    """
+    idx = np.arange(len(vals))
+    _, pval = sstats.kendalltau(idx, vals)
+    slope = sstats.theilslopes(vals, idx)[0]
+    return slope, pval
+
+
+def soak_report(
+    samples: List[dict], interval: float, metrics: List[Tuple[str, str, float]]
+) -> str:
+    """
+    :param samples: Periodic samples from ``SoakMonitor``.
+    :param interval: Time between samples (s).
+    :param metrics: Key, unit and display scale of each reported metric.
+    """
+    report = "Soak samples  : {} every {} s\n".format(len(samples), interval)
+    for key, unit, scale in metrics:
+        vals = [sample[key] for sample in samples if sample[key] is not None]
+        if not vals:
+            continue
+        line = "{:<13} : {:.3f} -> {:.3f} {}".format(
+            key, vals[0] * scale, vals[-1] * scale, unit
+        )
+        if len(vals) >= SOAK_MIN_SAMPLES:
+            slope, pval = drift_test(vals)
+            drift = (
+                "DRIFT " if pval < SOAK_DRIFT_P and slope > 0 else ""
+            )
+            line += " ({}{:+.3g} {}/h, p={:.2g})".format(
+                drift, slope * scale * 3600 / interval, unit, pval
+            )
+        report += line + "\n"
+    return report
+
+
+def zone_event_report(event: dict, dists: List[Tuple[float, float]]) -> str:
+    """
+    :param event: Event from ``ZoneMonitor.events``.
+    :param dists: Distance range of each zone.
+    """
+    lo, hi = dists[event["zone"]]
+    return "Zone {} ({}-{} m) {} at sweep {} ({:.1f} us)".format(
+        event["zone"],
+        lo,
+        hi,
+        "entered" if event["entered"] else "cleared",
+        event["meta"].seq,
+        event["latency"] * 1e6,
+    )
+
+
+def zone_latency_report(latency: dict) -> str:
+    """
+    :param latency: Latency statistics from ``ZoneMonitor.latency``.
+    """
+    if not latency["count"]:
+        return "Zone alerts   : 0"
+    pcts = []
+    for pct in [50, 99]:
+        rank = pct / 100 * latency["count"]
+        seen = 0
+        for i, count in enumerate(latency["hist"]):
+            seen += count
+            if seen >= rank:
+                pcts.append(2 ** (i + 1))
+                break
+    return (
+        "Zone alerts   : {} (latency mean {:.1f} us, max {:.1f} us, "
+        "p50 < {} us, p99 < {} us)".format(
+            latency["count"],
+            latency["mean"] * 1e6,
+            latency["max"] * 1e6,
+            pcts[0],
+            pcts[1],
+        )
+    )
+
+
+def read_profile_stream(stream) -> Iterator[Tuple[np.array, dict]]:
+    """
+    Decode the frames written to a profile stream, skipping delta
+    frames until the first key frame.
+
+    :param stream: Binary file object, e.g. a file, pipe or socket
+        file opened for reading.
+    """
+    decoder = ProfileDecoder()
+    while True:
+        header = stream.read(PROFILE_HEADER_LEN)
+        if len(header) < PROFILE_HEADER_LEN:
+            return
+        size = ProfileDecoder.frame_size(header)
+        if size == 0:
+            raise ValueError("Profile stream is corrupt.")
+        frame = header + stream.read(size - PROFILE_HEADER_LEN)
+        if len(frame) < size:
+            return
+        decoded = decoder.decode(frame)
+        if decoded is not None:
+            yield decoded
+
+
+def profile_stream_report(nframes: int, nbytes: int, nbins: int) -> str:
+    """
+    :param nbins: Total bins encoded.
+    """
+    if not nframes:
+        return "Profile stream: 0 frames"
+    return "Profile stream: {} frames, {:.0f} bytes/frame ({:.2f} bits/bin)".format(
+        nframes, nbytes / nframes, 8 * nbytes / nbins
+    )
+
+
+def memory_report(stats: dict) -> str:
+    """
+    :param stats: Statistics from ``memory_stats``.
+    """
+    if stats["budget"]:
+        report = "Memory pool   : {:.1f} of {:.1f} MiB carved\n".format(
+            stats["carved"] / 2 ** 20, stats["budget"] / 2 ** 20
+        )
+    else:
+        report = "Memory pool   : no budget\n"
+    for name, sub in stats["subsystems"].items():
+        report += (
+            "  {:<11} : {:.1f} KiB in use, {:.1f} KiB peak, "
+            "{} allocations ({} fresh, {} failed)\n".format(
+                name,
+                sub["used"] / 2 ** 10,
+                sub["peak"] / 2 ** 10,
+                sub["allocs"],
+                sub["fresh"],
+                sub["failures"],
+            )
+        )
+    return report
+
+
+def parse_bench_grid(text: str) -> Tuple[List[Tuple[str, List[str]]], bool]:
+    """
+    Parse a bench grid. Each line holds a parameter name and the values
+    to try, as they would be typed at the set prompt, separated by
+    ``|``, e.g.
+
+        FPGA output: raw | fft
+        ADF delay time (s): 2e-3 | 1e-3 | 5e-4
+
+    Text after ``#`` is ignored. The special line ``radar: emulated``
+    runs every point against an emulated radar, at the configured sweep
+    rate, instead of the attached hardware.
+
+    Returns each parameter name with its values, and whether the radar
+    is emulated.
+    """
+    grid = []
+    emulate = False
+    for lineno, line in enumerate(text.splitlines(), 1):
+        line = line.split("#", 1)[0].strip()
+        if not line:
+            continue
+        name, sep, vals = line.partition(":")
+        values = [val.strip() for val in vals.split("|")]
+        if not sep or not name.strip() or not all(values):
+            raise ValueError(
+                "line {}: expected 'name: v1 | v2'".format(lineno)
+            )
+        if name.strip() == BENCH_RADAR:
+            if len(values) != 1 or values[0] not in BENCH_RADARS:
+                raise ValueError(
+                    "line {}: radar must be one of {}".format(
+                        lineno, " or ".join(BENCH_RADARS)
+                    )
+                )
+            emulate = values[0] == "emulated"
+            continue
+        grid.append((name.strip(), values))
+    if not grid:
+        raise ValueError("no parameters to vary")
+    return grid, emulate
+
+
+def bench_row(result: Optional[dict]) -> List[str]:
+    """
+    :param result: Results returned by ``Shell.run``, or None for a
+        point that was not run.
+
+    Returns the values of ``BENCH_COLUMNS``, empty where not measured.
+    """
+    row = []
+    for key, _, scale in BENCH_METRICS:
+        val = None if result is None else result[key]
+        row.append("" if val is None else "{:.6g}".format(val * scale))
+    return row
+
+
+def bench_report(names: List[str], rows: List[List[str]]) -> str:
+    """
+    :param names: Names of the varied parameters.
+    :param rows: The bench results, one row per grid point.
+
+    Returns a table of the varied parameters and the metrics measured
+    at any point.
+    """
+    headings = names + BENCH_COLUMNS
+    cols = [
+        i
+        for i in range(len(headings))
+        if i < len(names) or any(row[i] for row in rows)
+    ]
+    widths = {
+        i: max(len(str(row[i])) for row in rows + [headings]) for i in cols
+    }
+    report = ""
+    for row in [headings] + rows:
+        report += (
+            "  ".join("{:>{}}".format(row[i], widths[i]) for i in cols)
+            + "\n"
+        )
+    return report
+
+
+def tbd_report(
+    det: dict, seq: int, bin_dist: float, sweep_rate: float
+) -> str:
+    """
+    :param det: Detection from ``TrackBeforeDetect.process``.
+    :param bin_dist: Distance (m) per spectrum bin.
+    """
+    return "Track at {:.2f} m, {:+.2f} m/s ({:.1f} dB) at sweep {}".format(
+        det["bin"] * bin_dist,
+        det["rate"] * bin_dist * sweep_rate,
+        20 * np.log10(det["score"]),
+        seq,
+    )
+
+
+def tbd_stats_report(stats: dict, nrates: int) -> str:
+    """
+    :param stats: Statistics from ``TrackBeforeDetect.stats``.
+    :param nrates: Number of range-rate hypotheses.
+    """
+    return (
+        "Track search  : {} hypotheses/sweep, {:.1f} us mean, "
+        "{:.1f} us max, {} sweeps over budget ({} hypotheses deferred)".format(
+            nrates,
+            stats["mean"] * 1e6,
+            stats["max"] * 1e6,
+            stats["over_budget"],
+            stats["deferred"],
+        )
+    )
+
+
+def music_freqs(vecs: np.array, ntargets: int, npoints: int) -> np.array:
+    """
+    Frequencies (cycles/sample) of the ``ntargets`` largest MUSIC
+    pseudo-spectrum peaks.
+
+    :param vecs: Covariance eigenvectors, in ascending eigenvalue order.
+    :param npoints: Pseudo-spectrum points over one cycle/sample.
+    """
+    dim = len(vecs)
+    noise = vecs[:, : dim - ntargets]
+    freqs = np.arange(npoints) / npoints
+    steer = np.exp(2j * np.pi * np.outer(np.arange(dim), freqs))
+    pseudo = 1 / np.sum(np.abs(noise.conj().T @ steer) ** 2, axis=0)
+    # the grid is circular, so pad it to find peaks at either end
+    peaks, _ = signal.find_peaks(
+        np.concatenate([pseudo[-1:], pseudo, pseudo[:1]])
+    )
+    peaks -= 1
+    best = peaks[np.argsort(pseudo[peaks])[::-1][:ntargets]]
+    return np.sort(freqs[best])
+
+
+def esprit_freqs(vecs: np.array, ntargets: int) -> np.array:
+    """
+    Frequencies (cycles/sample) from the rotation between the shifted
+    halves of the signal subspace.
+
+    :param vecs: Covariance eigenvectors, in ascending eigenvalue order.
+    """
+    sig = vecs[:, len(vecs) - ntargets :]
+    rot = np.linalg.lstsq(sig[:-1], sig[1:], rcond=None)[0]
+    return np.sort(
+        np.mod(np.angle(np.linalg.eigvals(rot)) / (2 * np.pi), 1)
+    )
+
+
+def superres_report(
+    dists: List[Tuple[float, float]],
+    estimates: List[Optional[np.array]],
+    stats: List[dict],
+    bin_dist: float,
+    sweep_rate: float,
+) -> str:
+    """
+    :param dists: Distance range of each window (m).
+    :param estimates: Latest target bins in each window, or None if no
+        solve completed.
+    :param stats: Throughput of each window from
+        ``SuperResolution.stats``.
+    :param bin_dist: Distance spanned by one FFT bin (m).
+    :param sweep_rate: Sweeps per second.
+    """
+    report = ""
+    for (lo, hi), bins, stat in zip(dists, estimates, stats):
+        report += "Super-res {:>6.2f}-{:<6.2f}m: ".format(lo, hi)
+        if bins is None:
+            report += "no solves\n"
+            continue
+        report += ", ".join(["{:.3f}m".format(b * bin_dist) for b in bins])
+        solved = stat["solves"] * SUPERRES_BATCH
+        report += (
+            "\n    {} solves ({:.1f}/s, mean {:.2f} ms), {} batches "
+            "superseded, {:.0f}% of {:.0f} sweeps/s solved\n".format(
+                stat["solves"],
+                stat["solves"] / stat["elapsed"],
+                stat["solve_time"] / stat["solves"] * 1e3,
+                stat["skipped"],
+                min(100, solved / stat["elapsed"] / sweep_rate * 100),
+                sweep_rate,
+            )
+        )
+    return report
+
+
+def vibration_report(
+    dists: List[float], peaks: List[Optional[Tuple[float, float]]]
+) -> str:
+    """
+    :param dists: Monitored distances (m).
+    :param peaks: (frequency, amplitude) for each distance, or None
+        if too few sweeps were captured.
+    """
+    report = ""
+    for dist, peak in zip(dists, peaks):
+        if peak is None:
+            report += "Vibration {:>7.2f}m : insufficient sweeps\n".format(dist)
+        else:
+            report += "Vibration {:>7.2f}m : {:.2f} Hz, {:.3e} m\n".format(
+                dist, peak[0], peak[1]
+            )
+    return report
+
+
+def fit_chirp_positions(seq: np.array) -> np.array:
+    """
+    Fit the chirp nonlinearity from a sweep dominated by a single
+    reflector.  The reflector's beat tone is isolated in the frequency
+    domain to form its analytic signal, whose unwrapped phase is fit
+    with a polynomial.  A linear ramp produces a linear beat phase, so
+    the fractional sample position at which the fitted phase reaches
+    each uniformly-spaced phase value is where that output sample
+    should be taken.
+
+    :param seq: Time-domain sweep.
+    :returns: Input sample position for each output sample.
+    """
+    nsample = len(seq)
+    spec = np.fft.fft(seq - np.mean(seq))
+    peak = np.argmax(np.abs(spec[1 : nsample // 2])) + 1
+    lower = max(1, peak - CHIRP_FIT_HALFWIDTH)
+    upper = min(nsample // 2, peak + CHIRP_FIT_HALFWIDTH + 1)
+    analytic = np.zeros(nsample, dtype=np.complex128)
+    analytic[lower:upper] = spec[lower:upper]
+    phase = np.unwrap(np.angle(np.fft.ifft(analytic)))
+
+    idx = np.arange(nsample)
+    norm_idx = idx / (nsample - 1)
+    fit = np.polyval(np.polyfit(norm_idx, phase, CHIRP_FIT_ORDER), norm_idx)
+    target = np.linspace(fit[0], fit[-1], nsample)
+    return np.interp(target, fit, idx)
+
+
 def sweep_total_bytes(fpga_output: Data) -> int:
     """
     """
@@ -294,7 +880,8 @@ def sweep_total_bytes(fpga_output: Data) -> int:
     sample_bytes = data_nbytes(sample_bits)
     sweep_len = data_sweep_len(fpga_output)
     flag_bytes = data_nflags(fpga_output)
-    return sample_bytes * sweep_len + 2 * flag_bytes
+    # the overflow trailer occupies one sample
+    return sample_bytes * (sweep_len + 1) + 2 * flag_bytes
 
 
 class PlotType(IntEnum):
@@ -341,8 +928,13 @@ class Plot:
         self.min_axis_val = None
         # maximum axis value for spectrum and hist plots
         self.max_axis_val = None
+        # axis value at data bin 0
+        self.axis_origin = 0
         # records saved plot number
         self._fname = 0
+        # DisplayAccumulators drawn over the spectrum plot
+        self.accumulators = []
+        self._last_render = None
 
     @property
     def ptype(self) -> PlotType:
@@ -392,6 +984,7 @@ class Plot:
         """
         """
         self._fname = 0
+        self._last_render = None
         if self._ptype == PlotType.TIME:
             self._data = np.zeros(data_sweep_len(self._output))
             self._initialize_time_plot()
@@ -450,6 +1043,19 @@ class Plot:
         # TODO available in v0.11 (I think this is the correct method)
         # hist_widget.region.setSpan([self.db_min, self.db_max])
 
+    def set_db_range(self, db_min: float, db_max: float) -> None:
+        """
+        Move the displayed dB range of an initialized plot.
+        """
+        self.db_min = db_min
+        self.db_max = db_max
+        if self._ptype == PlotType.SPECTRUM:
+            self._plt.setYRange(self.db_min, self.db_max)
+        elif self._ptype == PlotType.HIST:
+            self._imv.setLevels(self.db_min, self.db_max)
+            hist_widget = self._imv.getHistogramWidget()
+            hist_widget.region.setBounds([self.db_min, self.db_max])
+
     def _close_plot(self) -> None:
         """
         """
@@ -479,11 +1085,21 @@ class Plot:
     def _add_spectrum_sweep(self, sweep: np.array) -> None:
         """
         """
-        self._plt.plot(
-            np.linspace(0, self._data.shape[0] - 1, self._data.shape[0]),
-            sweep,
-            clear=True,
-        )
+        xvals = np.linspace(0, self._data.shape[0] - 1, self._data.shape[0])
+        if self.accumulators:
+            # every sweep reaches the traces, but only frames are drawn
+            now = clock_gettime(CLOCK_MONOTONIC)
+            for acc in self.accumulators:
+                acc.update(sweep, now)
+            if (
+                self._last_render is not None
+                and now - self._last_render < 1 / PLOT_FRAME_RATE
+            ):
+                return
+            self._last_render = now
+        self._plt.plot(xvals, sweep, clear=True)
+        for acc in self.accumulators:
+            self._plt.plot(xvals, acc.trace(), pen=DISPLAY_HOLD_PENS[acc.mode])
         self._app.processEvents()
         if self._save_plotsp():
             self._save_plot()
@@ -546,7 +1162,10 @@ class Plot:
             first_act_val = inc_val
 
         act_vals = np.arange(first_act_val, self.max_axis_val, inc)
-        bin_vals = [int(np.round(act_val / slope)) for act_val in act_vals]
+        bin_vals = [
+            int(np.round((act_val - self.axis_origin) / slope))
+            for act_val in act_vals
+        ]
         bin_vals = np.subtract(bin_vals, self.min_bin)
 
         for i, j in zip(bin_vals, act_vals):
@@ -674,6 +1293,34 @@ class Configuration:
         self.max_dist = None
         self.spectrum_axis = None
         self.report_avg = None
+        self.vibration_dists = None
+        self.chirp_correction = None
+        self.chirp_file = None
+        self.interference = None
+        self.max_overflow = None
+        self.watchdog = None
+        self.max_tdelay = None
+        self.serial = None
+        self.hotplug = None
+        self.control_channel = None
+        self.profile = None
+        self.soak_overload = None
+        self.soak_replay = None
+        self.soak_interval = None
+        self.plugins = None
+        self.zones = None
+        self.superres_windows = None
+        self.superres_method = None
+        self.superres_targets = None
+        self.auto_db_span = None
+        self.zone_thresholds = None
+        self.dist_grid = None
+        self.mti_pulses = None
+        self.integration = None
+        self.display_hold = None
+        self.tbd = None
+        self.profile_stream = None
+        self.memory_budget = None
         self.params = [
             Parameter(
                 name="FPGA output",
@@ -835,6 +1482,230 @@ class Configuration:
                 possible=self._report_avg_possible,
                 init="false",
             ),
+            Parameter(
+                name="vibration distances (m)",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_vibration_dists,
+                setter=self._set_vibration_dists,
+                possible=self._vibration_dists_possible,
+                init="",
+            ),
+            Parameter(
+                name="chirp correction",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_chirp_correction,
+                setter=self._set_chirp_correction,
+                possible=self._chirp_correction_possible,
+                init="off",
+            ),
+            Parameter(
+                name="chirp calibration file",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_chirp_file,
+                setter=self._set_chirp_file,
+                possible=self._chirp_file_possible,
+                init="chirp_cal.npy",
+            ),
+            Parameter(
+                name="interference repair",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_interference,
+                setter=self._set_interference,
+                possible=self._interference_possible,
+                init="off",
+            ),
+            Parameter(
+                name="max ADC overflows",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_max_overflow,
+                setter=self._set_max_overflow,
+                possible=self._max_overflow_possible,
+                init="None",
+            ),
+            Parameter(
+                name="USB watchdog (s)",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_watchdog,
+                setter=self._set_watchdog,
+                possible=self._watchdog_possible,
+                init="2",
+            ),
+            Parameter(
+                name="max ramp delay (s)",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_max_tdelay,
+                setter=self._set_max_tdelay,
+                possible=self._max_tdelay_possible,
+                init="None",
+            ),
+            Parameter(
+                name="device serial",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_serial,
+                setter=self._set_serial,
+                possible=self._serial_possible,
+                init="None",
+            ),
+            Parameter(
+                name="hotplug",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_hotplug,
+                setter=self._set_hotplug,
+                possible=self._hotplug_possible,
+                init="true",
+            ),
+            Parameter(
+                name="control channel",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_control_channel,
+                setter=self._set_control_channel,
+                possible=self._control_channel_possible,
+                init="false",
+            ),
+            Parameter(
+                name="profile",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_profile,
+                setter=self._set_profile,
+                possible=self._profile_possible,
+                init="false",
+            ),
+            Parameter(
+                name="soak overload",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_soak_overload,
+                setter=self._set_soak_overload,
+                possible=self._soak_overload_possible,
+                init="1",
+            ),
+            Parameter(
+                name="soak replay file",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_soak_replay,
+                setter=self._set_soak_replay,
+                possible=self._soak_replay_possible,
+                init="None",
+            ),
+            Parameter(
+                name="soak interval (s)",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_soak_interval,
+                setter=self._set_soak_interval,
+                possible=self._soak_interval_possible,
+                init="60",
+            ),
+            Parameter(
+                name="plugins",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_plugins,
+                setter=self._set_plugins,
+                possible=self._plugins_possible,
+                init="None",
+            ),
+            Parameter(
+                name="alert zones",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_zones,
+                setter=self._set_zones,
+                possible=self._zones_possible,
+                init="None",
+            ),
+            Parameter(
+                name="super-res windows (m)",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_superres_windows,
+                setter=self._set_superres_windows,
+                possible=self._superres_windows_possible,
+                init="None",
+            ),
+            Parameter(
+                name="super-res method",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_superres_method,
+                setter=self._set_superres_method,
+                possible=self._superres_method_possible,
+                init="music",
+            ),
+            Parameter(
+                name="super-res targets",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_superres_targets,
+                setter=self._set_superres_targets,
+                possible=self._superres_targets_possible,
+                init="2",
+            ),
+            Parameter(
+                name="auto dB range",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_auto_db_span,
+                setter=self._set_auto_db_span,
+                possible=self._auto_db_span_possible,
+                init="None",
+            ),
+            Parameter(
+                name="alert zone thresholds",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_zone_thresholds,
+                setter=self._set_zone_thresholds,
+                possible=self._zone_thresholds_possible,
+                init="dBFS",
+            ),
+            Parameter(
+                name="distance grid (m)",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_dist_grid,
+                setter=self._set_dist_grid,
+                possible=self._dist_grid_possible,
+                init="None",
+            ),
+            Parameter(
+                name="MTI pulses",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_mti_pulses,
+                setter=self._set_mti_pulses,
+                possible=self._mti_pulses_possible,
+                init="0",
+            ),
+            Parameter(
+                name="integration",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_integration,
+                setter=self._set_integration,
+                possible=self._integration_possible,
+                init="off",
+            ),
+            Parameter(
+                name="display hold",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_display_hold,
+                setter=self._set_display_hold,
+                possible=self._display_hold_possible,
+                init="off",
+            ),
+            Parameter(
+                name="track before detect",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_tbd,
+                setter=self._set_tbd,
+                possible=self._tbd_possible,
+                init="off",
+            ),
+            Parameter(
+                name="profile stream",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_profile_stream,
+                setter=self._set_profile_stream,
+                possible=self._profile_stream_possible,
+                init="None",
+            ),
+            Parameter(
+                name="memory budget (MiB)",
+                number=self._get_inc_param_ctr(),
+                getter=self._get_memory_budget,
+                setter=self._set_memory_budget,
+                possible=self._memory_budget_possible,
+                init="0",
+            ),
         ]
         self._param_name_width = self._max_param_name_width()
         param_by_name = lambda x: [
@@ -891,6 +1762,32 @@ class Configuration:
                 ],
                 message_func=self._noise_floor_message,
             ),
+            Menu(
+                name="Chirp Calibration",
+                number=self._get_inc_menu_ctr(),
+                parameter_configuration=[
+                    (param_by_name("FPGA output"), "RAW"),
+                    (param_by_name("display output"), "RAW"),
+                    (param_by_name("log file"), ""),
+                    (param_by_name("capture time (s)"), "10"),
+                    (param_by_name("plot type"), "spectrum"),
+                    (param_by_name("dB min"), "-120"),
+                    (param_by_name("dB max"), "-20"),
+                    (param_by_name("plot save dir"), ""),
+                    (param_by_name("subtract last"), "false"),
+                    (param_by_name("receiver channel"), "B"),
+                    (param_by_name("ADF start frequency (Hz)"), "5.6e9"),
+                    (param_by_name("ADF bandwidth (Hz)"), "300e6"),
+                    (param_by_name("ADF sweep time (s)"), "1e-3"),
+                    (param_by_name("ADF delay time (s)"), "2e-3"),
+                    (param_by_name("min plotting frequency (Hz)"), "0"),
+                    (param_by_name("max plotting frequency (Hz)"), "1e6"),
+                    (param_by_name("dist/freq axis"), "dist"),
+                    (param_by_name("report average"), "false"),
+                    (param_by_name("chirp correction"), "calibrate"),
+                ],
+                message_func=self._chirp_calibration_message,
+            ),
         ]
 
     def display(self) -> str:
@@ -932,6 +1829,15 @@ class Configuration:
 
         return display_str
 
+    def param_for_name(self, name: str) -> Parameter:
+        """
+        """
+        for param in self.params:
+            if name == param.name:
+                return param
+
+        raise RuntimeError("Invalid Parameter name: {}.".format(name))
+
     def param_for_number(self, number: int) -> Parameter:
         """
         """
@@ -1604,30 +2510,1207 @@ class Configuration:
         """
         return True
 
-    def _check_parameters(self) -> bool:
+    def _get_vibration_dists(self, strval: bool = False):
         """
         """
-        valid = True
-        valid &= self._check_fpga_output()
-        valid &= self._check_display_output()
-        valid &= self._check_log_file()
-        valid &= self._check_time()
-        valid &= self._check_plot_type()
-        valid &= self._check_db_min()
-        valid &= self._check_db_max()
-        valid &= self._check_plot_dir()
-        valid &= self._check_sub_last()
-        valid &= self._check_channel()
-        valid &= self._check_adf_fstart()
-        valid &= self._check_adf_bandwidth()
-        valid &= self._check_adf_tsweep()
-        valid &= self._check_adf_tdelay()
-        valid &= self._check_min_freq()
-        valid &= self._check_max_freq()
+        if strval:
+            if not self.vibration_dists:
+                return "None"
+            return ", ".join([str(dist) for dist in self.vibration_dists])
+        return self.vibration_dists
+
+    def _set_vibration_dists(self, newval: str):
+        """
+        """
+        if newval.strip() == "" or newval.lower() == "none":
+            self.vibration_dists = []
+        else:
+            self.vibration_dists = [
+                float(dist) for dist in newval.split(",") if dist.strip()
+            ]
+
+    def _vibration_dists_possible(self) -> str:
+        """
+        """
+        return (
+            "Comma-separated list of distances whose sweep-to-sweep "
+            "displacement should be monitored, or None. Requires a "
+            "host-computed FFT (FPGA output other than FFT)."
+        )
+
+    def _check_vibration_dists(self) -> bool:
+        """
+        """
+        if not self.vibration_dists:
+            return True
+        if self._fpga_output == Data.FFT:
+            write(
+                "The vibration monitor needs phase, which the FPGA FFT "
+                "output does not provide."
+            )
+            return False
+        if self._display_output != Data.FFT and self.ptype == PlotType.TIME:
+            write("The vibration monitor requires a spectrum display.")
+            return False
+        return True
+
+    def _get_chirp_correction(self, strval: bool = False):
+        """
+        """
+        return self.chirp_correction
+
+    def _set_chirp_correction(self, newval: str):
+        """
+        """
+        newval_lower = newval.lower()
+        if newval_lower == "off" or newval_lower == "o":
+            self.chirp_correction = "off"
+        elif newval_lower == "calibrate" or newval_lower == "c":
+            self.chirp_correction = "calibrate"
+        elif newval_lower == "apply" or newval_lower == "a":
+            self.chirp_correction = "apply"
+        else:
+            print(
+                "Invalid chirp correction. Setting it to off. Please "
+                "reconfigure it with a permissible entry."
+            )
+            self.chirp_correction = "off"
+
+    def _chirp_correction_possible(self) -> str:
+        """
+        """
+        return (
+            "off, calibrate (fit the correction from a single strong "
+            "reflector and save it to the chirp calibration file) or "
+            "apply (resample each sweep with the saved correction). "
+            "Case-insensitive."
+        )
+
+    def _check_chirp_correction(self) -> bool:
+        """
+        """
+        if self.chirp_correction == "off":
+            return True
+        if self._fpga_output == Data.FFT:
+            write("Chirp correction requires time-domain FPGA output.")
+            return False
+        if self.chirp_correction == "apply" and not self.chirp_file.is_file():
+            write("Chirp calibration file does not exist. Calibrate first.")
+            return False
+        return True
+
+    def _get_chirp_file(self, strval: bool = False):
+        """
+        """
+        if strval:
+            return self.chirp_file.as_posix()
+        return self.chirp_file
+
+    def _set_chirp_file(self, newval: str):
+        """
+        """
+        self.chirp_file = Path(newval).resolve()
+
+    def _chirp_file_possible(self) -> str:
+        """
+        """
+        return "Any valid file path (NumPy .npy format)."
+
+    def _check_chirp_file(self) -> bool:
+        """
+        """
+        return True
+
+    def _get_interference(self, strval: bool = False):
+        """
+        """
+        return self.interference
+
+    def _set_interference(self, newval: str):
+        """
+        """
+        newval_lower = newval.lower()
+        if newval_lower == "off" or newval_lower == "o":
+            self.interference = "off"
+        elif newval_lower == "zero" or newval_lower == "z":
+            self.interference = "zero"
+        elif newval_lower == "taper" or newval_lower == "t":
+            self.interference = "taper"
+        elif newval_lower == "interpolate" or newval_lower == "i":
+            self.interference = "interpolate"
+        else:
+            print(
+                "Invalid interference repair. Setting it to off. Please "
+                "reconfigure it with a permissible entry."
+            )
+            self.interference = "off"
+
+    def _interference_possible(self) -> str:
+        """
+        """
+        return (
+            "off, zero, taper or interpolate (case-insensitive). Bursts "
+            "are repaired in RAW FPGA output before the FIR filter."
+        )
+
+    def _check_interference(self) -> bool:
+        """
+        """
+        if self.interference != "off" and self._fpga_output != Data.RAW:
+            write("Interference repair requires RAW FPGA output.")
+            return False
+        return True
+
+    def _get_max_overflow(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if self.max_overflow is None:
+                return "None"
+            return str(self.max_overflow)
+        return self.max_overflow
+
+    def _set_max_overflow(self, newval: str):
+        """
+        """
+        if newval.lower() == "none":
+            self.max_overflow = None
+        else:
+            self.max_overflow = int(newval)
+
+    def _max_overflow_possible(self) -> str:
+        """
+        """
+        return (
+            "Any non-negative integer or None. Sweeps with more ADC "
+            "overflows than this are dropped. None keeps every sweep."
+        )
+
+    def _check_max_overflow(self) -> bool:
+        """
+        """
+        if self.max_overflow is not None and self.max_overflow < 0:
+            write("Max ADC overflows must be non-negative.")
+            return False
+        return True
+
+    def _get_watchdog(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if self.watchdog is None:
+                return "None"
+            return str(self.watchdog)
+        return self.watchdog
+
+    def _set_watchdog(self, newval: str):
+        """
+        """
+        if newval.lower() == "none":
+            self.watchdog = None
+        else:
+            self.watchdog = float(newval)
+
+    def _watchdog_possible(self) -> str:
+        """
+        """
+        return (
+            "Any positive float or None. The USB link is purged, reset "
+            "or reopened and the radar reconfigured when no sweep "
+            "arrives for this long. None disables recovery."
+        )
+
+    def _check_watchdog(self) -> bool:
+        """
+        """
+        if self.watchdog is None:
+            return True
+        if self.watchdog <= 0:
+            write("USB watchdog must be positive.")
+            return False
+        if self.watchdog <= self.adf_tsweep + self.adf_tdelay:
+            write("USB watchdog must be longer than a sweep.")
+            return False
+        return True
+
+    def _get_max_tdelay(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if self.max_tdelay is None:
+                return "None"
+            return str(self.max_tdelay)
+        return self.max_tdelay
+
+    def _set_max_tdelay(self, newval: str):
+        """
+        """
+        if newval.lower() == "none":
+            self.max_tdelay = None
+        else:
+            self.max_tdelay = float(newval)
+
+    def _max_tdelay_possible(self) -> str:
+        """
+        """
+        return (
+            "Any float at least the ramp delay, or None. When set, the "
+            "ramp delay is lengthened up to this value while sweeps are "
+            "dropped for being read too slowly, and shortened back "
+            "toward the configured ramp delay when they are read "
+            "promptly. Rates derived from the configured ramp delay, "
+            "such as the vibration monitor's, do not follow it. None "
+            "keeps the ramp delay fixed."
+        )
+
+    def _check_max_tdelay(self) -> bool:
+        """
+        """
+        if self.max_tdelay is None:
+            return True
+        if self.max_tdelay < self.adf_tdelay:
+            write("Max ramp delay must be at least the ramp delay.")
+            return False
+        return True
+
+    def _get_serial(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if self.serial is None:
+                return "None"
+            return self.serial
+        return self.serial
+
+    def _set_serial(self, newval: str):
+        """
+        """
+        if newval.strip() == "" or newval.lower() == "none":
+            self.serial = None
+        else:
+            self.serial = newval.strip()
+
+    def _serial_possible(self) -> str:
+        """
+        """
+        return (
+            "Serial number of the radar to use (see the list command), "
+            "or None to use the first radar found."
+        )
+
+    def _check_serial(self) -> bool:
+        """
+        """
+        if self.serial is None:
+            return True
+        if self.serial not in [dev["serial"] for dev in list_devices()]:
+            write("No radar with serial {} is attached.".format(self.serial))
+            return False
+        return True
+
+    def _get_hotplug(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if self.hotplug:
+                return "true"
+            return "false"
+        return self.hotplug
+
+    def _set_hotplug(self, newval: str):
+        """
+        """
+        newval_lower = newval.lower()
+        if newval_lower == "true" or newval_lower == "t":
+            self.hotplug = True
+        elif newval_lower == "false" or newval_lower == "f":
+            self.hotplug = False
+        else:
+            print(
+                "Invalid hotplug value. Setting it to false. Please "
+                "reconfigure it with a permissible entry."
+            )
+            self.hotplug = False
+
+    def _hotplug_possible(self) -> str:
+        """
+        """
+        return (
+            "true or false (case-insensitive). When true, an unplugged "
+            "radar is reopened and reconfigured once it is plugged back in."
+        )
+
+    def _check_hotplug(self) -> bool:
+        """
+        """
+        return True
+
+    def _get_control_channel(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if self.control_channel:
+                return "true"
+            return "false"
+        return self.control_channel
+
+    def _set_control_channel(self, newval: str):
+        """
+        """
+        newval_lower = newval.lower()
+        if newval_lower == "true" or newval_lower == "t":
+            self.control_channel = True
+        elif newval_lower == "false" or newval_lower == "f":
+            self.control_channel = False
+        else:
+            print(
+                "Invalid control channel value. Setting it to false. "
+                "Please reconfigure it with a permissible entry."
+            )
+            self.control_channel = False
+
+    def _control_channel_possible(self) -> str:
+        """
+        """
+        return (
+            "true or false (case-insensitive). When true, commands are "
+            "sent over the FPGA's JTAG port on the second FTDI interface "
+            "and applied between frames, so the data stream is never "
+            "interrupted. Requires the JTAG port to be free (no openocd)."
+        )
+
+    def _check_control_channel(self) -> bool:
+        """
+        """
+        return True
+
+    def _get_profile(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if self.profile:
+                return "true"
+            return "false"
+        return self.profile
+
+    def _set_profile(self, newval: str):
+        """
+        """
+        newval_lower = newval.lower()
+        if newval_lower == "true" or newval_lower == "t":
+            self.profile = True
+        elif newval_lower == "false" or newval_lower == "f":
+            self.profile = False
+        else:
+            print(
+                "Invalid profile value. Setting it to false. Please "
+                "reconfigure it with a permissible entry."
+            )
+            self.profile = False
+
+    def _profile_possible(self) -> str:
+        """
+        """
+        return (
+            "true or false (case-insensitive). When true, hardware "
+            "performance counters are reported for each host library "
+            "and processing stage."
+        )
+
+    def _check_profile(self) -> bool:
+        """
+        """
+        return True
+
+    def _get_soak_overload(self, strval: bool = False):
+        """
+        """
+        if strval:
+            return str(self.soak_overload)
+        return self.soak_overload
+
+    def _set_soak_overload(self, newval: str):
+        """
+        """
+        self.soak_overload = float(newval)
+
+    def _soak_overload_possible(self) -> str:
+        """
+        """
+        return (
+            "Any non-negative float. The soak command emulates this "
+            "multiple of the configured sweep rate. 0 emits sweeps as "
+            "fast as they can be parsed."
+        )
+
+    def _check_soak_overload(self) -> bool:
+        """
+        """
+        if self.soak_overload < 0:
+            write("Soak overload must be non-negative.")
+            return False
+        return True
+
+    def _get_soak_replay(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if self.soak_replay is None:
+                return "None"
+            return self.soak_replay.as_posix()
+        return self.soak_replay
+
+    def _set_soak_replay(self, newval: str):
+        """
+        """
+        if newval.strip() == "" or newval.lower() == "none":
+            self.soak_replay = None
+        else:
+            self.soak_replay = Path(newval).resolve()
+
+    def _soak_replay_possible(self) -> str:
+        """
+        """
+        return (
+            "A log file recorded with the current FPGA output, replayed "
+            "in a loop by the soak command, or None to generate sweeps."
+        )
+
+    def _check_soak_replay(self) -> bool:
+        """
+        """
+        if self.soak_replay is not None and not self.soak_replay.is_file():
+            write("Soak replay file does not exist.")
+            return False
+        return True
+
+    def _get_soak_interval(self, strval: bool = False):
+        """
+        """
+        if strval:
+            return str(self.soak_interval)
+        return self.soak_interval
+
+    def _set_soak_interval(self, newval: str):
+        """
+        """
+        self.soak_interval = float(newval)
+
+    def _soak_interval_possible(self) -> str:
+        """
+        """
+        return (
+            "Any positive float. Memory, backlog and latency are sampled "
+            "this often during a soak test."
+        )
+
+    def _check_soak_interval(self) -> bool:
+        """
+        """
+        if self.soak_interval <= 0:
+            write("Soak interval must be positive.")
+            return False
+        return True
+
+    def _get_plugins(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if not self.plugins:
+                return "None"
+            return ", ".join(
+                [
+                    "{}:{}".format(point, path.as_posix())
+                    + ("?" + args if args else "")
+                    for point, path, args in self.plugins
+                ]
+            )
+        return self.plugins
+
+    def _set_plugins(self, newval: str):
+        """
+        """
+        self.plugins = []
+        if newval.strip() == "" or newval.lower() == "none":
+            return
+        for entry in newval.split(","):
+            point, _, rest = entry.strip().partition(":")
+            path, _, args = rest.partition("?")
+            self.plugins.append((point.lower(), Path(path).resolve(), args))
+
+    def _plugins_possible(self) -> str:
+        """
+        """
+        return (
+            "Comma-separated list of point:path[?args] entries, or None. "
+            "Each loads a native plugin (see src/fmcw_plugin.h) at a "
+            "point, one of {}, passing it args.".format(
+                ", ".join(PLUGIN_POINTS)
+            )
+        )
+
+    def _check_plugins(self) -> bool:
+        """
+        """
+        for point, path, _ in self.plugins:
+            if point not in PLUGIN_POINTS:
+                write("Invalid plugin point {}.".format(point))
+                return False
+            if not path.is_file():
+                write("Plugin {} does not exist.".format(path.as_posix()))
+                return False
+        return True
+
+    def _get_zones(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if not self.zones:
+                return "None"
+            return ", ".join(
+                [
+                    "{}-{}:{}:{}".format(lo, hi, on, off)
+                    for lo, hi, on, off in self.zones
+                ]
+            )
+        return self.zones
+
+    def _set_zones(self, newval: str):
+        """
+        """
+        self.zones = []
+        if newval.strip() == "" or newval.lower() == "none":
+            return
+        for entry in newval.split(","):
+            fields = entry.strip().split(":")
+            lo, hi = [float(dist) for dist in fields[0].split("-")]
+            on = float(fields[1])
+            if len(fields) > 2:
+                off = float(fields[2])
+            else:
+                off = on - ZONE_HYSTERESIS_DB
+            self.zones.append((lo, hi, on, off))
+
+    def _zones_possible(self) -> str:
+        """
+        """
+        return (
+            "Comma-separated list of lo-hi:on[:off] entries, or None. "
+            "An alert is raised when the spectrum between lo and hi "
+            "meters exceeds on dBFS, and cleared when it falls below "
+            "off dBFS ({} dB below on by default). See alert zone "
+            "thresholds for levels relative to the noise floor.".format(
+                ZONE_HYSTERESIS_DB
+            )
+        )
+
+    def _check_zones(self) -> bool:
+        """
+        """
+        if not self.zones:
+            return True
+        if self._display_output != Data.FFT and self.ptype == PlotType.TIME:
+            write("Alert zones require a spectrum display.")
+            return False
+        for lo, hi, on, off in self.zones:
+            if lo < 0 or hi < lo:
+                write("Invalid alert zone range {}-{}.".format(lo, hi))
+                return False
+            if off > on:
+                write("Alert zone off threshold must not exceed on.")
+                return False
+        return True
+
+    def _get_superres_windows(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if not self.superres_windows:
+                return "None"
+            return ", ".join(
+                ["{}-{}".format(lo, hi) for lo, hi in self.superres_windows]
+            )
+        return self.superres_windows
+
+    def _set_superres_windows(self, newval: str):
+        """
+        """
+        self.superres_windows = []
+        if newval.strip() == "" or newval.lower() == "none":
+            return
+        for entry in newval.split(","):
+            lo, hi = [float(dist) for dist in entry.strip().split("-")]
+            self.superres_windows.append((lo, hi))
+
+    def _superres_windows_possible(self) -> str:
+        """
+        """
+        return (
+            "Comma-separated list of lo-hi distance windows, or None. "
+            "Each window should be a few bins wide and bracket an FFT "
+            "peak that may hide several reflectors. Requires a "
+            "host-computed FFT (FPGA output other than FFT)."
+        )
+
+    def _check_superres_windows(self) -> bool:
+        """
+        """
+        if not self.superres_windows:
+            return True
+        if self._fpga_output == Data.FFT:
+            write(
+                "Super-resolution needs phase, which the FPGA FFT output "
+                "does not provide."
+            )
+            return False
+        if self._display_output != Data.FFT and self.ptype == PlotType.TIME:
+            write("Super-resolution requires a spectrum display.")
+            return False
+        for lo, hi in self.superres_windows:
+            if lo < 0 or hi <= lo:
+                write("Invalid super-res window {}-{}.".format(lo, hi))
+                return False
+        nbins = spectrum_len(self._display_output)
+        for (lo, hi), (_, hi_bin) in zip(
+            self.superres_windows, self._superres_bins()
+        ):
+            if hi_bin >= nbins:
+                write(
+                    "Super-res window {}-{} extends past the end of the "
+                    "spectrum, once widened to the {} bins that {} "
+                    "targets need.".format(
+                        lo,
+                        hi,
+                        2 * (self.superres_targets + 1),
+                        self.superres_targets,
+                    )
+                )
+                return False
+        return True
+
+    def _superres_bin_dist(self) -> float:
+        """
+        Distance (m) spanned by a range bin of the displayed spectrum.
+        """
+        display_output = self._display_output
+        return dbin(
+            2 * nyquist_freq(display_output),
+            self.adf_tsweep,
+            data_sweep_len(display_output),
+            self.adf_bandwidth,
+        )
+
+    def _superres_bins(self) -> List[Tuple[int, int]]:
+        """
+        First and last range bins of each super-resolution window,
+        widened to the fewest bins the estimator needs.
+        """
+        bin_dist = self._superres_bin_dist()
+        # the covariance needs at least one noise dimension
+        min_bins = 2 * (self.superres_targets + 1)
+        bins = []
+        for lo, hi in self.superres_windows:
+            lo_bin = int(np.floor(lo / bin_dist))
+            hi_bin = max(int(np.ceil(hi / bin_dist)), lo_bin + min_bins - 1)
+            bins.append((lo_bin, hi_bin))
+        return bins
+
+    def _get_superres_method(self, strval: bool = False):
+        """
+        """
+        return self.superres_method
+
+    def _set_superres_method(self, newval: str):
+        """
+        """
+        self.superres_method = newval.lower()
+
+    def _superres_method_possible(self) -> str:
+        """
+        """
+        return (
+            "music or esprit (case-insensitive). MUSIC searches a "
+            "pseudo-spectrum, ESPRIT solves for the frequencies directly."
+        )
+
+    def _check_superres_method(self) -> bool:
+        """
+        """
+        if self.superres_method not in SUPERRES_METHODS:
+            write(
+                "Super-res method must be one of: {}.".format(
+                    ", ".join(SUPERRES_METHODS)
+                )
+            )
+            return False
+        return True
+
+    def _get_superres_targets(self, strval: bool = False):
+        """
+        """
+        if strval:
+            return str(self.superres_targets)
+        return self.superres_targets
+
+    def _set_superres_targets(self, newval: str):
+        """
+        """
+        self.superres_targets = int(newval)
+
+    def _superres_targets_possible(self) -> str:
+        """
+        """
+        return "Number of reflectors to resolve in each super-res window."
+
+    def _check_superres_targets(self) -> bool:
+        """
+        """
+        if self.superres_targets < 1:
+            write("Super-res targets must be at least 1.")
+            return False
+        return True
+
+    def _get_auto_db_span(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if self.auto_db_span is None:
+                return "None"
+            return str(self.auto_db_span)
+        return self.auto_db_span
+
+    def _set_auto_db_span(self, newval: str):
+        """
+        """
+        if newval.lower() == "none":
+            self.auto_db_span = None
+        else:
+            self.auto_db_span = float(newval)
+
+    def _auto_db_span_possible(self) -> str:
+        """
+        """
+        return (
+            "Displayed dB span, or None to use dB min and dB max. The "
+            "range then follows the measured noise floor, starting {} dB "
+            "below it.".format(AUTO_DB_BELOW)
+        )
+
+    def _check_auto_db_span(self) -> bool:
+        """
+        """
+        if self.auto_db_span is None:
+            return True
+        if self.auto_db_span <= 0:
+            write("The auto dB span must be positive.")
+            return False
+        if self._display_output != Data.FFT and self.ptype == PlotType.TIME:
+            write("An auto dB range requires a spectrum display.")
+            return False
+        return True
+
+    def _get_zone_thresholds(self, strval: bool = False):
+        """
+        """
+        return self.zone_thresholds
+
+    def _set_zone_thresholds(self, newval: str):
+        """
+        """
+        for thresholds in ZONE_THRESHOLDS:
+            if newval.lower() == thresholds.lower():
+                self.zone_thresholds = thresholds
+                return
+        print(
+            "Invalid alert zone thresholds. Setting them to dBFS. Please "
+            "reconfigure them with a permissible entry."
+        )
+        self.zone_thresholds = "dBFS"
+
+    def _zone_thresholds_possible(self) -> str:
+        """
+        """
+        return (
+            "dBFS or cfar (case-insensitive). With cfar, alert zone "
+            "thresholds are dB above each sweep's noise floor."
+        )
+
+    def _check_zone_thresholds(self) -> bool:
+        """
+        """
+        return True
+
+    def _get_dist_grid(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if self.dist_grid is None:
+                return "None"
+            return "{}:{}:{}".format(*self.dist_grid)
+        return self.dist_grid
+
+    def _set_dist_grid(self, newval: str):
+        """
+        """
+        if newval.strip() == "" or newval.lower() == "none":
+            self.dist_grid = None
+        else:
+            self.dist_grid = tuple(float(val) for val in newval.split(":"))
+
+    def _dist_grid_possible(self) -> str:
+        """
+        """
+        return (
+            "start:step:stop in meters, or None. Range profiles are "
+            "resampled onto this grid so that captures with different "
+            "bandwidths, sweep times or outputs line up. Requires a "
+            "distance axis."
+        )
+
+    def _check_dist_grid(self) -> bool:
+        """
+        """
+        if self.dist_grid is None:
+            return True
+        if len(self.dist_grid) != 3:
+            write("The distance grid must be given as start:step:stop.")
+            return False
+        start, step, stop = self.dist_grid
+        if start < 0 or step <= 0 or stop <= start:
+            write("Invalid distance grid.")
+            return False
+        if self._display_output != Data.FFT and self.ptype == PlotType.TIME:
+            write("A distance grid requires a spectrum display.")
+            return False
+        if self.spectrum_axis != "dist":
+            write("A distance grid requires a distance axis.")
+            return False
+        return True
+
+    def _get_integration(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if self.integration is None:
+                return "off"
+            return "{} {} {}".format(*self.integration)
+        return self.integration
+
+    def _set_integration(self, newval: str):
+        """
+        """
+        fields = newval.lower().split()
+        if not fields or fields == ["off"]:
+            self.integration = None
+        elif len(fields) in (2, 3):
+            window = int(fields[1])
+            stride = int(fields[2]) if len(fields) == 3 else window
+            self.integration = (fields[0], window, stride)
+        else:
+            print(
+                "Invalid integration. Setting it to off. Please "
+                "reconfigure it with a permissible entry."
+            )
+            self.integration = None
+
+    def _integration_possible(self) -> str:
+        """
+        """
+        return (
+            "off, or MODE WINDOW [STRIDE]. Spectra are averaged over "
+            "WINDOW sweeps and one is displayed every STRIDE sweeps, "
+            "by default WINDOW. MODE is coherent (complex spectra, "
+            "host FFT only), magnitude or power."
+        )
+
+    def _check_integration(self) -> bool:
+        """
+        """
+        if self.integration is None:
+            return True
+        mode, window, stride = self.integration
+        if mode not in ("coherent", "magnitude", "power"):
+            write("Integration mode must be coherent, magnitude or power.")
+            return False
+        if window < 1 or stride < 1 or stride > window:
+            write("Integration needs 1 <= STRIDE <= WINDOW.")
+            return False
+        if self._display_output != Data.FFT:
+            write("Integration requires FFT display output.")
+            return False
+        if mode == "coherent" and self._fpga_output == Data.FFT:
+            write(
+                "Coherent integration needs complex spectra, but the "
+                "FPGA FFT output is magnitude only."
+            )
+            return False
+        return True
+
+    def _get_display_hold(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if self.display_hold is None:
+                return "off"
+            return ", ".join(
+                "{} {}".format(mode, param) for mode, param in self.display_hold
+            )
+        return self.display_hold
+
+    def _set_display_hold(self, newval: str):
+        """
+        """
+        if newval.strip().lower() == "off":
+            self.display_hold = None
+            return
+        traces = []
+        for trace in newval.lower().split(","):
+            fields = trace.split()
+            if not fields or len(fields) > 2:
+                print(
+                    "Invalid display hold. Setting it to off. Please "
+                    "reconfigure it with a permissible entry."
+                )
+                self.display_hold = None
+                return
+            mode = fields[0]
+            if len(fields) == 2:
+                param = float(fields[1])
+            else:
+                param = DISPLAY_HOLD_EMA_TAU if mode == "ema" else 0.0
+            traces.append((mode, param))
+        self.display_hold = traces
+
+    def _display_hold_possible(self) -> str:
+        """
+        """
+        return (
+            "off, or a comma-separated list of traces drawn over the "
+            "spectrum plot: max [DECAY], min [DECAY] and ema [TAU]. "
+            "Holds relax by DECAY dB/s (default 0, hold indefinitely), "
+            "and ema averages with a time constant of TAU s (default "
+            "{})."
+        ).format(DISPLAY_HOLD_EMA_TAU)
+
+    def _check_display_hold(self) -> bool:
+        """
+        """
+        if self.display_hold is None:
+            return True
+        if self.ptype != PlotType.SPECTRUM:
+            write("Display hold requires a spectrum plot.")
+            return False
+        for mode, param in self.display_hold:
+            if mode not in DISPLAY_HOLD_PENS:
+                write("Display hold traces must be max, min or ema.")
+                return False
+            if param < 0 or (mode == "ema" and param == 0):
+                write("Display hold decay must be >= 0 and ema TAU > 0.")
+                return False
+        return True
+
+    def _get_tbd(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if self.tbd is None:
+                return "off"
+            return "{} {} {}".format(*self.tbd)
+        return self.tbd
+
+    def _set_tbd(self, newval: str):
+        """
+        """
+        fields = newval.lower().split()
+        if fields == ["off"]:
+            self.tbd = None
+        elif len(fields) == 3:
+            self.tbd = (int(fields[0]), float(fields[1]), float(fields[2]))
+        else:
+            print(
+                "Invalid track before detect. Setting it to off. Please "
+                "reconfigure it with a permissible entry."
+            )
+            self.tbd = None
+
+    def _tbd_possible(self) -> str:
+        """
+        """
+        return (
+            "off, or WINDOW SPEED THRESHOLD. Integrates spectra along "
+            "tracks over the last WINDOW sweeps for targets moving up "
+            "to SPEED m/s, and reports tracks whose mean level is "
+            "THRESHOLD dB above the noise floor."
+        )
+
+    def _check_tbd(self) -> bool:
+        """
+        """
+        if self.tbd is None:
+            return True
+        window, speed, threshold = self.tbd
+        if self._display_output != Data.FFT and self.ptype == PlotType.TIME:
+            write("Track before detect requires a spectrum display.")
+            return False
+        if window < 2 or speed < 0:
+            write("Track before detect needs WINDOW >= 2 and SPEED >= 0.")
+            return False
+        return True
+
+    def _get_profile_stream(self, strval: bool = False):
+        """
+        """
+        if strval:
+            if self.profile_stream is None:
+                return "None"
+            return self.profile_stream.as_posix()
+        return self.profile_stream
+
+    def _set_profile_stream(self, newval: str):
+        """
+        """
+        if newval.strip() == "" or newval.lower() == "none":
+            self.profile_stream = None
+        else:
+            self.profile_stream = Path(newval).resolve()
+
+    def _profile_stream_possible(self) -> str:
+        """
+        """
+        return (
+            "A file or named pipe to which each displayed dB profile is "
+            "written in a compact encoding for remote displays, or None. "
+            "read_profile_stream decodes it."
+        )
+
+    def _check_profile_stream(self) -> bool:
+        """
+        """
+        if self.profile_stream is None:
+            return True
+        if self._display_output != Data.FFT and self.ptype == PlotType.TIME:
+            write("The profile stream requires a spectrum display.")
+            return False
+        if not self.profile_stream.parent.is_dir():
+            write("Profile stream directory does not exist.")
+            return False
+        return True
+
+    def _get_memory_budget(self, strval: bool = False):
+        """
+        """
+        if strval:
+            return str(self.memory_budget)
+        return self.memory_budget
+
+    def _set_memory_budget(self, newval: str):
+        """
+        """
+        self.memory_budget = float(newval)
+
+    def _memory_budget_possible(self) -> str:
+        """
+        """
+        return (
+            "Any non-negative float. Native buffers are drawn from an "
+            "arena of this size, reserved at the start of acquisition, "
+            "and allocations beyond it fail. 0 draws them from the "
+            "system without a limit."
+        )
+
+    def _check_memory_budget(self) -> bool:
+        """
+        """
+        if self.memory_budget < 0:
+            write("Memory budget must be non-negative.")
+            return False
+        return True
+
+    def _get_mti_pulses(self, strval: bool = False):
+        """
+        """
+        if strval:
+            return str(self.mti_pulses)
+        return self.mti_pulses
+
+    def _set_mti_pulses(self, newval: str):
+        """
+        """
+        self.mti_pulses = int(newval)
+
+    def _mti_pulses_possible(self) -> str:
+        """
+        """
+        return (
+            "0, 2 or 3. Cancels stationary returns in the FPGA by "
+            "differencing each windowed sweep with the previous 1 or 2, "
+            "before the FFT. 0 disables this. Requires WINDOW or FFT "
+            "FPGA output."
+        )
+
+    def _check_mti_pulses(self) -> bool:
+        """
+        """
+        if self.mti_pulses not in [0, 2, 3]:
+            write("MTI pulses must be 0, 2 or 3.")
+            return False
+        if self.mti_pulses != 0 and self._fpga_output < Data.WINDOW:
+            write("MTI requires WINDOW or FFT FPGA output.")
+            return False
+        return True
+
+    def _check_parameters(self) -> bool:
+        """
+        """
+        valid = True
+        valid &= self._check_fpga_output()
+        valid &= self._check_display_output()
+        valid &= self._check_log_file()
+        valid &= self._check_time()
+        valid &= self._check_plot_type()
+        valid &= self._check_db_min()
+        valid &= self._check_db_max()
+        valid &= self._check_plot_dir()
+        valid &= self._check_sub_last()
+        valid &= self._check_channel()
+        valid &= self._check_adf_fstart()
+        valid &= self._check_adf_bandwidth()
+        valid &= self._check_adf_tsweep()
+        valid &= self._check_adf_tdelay()
+        valid &= self._check_min_freq()
+        valid &= self._check_max_freq()
         valid &= self._check_min_dist()
         valid &= self._check_max_dist()
         valid &= self._check_spectrum_axis()
         valid &= self._check_report_avg()
+        valid &= self._check_vibration_dists()
+        valid &= self._check_chirp_correction()
+        valid &= self._check_chirp_file()
+        valid &= self._check_interference()
+        valid &= self._check_max_overflow()
+        valid &= self._check_watchdog()
+        valid &= self._check_max_tdelay()
+        valid &= self._check_serial()
+        valid &= self._check_hotplug()
+        valid &= self._check_control_channel()
+        valid &= self._check_profile()
+        valid &= self._check_soak_overload()
+        valid &= self._check_soak_replay()
+        valid &= self._check_soak_interval()
+        valid &= self._check_plugins()
+        valid &= self._check_zones()
+        valid &= self._check_superres_windows()
+        valid &= self._check_superres_method()
+        valid &= self._check_superres_targets()
+        valid &= self._check_auto_db_span()
+        valid &= self._check_zone_thresholds()
+        valid &= self._check_dist_grid()
+        valid &= self._check_mti_pulses()
+        valid &= self._check_integration()
+        valid &= self._check_display_hold()
+        valid &= self._check_tbd()
+        valid &= self._check_profile_stream()
+        valid &= self._check_memory_budget()
 
         return valid
 
@@ -1639,6 +3722,16 @@ class Configuration:
             "terminated with 50ohm loads."
         ).format(self._get_channel(True))
 
+    def _chirp_calibration_message(self) -> str:
+        """
+        """
+        return (
+            "Place a single strong reflector (e.g. a corner reflector) "
+            "in front of the radar at a long range and keep the scene "
+            "otherwise clear. The correction is saved to {} and can "
+            "then be used by setting chirp correction to apply."
+        ).format(self._get_chirp_file(True))
+
     def _range_plot_235_message(self) -> str:
         """
         """
@@ -1671,6 +3764,51 @@ class Proc:
         self.last_seq = None
         self.db_min = None
         self.db_max = None
+        # VibrationMonitor fed from the complex FFT, or None
+        self.vibration = None
+        # SuperResolution fed from the complex FFT, or None
+        self.superres = None
+        # ChirpCorrector applied to each input sweep, or None
+        self.chirp = None
+        # InterferenceRepair applied to RAW input before the FIR, or None
+        self.interference = None
+        # Profiler with a stage for each of PROC_PROFILE_STAGES, or None
+        self.profiler = None
+        # (path, args) of the native plugins at each Proc point, and the
+        # PluginStage for each, created once the sweep length is known
+        self._plugin_specs = {"input": [], "output": []}
+        self._plugin_stages = {"input": [], "output": []}
+        self.plugin_sweep_rate = 0
+        # ZoneMonitor evaluated on host-computed magnitude spectra, or
+        # None. FPGA FFT output is evaluated by the device.
+        self.zones = None
+        # TrackBeforeDetect searching spectra for faint tracks, or
+        # None, and its detections on the last spectrum.
+        self.tbd = None
+        self.tbd_detections = []
+        # Estimate the noise floor of host-computed spectra into the
+        # sweep metadata. The device estimates it for FPGA FFT output.
+        self.estimate_floor = False
+        # dB span that follows the noise floor, or None for a fixed
+        # db_min and db_max. db_range_changed is set when they move.
+        self.auto_db_span = None
+        self.db_range_changed = False
+        self._floor_db = None
+        self._floor_anchor_db = None
+        # DistanceGrid that magnitude spectra are resampled onto before
+        # conversion to dB, or None, and the spacing of their bins (m)
+        self.grid = None
+        self.grid_bin_dist = None
+        # (mode, window, stride) of the spectrum Integrator, created
+        # once the spectrum length is known, or None. integration
+        # describes the sweeps behind the last integrated spectrum.
+        self._integration_spec = None
+        self._integrator = None
+        self._fft = None
+        self.integration = None
+        # metadata of the sweep being processed, for stages that
+        # need its sequence number
+        self._meta = None
 
     @property
     def output(self) -> Data:
@@ -1724,18 +3862,50 @@ class Proc:
         """
         self.window_coeffs = np.kaiser(data_sweep_len(Data.WINDOW), 6)
 
-    def process_sequence(self, seq: np.array) -> np.array:
+    def process_sequence(
+        self, seq: np.array, meta: Optional[SweepMeta] = None
+    ) -> np.array:
         """
+        :param seq: Sweep as read from the device.
+        :param meta: Sweep metadata, updated by native stages.
+        :returns: The processed sweep, or None if a plugin dropped it.
         """
+        self._meta = meta
+        seq = seq.astype(np.double)
+        self._profile_begin()
+        # repair before subtracting the last sweep, so the detector
+        # sees the sweep itself and a burst is not carried into the
+        # next difference through last_seq
+        if self.interference is not None and self.indata == Data.RAW:
+            self.interference.repair(seq, meta)
+            self._profile_end(PROC_STAGE_INTERFERENCE, seq)
         if self.sub_last:
             new_seq = np.subtract(seq, self.last_seq)
             self.last_seq = np.copy(seq)
             seq = new_seq
             if self.indata == Data.FFT:
                 seq = np.abs(seq)
+            self._profile_begin()
 
         i = self.indata.value
-        seq = seq.astype(np.double)
+        if self.chirp is not None:
+            seq = self.chirp.apply(seq)
+            self._profile_end(PROC_STAGE_CHIRP, seq)
+        if self._plugin_specs["input"]:
+            if self.indata == Data.FFT:
+                seq = self._run_plugins(
+                    "input",
+                    seq,
+                    meta,
+                    "spectrum",
+                    2 * nyquist_freq(self.indata) / len(seq),
+                )
+            else:
+                seq = self._run_plugins(
+                    "input", seq, meta, "time", 2 * nyquist_freq(self.indata)
+                )
+            if seq is None:
+                return None
         proc_func = [
             self.perform_fir,
             self.perform_decimate,
@@ -1744,6 +3914,7 @@ class Proc:
         ]
         while i < self.output.value:
             seq = proc_func[i](seq)
+            self._profile_end(PROC_STAGE_FIR + i, seq)
             i += 1
 
         # normally, we should normalize the FFT FPGA output by
@@ -1761,13 +3932,193 @@ class Proc:
             maxval /= 2 << 5
 
         if self.output == Data.FFT:
+            seq = self._integrate(seq, meta)
+            if seq is None:
+                return None
+            self._profile_end(PROC_STAGE_INTEGRATE, seq)
+            # the device's estimate predates subtract last
+            if self.indata != Data.FFT or self.sub_last:
+                self._estimate_floor(seq, meta)
+            self._auto_db_range(meta, maxval)
+            self._track(seq, meta)
+            if self.zones is not None and self.indata != Data.FFT:
+                self.zones.evaluate(seq, meta)
+            seq = self._map_grid(seq)
             seq = db_arr(seq, maxval, self.db_min, self.db_max)
+            self._profile_end(PROC_STAGE_DB, seq)
         elif self.spectrum:
             seq = self.perform_fft(seq)
+            self._profile_end(PROC_STAGE_FFT, seq)
+            seq = self._integrate(seq, meta)
+            if seq is None:
+                return None
+            self._profile_end(PROC_STAGE_INTEGRATE, seq)
+            self._estimate_floor(seq, meta)
+            self._auto_db_range(meta, maxval)
+            self._track(seq, meta)
+            if self.zones is not None:
+                self.zones.evaluate(seq, meta)
+            seq = self._map_grid(seq)
             seq = db_arr(seq, maxval, self.db_min, self.db_max)
+            self._profile_end(PROC_STAGE_DB, seq)
+
+        if self._plugin_specs["output"]:
+            if self.output == Data.FFT or self.spectrum:
+                seq = self._run_plugins(
+                    "output",
+                    seq,
+                    meta,
+                    "db",
+                    nyquist_freq(self.output) / (len(seq) - 1),
+                )
+            else:
+                seq = self._run_plugins(
+                    "output", seq, meta, "time", 2 * nyquist_freq(self.output)
+                )
+        return seq
+
+    def set_integration(self, spec: Optional[Tuple[str, int, int]]):
+        """
+        Integrate spectra as (mode, window, stride), see
+        ``Integrator``, or not at all if ``spec`` is None.
+        """
+        self._integration_spec = spec
+        self._integrator = None
+        self.integration = None
+
+    def _integrate(
+        self, spec: np.array, meta: Optional[SweepMeta]
+    ) -> Optional[np.array]:
+        """
+        Returns the integrated magnitude spectrum, or None until the
+        integrator emits one.
+        """
+        if self._integration_spec is None:
+            return spec
+        mode, window, stride = self._integration_spec
+        # host FFTs keep their complex spectrum for coherent integration
+        cplx = mode == "coherent"
+        if cplx:
+            spec = self._fft
+        if self._integrator is None:
+            self._integrator = Integrator(mode, len(spec), cplx, window, stride)
+        if not self._integrator.push(spec, meta):
+            return None
+        out, self.integration = self._integrator.result()
+        if mode == "coherent":
+            return np.abs(out)
+        if mode == "power":
+            return np.sqrt(out)
+        return out
+
+    def _estimate_floor(self, spec: np.array, meta: Optional[SweepMeta]):
+        """
+        """
+        if meta is not None and self.estimate_floor:
+            noise_floor(np.ascontiguousarray(spec), meta)
+
+    def _track(self, spec: np.array, meta: Optional[SweepMeta]):
+        """
+        """
+        if self.tbd is not None:
+            self.tbd_detections = self.tbd.process(spec, meta)
+            self._profile_end(PROC_STAGE_TBD, spec)
+
+    def _map_grid(self, spec: np.array) -> np.array:
+        """
+        """
+        if self.grid is None:
+            return spec
+        return self.grid.map(np.ascontiguousarray(spec), self.grid_bin_dist)
+
+    def _auto_db_range(self, meta: Optional[SweepMeta], maxval: float):
+        """
+        Move db_min and db_max to follow the smoothed noise floor.
+        """
+        if self.auto_db_span is None or meta is None or meta.noise_floor <= 0:
+            return
+        floor_db = 20 * np.log10(meta.noise_floor / maxval)
+        if self._floor_db is None:
+            self._floor_db = floor_db
+        else:
+            self._floor_db = (
+                AUTO_DB_SMOOTH * self._floor_db
+                + (1 - AUTO_DB_SMOOTH) * floor_db
+            )
+        if (
+            self._floor_anchor_db is not None
+            and abs(self._floor_db - self._floor_anchor_db) < AUTO_DB_STEP
+        ):
+            return
+        self._floor_anchor_db = self._floor_db
+        self.db_min = self._floor_db - AUTO_DB_BELOW
+        self.db_max = self.db_min + self.auto_db_span
+        self.db_range_changed = True
+
+    def reset_auto_db_range(self):
+        """
+        Forget the smoothed noise floor.
+        """
+        self.db_range_changed = False
+        self._floor_db = None
+        self._floor_anchor_db = None
+
+    def add_plugin(self, point: str, path: str, args: str):
+        """
+        Run a native plugin at ``point`` (input or output) after those
+        already added there.
+        """
+        self._plugin_specs[point].append((path, args))
+        self._plugin_stages[point].append(None)
+
+    def clear_plugins(self):
+        """
+        """
+        self._plugin_specs = {"input": [], "output": []}
+        self._plugin_stages = {"input": [], "output": []}
 
+    def _run_plugins(
+        self,
+        point: str,
+        seq: np.array,
+        meta: Optional[SweepMeta],
+        domain: str,
+        spacing: float,
+    ) -> Optional[np.array]:
+        """
+        Returns None if a plugin dropped the sweep.
+        """
+        stages = self._plugin_stages[point]
+        for i, (path, args) in enumerate(self._plugin_specs[point]):
+            if stages[i] is None:
+                stages[i] = PluginStage(
+                    path,
+                    args,
+                    len(seq),
+                    domain,
+                    spacing,
+                    self.plugin_sweep_rate,
+                    resize=point == "output",
+                )
+            seq = stages[i].process(np.ascontiguousarray(seq), meta)
+            if seq is None:
+                return None
         return seq
 
+    def _profile_begin(self):
+        """
+        """
+        if self.profiler is not None:
+            self.profiler.begin()
+
+    def _profile_end(self, stage: int, seq: np.array):
+        """
+        Attribute the counts since the previous stage to ``stage``,
+        measured against the bytes it produced.
+        """
+        if self.profiler is not None:
+            self.profiler.end(stage, seq.nbytes)
+
     def perform_fir(self, seq: np.array) -> np.array:
         """
         """
@@ -1777,8 +4128,7 @@ class Proc:
     def perform_decimate(self, seq: np.array) -> np.array:
         """
         """
-        dec_arr = [seq[i] for i in range(len(seq)) if i % DECIMATE == 0]
-        return dec_arr
+        return np.asarray(seq)[::DECIMATE]
 
     def perform_window(self, seq: np.array) -> np.array:
         """
@@ -1793,19 +4143,238 @@ class Proc:
         # scaling this way makes the output FFT represent the sinusoid
         # amplitude at each frequency bin.
         fft /= len(fft) - 1
+        if self.vibration is not None:
+            self.vibration.push(fft, self._meta)
+        if self.superres is not None:
+            self.superres.push(fft)
+        self._fft = fft
         return np.abs(fft)
 
 
+class SuperResolution:
+    """
+    Subspace range estimates in narrow windows of the complex spectrum,
+    for reflectors closer together than an FFT bin.
+
+    Each window's bins are transformed back to a short complex series in
+    which every reflector is a tone. The forward-backward covariance of
+    that series is updated incrementally on every sweep, and a copy is
+    handed to a worker thread every ``SUPERRES_BATCH`` sweeps. The
+    worker eigen-solves all pending windows of the same dimension in one
+    call. A window whose previous copy has not been solved yet has it
+    replaced, so a slow solve never delays the sweep that pushed it.
+    """
+
+    def __init__(
+        self, windows: List[Tuple[int, int]], method: str, ntargets: int
+    ):
+        """
+        :param windows: Inclusive (lo, hi) FFT bins of each window.
+        :param method: One of SUPERRES_METHODS.
+        :param ntargets: Reflectors expected in each window.
+        """
+        self.windows = windows
+        self.method = method
+        self.ntargets = ntargets
+        self._dims = [
+            max(ntargets + 1, (hi - lo + 1) // 2) for lo, hi in windows
+        ]
+        self._cov = [np.zeros((dim, dim), dtype=complex) for dim in self._dims]
+        self._nsweep = 0
+        self._start = clock_gettime(CLOCK_MONOTONIC)
+        # guards everything below
+        self._cond = Condition()
+        self._pending = [None] * len(windows)
+        self._estimates = [None] * len(windows)
+        self._stats = [
+            {"solves": 0, "skipped": 0, "solve_time": 0.0} for _ in windows
+        ]
+        self._quit = False
+        self._thread = Thread(target=self._worker, daemon=True)
+        self._thread.start()
+
+    def push(self, fft: np.array):
+        """
+        Update each window's covariance from one sweep's complex FFT.
+        """
+        for i, (lo, hi) in enumerate(self.windows):
+            series = np.fft.ifft(fft[lo : hi + 1])
+            snaps = np.lib.stride_tricks.sliding_window_view(
+                series, self._dims[i]
+            )
+            cov = snaps.T @ snaps.conj() / len(snaps)
+            cov = (cov + cov.conj()[::-1, ::-1]) / 2
+            self._cov[i] *= SUPERRES_FORGET
+            self._cov[i] += (1 - SUPERRES_FORGET) * cov
+
+        self._nsweep += 1
+        if self._nsweep % SUPERRES_BATCH:
+            return
+        with self._cond:
+            for i, cov in enumerate(self._cov):
+                if self._pending[i] is not None:
+                    self._stats[i]["skipped"] += 1
+                self._pending[i] = cov.copy()
+            self._cond.notify()
+
+    def _worker(self):
+        """
+        """
+        while True:
+            with self._cond:
+                while not self._quit and all(
+                    cov is None for cov in self._pending
+                ):
+                    self._cond.wait()
+                if self._quit:
+                    return
+                batch = self._pending
+                self._pending = [None] * len(self.windows)
+
+            for dim in set(self._dims):
+                idx = [
+                    i
+                    for i, cov in enumerate(batch)
+                    if cov is not None and self._dims[i] == dim
+                ]
+                if not idx:
+                    continue
+                begin = clock_gettime(CLOCK_MONOTONIC)
+                _, vecs = np.linalg.eigh(np.stack([batch[i] for i in idx]))
+                estimates = []
+                for i, vec in zip(idx, vecs):
+                    lo, hi = self.windows[i]
+                    if self.method == "music":
+                        freqs = music_freqs(
+                            vec, self.ntargets, SUPERRES_GRID * (hi - lo + 1)
+                        )
+                    else:
+                        freqs = esprit_freqs(vec, self.ntargets)
+                    estimates.append(lo + freqs * (hi - lo + 1))
+                share = (clock_gettime(CLOCK_MONOTONIC) - begin) / len(idx)
+                with self._cond:
+                    for i, bins in zip(idx, estimates):
+                        self._estimates[i] = bins
+                        self._stats[i]["solves"] += 1
+                        self._stats[i]["solve_time"] += share
+
+    def stop(self):
+        """
+        Stop the worker, abandoning any unsolved batch.
+        """
+        with self._cond:
+            self._quit = True
+            self._cond.notify()
+        self._thread.join()
+
+    def estimates(self) -> List[Optional[np.array]]:
+        """
+        Latest fractional target bins in each window, or None before
+        the window's first solve.
+        """
+        with self._cond:
+            return list(self._estimates)
+
+    def stats(self) -> List[dict]:
+        """
+        Solves, superseded batches, total solve time (s) and time since
+        creation (s) for each window.
+        """
+        elapsed = clock_gettime(CLOCK_MONOTONIC) - self._start
+        with self._cond:
+            return [dict(stat, elapsed=elapsed) for stat in self._stats]
+
+
+class SoakMonitor:
+    """
+    Periodic samples of memory, consumer backlog and sweep latency
+    during a soak test.
+    """
+
+    # key, unit and display scale of each metric in soak_report
+    METRICS = [
+        ("rss", "MB", 1e-6),
+        ("heap_used", "MB", 1e-6),
+        ("mmap_bytes", "MB", 1e-6),
+        ("skip_frac", "", 1),
+        ("latency_p50", "ms", 1e3),
+        ("latency_p99", "ms", 1e3),
+    ]
+
+    def __init__(self, interval: float, frame_bytes: int):
+        """
+        :param interval: Time between samples (s).
+        :param frame_bytes: Bytes per sweep on the link, including
+            flags and trailer.
+        """
+        self.interval = interval
+        self.frame_bytes = frame_bytes
+        self.samples = []
+        self._latency = []
+        self._next = None
+        self._last_stats = None
+
+    def add_latency(self, latency: float):
+        """
+        Record the time from a sweep's arrival to the end of its
+        processing (s).
+        """
+        self._latency.append(latency)
+
+    def poll(self, now: float, stats: Callable[[], dict]):
+        """
+        Take a sample if one is due.
+
+        :param stats: Returns the current ``Device.stats``.
+        """
+        if self._next is None:
+            self._next = now + self.interval
+            self._last_stats = stats()
+            return
+        if now < self._next:
+            return
+        self._next += self.interval
+
+        cur_stats = stats()
+        sweeps = cur_stats["sweeps"] - self._last_stats["sweeps"]
+        skipped = (
+            cur_stats["skipped_bytes"] - self._last_stats["skipped_bytes"]
+        )
+        total = skipped + sweeps * self.frame_bytes
+        self._last_stats = cur_stats
+
+        sample = memory_sample()
+        sample["skip_frac"] = skipped / total if total else 0
+        for pct in SOAK_PERCENTILES:
+            key = "latency_p{}".format(pct)
+            if self._latency:
+                sample[key] = np.percentile(self._latency, pct)
+            else:
+                sample[key] = None
+        self._latency = []
+        self.samples.append(sample)
+
+    def report(self) -> str:
+        """
+        """
+        return soak_report(self.samples, self.interval, self.METRICS)
+
+
 class Shell:
     """
     """
 
-    def __init__(self):
+    def __init__(self, bench: Optional[Tuple[Path, Path]] = None):
         """
+        :param bench: Grid and results files of a bench to run, instead
+            of the interactive prompt.
         """
         self.plot = Plot()
         self.proc = Proc()
         self.configuration = Configuration(self.plot, self.proc)
+        if bench is not None:
+            self.bench(*bench)
+            return
         self.help()
         self.prompt()
 
@@ -1863,40 +4432,136 @@ class Shell:
         elif uinput == "menu" or uinput == "m":
             write(self.configuration.display_menu(), newline=True)
             self.menu_prompt()
-        elif uinput == "run" or uinput == "r":
+        elif uinput == "list" or uinput == "l":
+            write(devices_report(list_devices()), newline=True)
+        elif uinput == "run" or uinput == "r" or uinput == "soak":
             if not self.configuration._check_parameters():
                 raise RuntimeError("Invalid configuration. Exiting.")
-            if self.configuration.spectrum_axis == "freq":
-                self.plot.min_axis_val = self.configuration.min_freq
-                self.plot.max_axis_val = self.configuration.max_freq
-            else:
-                self.plot.min_axis_val = self.configuration.min_dist
-                self.plot.max_axis_val = self.configuration.max_dist
-            min_bin = int(
-                np.round(
-                    spectrum_len(self.configuration._display_output)
-                    / nyquist_freq(self.configuration._display_output)
-                    * self.configuration.min_freq
-                )
-            )
-            max_bin = int(
-                np.round(
-                    spectrum_len(self.configuration._display_output)
-                    / nyquist_freq(self.configuration._display_output)
-                    * self.configuration.max_freq
-                )
-            )
-            self.plot.min_bin = min_bin
-            self.plot.max_bin = max_bin
-            self.plot.initialize_plot()
-            self.proc.set_last_seq()
-            self.run()
+            self.start_run(soak=uinput == "soak")
+        elif uinput == "bench" or uinput == "b":
+            write("grid file > ", newline=False)
+            grid_path = Path(self._readline()).resolve()
+            write("results file > ", newline=False)
+            results_path = Path(self._readline()).resolve()
+            self.bench(grid_path, results_path)
         else:
             write("Unrecognized input. Try again.")
             self.help()
 
         self.prompt()
 
+    def start_run(self, soak: bool = False, emulate: bool = False) -> dict:
+        """
+        Set up the plot and processing for the current, checked,
+        configuration and run it. Returns the results of ``run``.
+        """
+        if self.configuration.spectrum_axis == "freq":
+            self.plot.min_axis_val = self.configuration.min_freq
+            self.plot.max_axis_val = self.configuration.max_freq
+        else:
+            self.plot.min_axis_val = self.configuration.min_dist
+            self.plot.max_axis_val = self.configuration.max_dist
+        min_bin = int(
+            np.round(
+                spectrum_len(self.configuration._display_output)
+                / nyquist_freq(self.configuration._display_output)
+                * self.configuration.min_freq
+            )
+        )
+        max_bin = int(
+            np.round(
+                spectrum_len(self.configuration._display_output)
+                / nyquist_freq(self.configuration._display_output)
+                * self.configuration.max_freq
+            )
+        )
+        # the grid itself is allocated by run, once the memory budget
+        # is set
+        self.proc.grid = None
+        if self.configuration.dist_grid is None:
+            self.plot.axis_origin = 0
+        else:
+            start, step, stop = self.configuration.dist_grid
+            self.plot.axis_origin = start
+            min_bin, max_bin = [
+                int(
+                    np.clip(
+                        np.round((dist - start) / step),
+                        0,
+                        int(np.floor((stop - start) / step)) + 1,
+                    )
+                )
+                for dist in (
+                    self.configuration.min_dist,
+                    self.configuration.max_dist,
+                )
+            ]
+        self.plot.min_bin = min_bin
+        self.plot.max_bin = max_bin
+        if self.configuration.display_hold is not None:
+            self.plot.accumulators = [
+                DisplayAccumulator(mode, max_bin - min_bin, param)
+                for mode, param in self.configuration.display_hold
+            ]
+        self.plot.initialize_plot()
+        self.proc.set_last_seq()
+        return self.run(soak=soak, emulate=emulate)
+
+    def bench(self, grid_path: Path, results_path: Path):
+        """
+        Run every combination of the parameter values in the grid file
+        ``grid_path``, see ``parse_bench_grid``, and write a row of
+        results for each to the CSV file ``results_path``. Parameters
+        are restored afterwards.
+        """
+        try:
+            grid, emulate = parse_bench_grid(grid_path.read_text())
+            params = [
+                (self.configuration.param_for_name(name), values)
+                for name, values in grid
+            ]
+        except (OSError, ValueError, RuntimeError) as err:
+            write("Invalid bench grid: {}".format(err))
+            return
+        saved = [(param, param.getter(strval=True)) for param, _ in params]
+        rows = []
+        try:
+            with open(results_path, "w", newline="") as results_file:
+                writer = csv.writer(results_file)
+                writer.writerow([name for name, _ in grid] + BENCH_COLUMNS)
+                for point in itertools.product(
+                    *[values for _, values in params]
+                ):
+                    write(
+                        "Bench point   : "
+                        + ", ".join(
+                            "{} = {}".format(name, val)
+                            for (name, _), val in zip(grid, point)
+                        )
+                    )
+                    result = None
+                    try:
+                        for (param, _), val in zip(params, point):
+                            param.setter(val)
+                        if self.configuration._check_parameters():
+                            result = self.start_run(emulate=emulate)
+                        else:
+                            write("Invalid configuration, skipped.")
+                    except (RuntimeError, ValueError) as err:
+                        write("{}, skipped.".format(err))
+                    row = list(point) + bench_row(result)
+                    writer.writerow(row)
+                    results_file.flush()
+                    rows.append(row)
+        except OSError as err:
+            write("Failed to write bench results: {}".format(err))
+            return
+        finally:
+            for param, val in saved:
+                param.setter(val)
+        write(bench_report([name for name, _ in grid], rows), newline=False)
+        write("Results written to {}.".format(results_path.as_posix()))
+
     def help(self):
         """
         """
@@ -1906,10 +4571,21 @@ class Shell:
             + "conf : Display current configuration.\n"
             + "exit : Exit.\n"
             + "help : This display.\n"
+            + "list : List attached radars.\n"
             + (
                 "run  : Instantiate the current configuration, \n"
                 "       begin data acquisition, and display output.\n"
             )
+            + (
+                "soak : Run the current configuration against an \n"
+                "       emulated radar and report memory, backlog and \n"
+                "       latency drift.\n"
+            )
+            + (
+                "bench: Run every combination of the parameter values \n"
+                "       in a grid file and record the throughput, \n"
+                "       drops, latency and CPU use of each.\n"
+            )
             + (
                 "set  : Change the value of a configuration \n"
                 "       variable.\n"
@@ -1922,10 +4598,23 @@ class Shell:
         )
         write(help_str)
 
-    def run(self) -> None:
+    def run(self, soak: bool = False, emulate: bool = False) -> dict:
         """
+        :param soak: Drive the host stack from an emulated or replayed
+            radar at the soak overload and sample it for drift.
+        :param emulate: Drive the host stack from an emulated radar at
+            the configured sweep rate, with the configured settings.
+
+        Returns the throughput, drops, latency and CPU use of the run,
+        see ``bench_row``.
         """
+        try:
+            set_memory_budget(int(self.configuration.memory_budget * 2 ** 20))
+        except RuntimeError as err:
+            write("{}, keeping the previous one.".format(err))
         nseq = 0
+        latencies = []
+        cpu_start = process_time()
         current_time = clock_gettime(CLOCK_MONOTONIC)
         start_time = current_time
         end_time = start_time + self.configuration.time
@@ -1939,7 +4628,177 @@ class Shell:
         if self.configuration.report_avg:
             avg = []
 
-        with Device() as radar:
+        if self.configuration.vibration_dists:
+            display_output = self.configuration._display_output
+            bin_dist = dbin(
+                2 * nyquist_freq(display_output),
+                self.configuration.adf_tsweep,
+                data_sweep_len(display_output),
+                self.configuration.adf_bandwidth,
+            )
+            fcenter = (
+                self.configuration.adf_fstart
+                + self.configuration.adf_bandwidth / 2
+            )
+            self.proc.vibration = VibrationMonitor(
+                [
+                    int(np.round(dist / bin_dist))
+                    for dist in self.configuration.vibration_dists
+                ],
+                VIBRATION_WINDOW,
+                299792458 / fcenter,
+                1
+                / (
+                    self.configuration.adf_tsweep
+                    + self.configuration.adf_tdelay
+                ),
+            )
+
+        if self.configuration.chirp_correction == "apply":
+            self.proc.chirp = ChirpCorrector(
+                np.load(self.configuration.chirp_file)
+            )
+        elif self.configuration.chirp_correction == "calibrate":
+            chirp_pos_sum = np.zeros(sweep_len)
+            chirp_nseq = 0
+
+        if self.configuration.interference != "off":
+            self.proc.interference = InterferenceRepair(
+                sweep_len,
+                INTERFERENCE_WINDOW,
+                INTERFERENCE_THRESHOLD,
+                INTERFERENCE_GUARD,
+                self.configuration.interference,
+            )
+            ninterference = 0
+
+        if self.configuration.profile:
+            try:
+                self.proc.profiler = Profiler(len(PROC_PROFILE_STAGES))
+            except RuntimeError as err:
+                write(str(err))
+
+        sweep_rate = 1 / (
+            self.configuration.adf_tsweep + self.configuration.adf_tdelay
+        )
+        self.proc.plugin_sweep_rate = sweep_rate
+        for point, path, args in self.configuration.plugins:
+            if point != "sweep":
+                self.proc.add_plugin(point, path.as_posix(), args)
+
+        if self.configuration.superres_windows:
+            self.proc.superres = SuperResolution(
+                self.configuration._superres_bins(),
+                self.configuration.superres_method,
+                self.configuration.superres_targets,
+            )
+
+        zones = None
+        if self.configuration.zones:
+            zones = ZoneMonitor()
+            display_output = self.configuration._display_output
+            full_scale = 2 ** (data_nbits(self.configuration._fpga_output) - 1)
+            for lo, hi, on, off in self.configuration.zones:
+                lo_bin, hi_bin = [
+                    int(
+                        np.round(
+                            spectrum_len(display_output)
+                            / nyquist_freq(display_output)
+                            * dist_to_freq(
+                                dist,
+                                self.configuration.adf_bandwidth,
+                                self.configuration.adf_tsweep,
+                            )
+                        )
+                    )
+                    for dist in (lo, hi)
+                ]
+                if self.configuration.zone_thresholds == "cfar":
+                    scale = 1
+                else:
+                    scale = full_scale
+                zones.add_zone(
+                    lo_bin,
+                    hi_bin,
+                    scale * 10 ** (on / 20),
+                    scale * 10 ** (off / 20),
+                )
+            zones.set_cfar(self.configuration.zone_thresholds == "cfar")
+            if self.configuration._fpga_output != Data.FFT:
+                self.proc.zones = zones
+
+        if self.configuration.dist_grid is not None:
+            start, step, stop = self.configuration.dist_grid
+            self.proc.grid = DistanceGrid(
+                start, step, int(np.floor((stop - start) / step)) + 1
+            )
+            display_output = self.configuration._display_output
+            self.proc.grid_bin_dist = dbin(
+                2 * nyquist_freq(display_output),
+                self.configuration.adf_tsweep,
+                data_sweep_len(display_output),
+                self.configuration.adf_bandwidth,
+            )
+
+        stream = None
+        if self.configuration.profile_stream is not None:
+            stream = open(self.configuration.profile_stream, "wb", buffering=0)
+            stream_encoder = ProfileEncoder(STREAM_KEY_INTERVAL)
+            stream_frames = 0
+            stream_bytes = 0
+            stream_bins = 0
+
+        tbd_bin_dist = None
+        tbd_prev_bins = []
+        if self.configuration.tbd is not None:
+            window, speed, threshold = self.configuration.tbd
+            display_output = self.configuration._display_output
+            tbd_bin_dist = dbin(
+                2 * nyquist_freq(display_output),
+                self.configuration.adf_tsweep,
+                data_sweep_len(display_output),
+                self.configuration.adf_bandwidth,
+            )
+            self.proc.tbd = TrackBeforeDetect(
+                spectrum_len(display_output),
+                window,
+                speed / sweep_rate / tbd_bin_dist,
+                10 ** (threshold / 20),
+                TBD_THREADS,
+                TBD_BUDGET / sweep_rate,
+            )
+
+        self.proc.set_integration(self.configuration.integration)
+        self.proc.auto_db_span = self.configuration.auto_db_span
+        self.proc.estimate_floor = (
+            self.configuration.tbd is not None
+            or self.configuration.auto_db_span is not None
+            or zones is not None
+            and self.configuration.zone_thresholds == "cfar"
+        )
+
+        meta = SweepMeta()
+
+        soak_monitor = None
+        if soak:
+            soak_monitor = SoakMonitor(
+                self.configuration.soak_interval,
+                sweep_total_bytes(self.configuration._fpga_output),
+            )
+            soak_rate = self.configuration.soak_overload * sweep_rate
+            if self.configuration.soak_replay is None:
+                radar = Device(emulate=True, sweep_rate=soak_rate)
+            else:
+                radar = Device(
+                    replay=self.configuration.soak_replay.as_posix(),
+                    sweep_rate=soak_rate,
+                )
+        elif emulate:
+            radar = Device(emulate=True, sweep_rate=sweep_rate)
+        else:
+            radar = Device(self.configuration.serial)
+
+        with radar:
             radar.adf.fstart = self.configuration.adf_fstart
             radar.adf.tsweep = self.configuration.adf_tsweep
             radar.adf.tdelay = self.configuration.adf_tdelay
@@ -1948,7 +4807,44 @@ class Shell:
             radar.set_output(
                 data_to_fpga_output(self.configuration._fpga_output)
             )
+            radar.set_mti(self.configuration.mti_pulses)
             radar.set_adf_regs()
+            radar.set_max_overflow(self.configuration.max_overflow)
+            radar.set_profile(self.configuration.profile)
+            if zones is not None and self.proc.zones is None:
+                radar.set_zones(zones)
+            fpga_output = self.configuration._fpga_output
+            for point, path, args in self.configuration.plugins:
+                if point != "sweep":
+                    continue
+                if fpga_output == Data.FFT:
+                    spacing = 2 * nyquist_freq(fpga_output) / sweep_len
+                else:
+                    spacing = 2 * nyquist_freq(fpga_output)
+                radar.add_plugin(path.as_posix(), args, spacing, sweep_rate)
+            if not soak:
+                radar.set_watchdog(self.configuration.watchdog)
+                try:
+                    radar.set_governor(self.configuration.max_tdelay)
+                except RuntimeError as err:
+                    # an emulated radar has no ramp delay to adjust
+                    if not emulate:
+                        raise
+                    write("{} Continuing without it.".format(err))
+                if self.configuration.hotplug:
+                    # on by default, so a radar or libusb without
+                    # hotplug support only loses reattachment
+                    try:
+                        radar.set_hotplug(True)
+                    except RuntimeError as err:
+                        write("{} Continuing without it.".format(err))
+                if self.configuration.control_channel:
+                    try:
+                        radar.set_control(True)
+                    except RuntimeError as err:
+                        if not emulate:
+                            raise
+                        write("{} Continuing without it.".format(err))
 
             radar.start_acquisition(
                 log_file,
@@ -1956,10 +4852,26 @@ class Shell:
                 sweep_len,
                 self.configuration._fpga_output == Data.FFT,
             )
+            # every sweep is read into the same array
+            sweep_buf = np.empty(sweep_len, dtype=np.int32)
             while current_time < end_time:
-                sweep = radar.read_sweep(sweep_len)
+                sweep = radar.read_sweep(sweep_len, meta, sweep_buf)
+                if sweep is not None:
+                    if self.configuration.chirp_correction == "calibrate":
+                        chirp_pos_sum += fit_chirp_positions(sweep)
+                        chirp_nseq += 1
+                    proc_sweep = self.proc.process_sequence(sweep, meta)
+                    # dropped by a plugin
+                    if proc_sweep is None:
+                        sweep = None
+                    if self.proc.db_range_changed:
+                        self.plot.set_db_range(
+                            self.proc.db_min, self.proc.db_max
+                        )
+                        self.proc.db_range_changed = False
                 if sweep is not None:
-                    proc_sweep = self.proc.process_sequence(sweep)
+                    if meta.interference_p():
+                        ninterference += 1
                     clipped_sweep = proc_sweep[
                         self.plot.min_bin : self.plot.max_bin
                     ]
@@ -1967,10 +4879,146 @@ class Shell:
                     if self.configuration.report_avg:
                         avg.append(np.average(clipped_sweep))
                     nseq += 1
+                    for det in self.proc.tbd_detections:
+                        if all(
+                            abs(det["bin"] - prev) > TBD_REPORT_BINS
+                            for prev in tbd_prev_bins
+                        ):
+                            write(
+                                tbd_report(
+                                    det, meta.seq, tbd_bin_dist, sweep_rate
+                                )
+                            )
+                    tbd_prev_bins = [
+                        det["bin"] for det in self.proc.tbd_detections
+                    ]
+                    if stream is not None:
+                        frame = stream_encoder.encode(
+                            clipped_sweep,
+                            self.proc.db_min,
+                            self.proc.db_max,
+                            meta.seq,
+                        )
+                        stream.write(frame)
+                        stream_frames += 1
+                        stream_bytes += len(frame)
+                        stream_bins += len(clipped_sweep)
+                if zones is not None:
+                    for event in zones.events():
+                        write(
+                            zone_event_report(
+                                event,
+                                [
+                                    (lo, hi)
+                                    for lo, hi, _, _ in self.configuration.zones
+                                ],
+                            )
+                        )
                 current_time = clock_gettime(CLOCK_MONOTONIC)
-
+                if sweep is not None:
+                    latencies.append(current_time - meta.time)
+                if soak_monitor is not None:
+                    if sweep is not None:
+                        soak_monitor.add_latency(current_time - meta.time)
+                    soak_monitor.poll(current_time, radar.stats)
+            stats = radar.stats()
+            device_profile = radar.profile()
+        cpu_time = process_time() - cpu_start
+        proc_profile = None
+
+        write(overflow_report(stats))
+        if stats["governor_changes"]:
+            write(
+                "Sweep governor: {} ramp delay changes".format(
+                    stats["governor_changes"]
+                )
+            )
+        if stats["stalls"] or stats["detaches"]:
+            write(recovery_report(stats))
+        if soak_monitor is not None:
+            write(
+                "Resyncs       : {} ({} bytes skipped)".format(
+                    stats["resyncs"], stats["skipped_bytes"]
+                )
+            )
+            write(soak_monitor.report(), newline=False)
         if self.configuration.report_avg:
             write(avg_value(np.average(avg)))
+        if self.proc.vibration is not None:
+            write(
+                vibration_report(
+                    self.configuration.vibration_dists,
+                    self.proc.vibration.peaks(),
+                ),
+                newline=False,
+            )
+            self.proc.vibration = None
+        self.proc.chirp = None
+        # frees the grid's pool buffers, so the next run can change the
+        # memory budget
+        self.proc.grid = None
+        if self.proc.interference is not None:
+            write(interference_report(ninterference, nseq))
+            self.proc.interference = None
+        self.proc.clear_plugins()
+        self.proc.set_integration(None)
+        self.plot.accumulators = []
+        if self.proc.auto_db_span is not None:
+            self.proc.auto_db_span = None
+            self.proc.reset_auto_db_range()
+            self.proc.db_min = self.configuration.db_min
+            self.proc.db_max = self.configuration.db_max
+            self.plot.db_min = self.configuration.db_min
+            self.plot.db_max = self.configuration.db_max
+        self.proc.estimate_floor = False
+        if self.proc.superres is not None:
+            self.proc.superres.stop()
+            write(
+                superres_report(
+                    self.configuration.superres_windows,
+                    self.proc.superres.estimates(),
+                    self.proc.superres.stats(),
+                    self.configuration._superres_bin_dist(),
+                    sweep_rate,
+                ),
+                newline=False,
+            )
+            self.proc.superres = None
+        if zones is not None:
+            write(zone_latency_report(zones.latency()))
+            self.proc.zones = None
+        if self.configuration.memory_budget or self.configuration.profile:
+            write(memory_report(memory_stats()), newline=False)
+        if stream is not None:
+            stream.close()
+            write(
+                profile_stream_report(stream_frames, stream_bytes, stream_bins)
+            )
+        if self.proc.tbd is not None:
+            write(tbd_stats_report(self.proc.tbd.stats(), self.proc.tbd.nrates))
+            self.proc.tbd = None
+            self.proc.tbd_detections = []
+        if stats["dropped_plugin"]:
+            write("Plugin drops  : {} sweeps".format(stats["dropped_plugin"]))
+        if device_profile is not None:
+            write(
+                profile_report(DEVICE_PROFILE_STAGES, device_profile),
+                newline=False,
+            )
+        if self.proc.profiler is not None:
+            proc_profile = self.proc.profiler.counts()
+            write(
+                profile_report(PROC_PROFILE_STAGES, proc_profile),
+                newline=False,
+            )
+            self.proc.profiler = None
+        if self.configuration.chirp_correction == "calibrate" and chirp_nseq:
+            np.save(self.configuration.chirp_file, chirp_pos_sum / chirp_nseq)
+            write(
+                "Chirp calibration from {} sweeps saved to {}.".format(
+                    chirp_nseq, self.configuration.chirp_file.as_posix()
+                )
+            )
         write(plot_rate(nseq, current_time - start_time))
         tbytes = sweep_total_bytes(self.configuration._fpga_output)
         write(
@@ -1978,6 +5026,32 @@ class Shell:
             newline=True,
         )
 
+        elapsed = current_time - start_time
+        result = {
+            "sweep_rate": soak_rate if soak else sweep_rate,
+            "achieved_rate": nseq / elapsed,
+            "usb_mbps": (stats["sweeps"] * tbytes + stats["skipped_bytes"])
+            / elapsed
+            / 1e6,
+            # sweeps parsed but not delivered, and those lost to resyncs
+            "dropped": stats["sweeps"]
+            - nseq
+            + stats["skipped_bytes"] // tbytes,
+            "cpu": cpu_time / elapsed,
+        }
+        for pct in SOAK_PERCENTILES:
+            key = "latency_p{}".format(pct)
+            result[key] = np.percentile(latencies, pct) if latencies else None
+        for stages, counts in (
+            (DEVICE_PROFILE_STAGES, device_profile),
+            (PROC_PROFILE_STAGES, proc_profile),
+        ):
+            for i, stage in enumerate(stages):
+                result[stage] = (
+                    counts[i]["cycles"] / nseq if counts and nseq else None
+                )
+        return result
+
     def _readline(self) -> str:
         """
         """
@@ -1985,4 +5059,7 @@ class Shell:
 
 
 if __name__ == "__main__":
-    shell = Shell()
+    if len(sys.argv) == 4 and sys.argv[1] == "bench":
+        shell = Shell(bench=(Path(sys.argv[2]), Path(sys.argv[3])))
+    else:
+        shell = Shell()
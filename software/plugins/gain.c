@@ -0,0 +1,56 @@
+#include "fmcw_plugin.h"
+#include <stdlib.h>
+
+/* Example plugin scaling each sample by the gain given as its
+ * argument (1 by default). It works in place at every point. */
+
+struct Gain {
+	int type;
+	int len;
+	double gain;
+};
+
+static int gain_init(void **state, const char *args, const struct FmcwFormat *in,
+		     struct FmcwFormat *out)
+{
+	struct Gain *gain = malloc(sizeof(struct Gain));
+	if (gain == NULL) {
+		return -1;
+	}
+	gain->type = in->type;
+	gain->len = in->len;
+	gain->gain = *args ? atof(args) : 1;
+	*state = gain;
+	return 0;
+}
+
+static int gain_process(void *state, const void *in, void *out, struct SweepMeta *meta)
+{
+	struct Gain *gain = state;
+	if (gain->type == FMCW_SAMPLE_INT32) {
+		const int32_t *src = in;
+		int32_t *dst = out;
+		for (int i = 0; i < gain->len; ++i) {
+			dst[i] = (int32_t)(src[i] * gain->gain);
+		}
+	} else {
+		const double *src = in;
+		double *dst = out;
+		for (int i = 0; i < gain->len; ++i) {
+			dst[i] = src[i] * gain->gain;
+		}
+	}
+	return FMCW_PLUGIN_OK;
+}
+
+static void gain_finish(void *state) { free(state); }
+
+static const struct FmcwPlugin plugin = {
+	.abi_version = FMCW_PLUGIN_ABI_VERSION,
+	.name = "gain",
+	.init = gain_init,
+	.process = gain_process,
+	.finish = gain_finish,
+};
+
+const struct FmcwPlugin *fmcw_plugin_entry(void) { return &plugin; }
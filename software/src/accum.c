@@ -0,0 +1,119 @@
+#include "accum.h"
+#include "pool.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRUE 1
+#define FALSE 0
+
+struct Accumulator {
+	int mode;
+	int len;
+	double param;
+	double *trace;
+	/* time of the last update, negative before the first */
+	double last;
+};
+
+/**
+ * Hold the maximum of @trace and @in, with @trace first lowered by
+ * @decay.
+ */
+static void max_hold(double *restrict trace, const double *restrict in, int len, double decay);
+/**
+ * Hold the minimum of @trace and @in, with @trace first raised by
+ * @decay.
+ */
+static void min_hold(double *restrict trace, const double *restrict in, int len, double decay);
+/**
+ * Move @trace a fraction @alpha of the way toward @in.
+ */
+static void ema(double *restrict trace, const double *restrict in, int len, double alpha);
+
+struct Accumulator *accum_new(int mode, int len, double param)
+{
+	if (mode < ACCUM_MAX_HOLD || mode > ACCUM_EMA || len <= 0 || param < 0 ||
+	    (mode == ACCUM_EMA && param == 0)) {
+		return NULL;
+	}
+	struct Accumulator *acc = pool_calloc(POOL_DSP, 1, sizeof(struct Accumulator));
+	if (acc == NULL) {
+		return NULL;
+	}
+	acc->trace = pool_alloc(POOL_DSP, len * sizeof(double));
+	if (acc->trace == NULL) {
+		pool_free(acc);
+		return NULL;
+	}
+	acc->mode = mode;
+	acc->len = len;
+	acc->param = param;
+	acc->last = -1;
+	return acc;
+}
+
+void accum_free(struct Accumulator *acc)
+{
+	if (acc == NULL) {
+		return;
+	}
+	pool_free(acc->trace);
+	pool_free(acc);
+}
+
+void accum_update(struct Accumulator *acc, const double *in, double now)
+{
+	if (acc->last < 0) {
+		memcpy(acc->trace, in, acc->len * sizeof(double));
+		acc->last = now;
+		return;
+	}
+	double dt = now > acc->last ? now - acc->last : 0;
+	acc->last = now;
+
+	switch (acc->mode) {
+	case ACCUM_MAX_HOLD:
+		max_hold(acc->trace, in, acc->len, acc->param * dt);
+		break;
+	case ACCUM_MIN_HOLD:
+		min_hold(acc->trace, in, acc->len, acc->param * dt);
+		break;
+	default:
+		ema(acc->trace, in, acc->len, -expm1(-dt / acc->param));
+	}
+}
+
+int accum_trace(const struct Accumulator *acc, double *out)
+{
+	if (acc->last < 0) {
+		return FALSE;
+	}
+	memcpy(out, acc->trace, acc->len * sizeof(double));
+	return TRUE;
+}
+
+void accum_reset(struct Accumulator *acc) { acc->last = -1; }
+
+void max_hold(double *restrict trace, const double *restrict in, int len, double decay)
+{
+	for (int i = 0; i < len; ++i) {
+		double held = trace[i] - decay;
+		trace[i] = in[i] > held ? in[i] : held;
+	}
+}
+
+void min_hold(double *restrict trace, const double *restrict in, int len, double decay)
+{
+	for (int i = 0; i < len; ++i) {
+		double held = trace[i] + decay;
+		trace[i] = in[i] < held ? in[i] : held;
+	}
+}
+
+void ema(double *restrict trace, const double *restrict in, int len, double alpha)
+{
+	for (int i = 0; i < len; ++i) {
+		trace[i] += alpha * (in[i] - trace[i]);
+	}
+}
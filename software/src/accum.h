@@ -0,0 +1,49 @@
+#ifndef __ACCUM_H__
+#define __ACCUM_H__
+
+/* Accumulation modes. Max-hold keeps the highest level seen in each
+ * bin and min-hold the lowest, both relaxing toward the current sweep
+ * at a configurable rate. The exponential average smooths each bin
+ * with a configurable time constant. */
+#define ACCUM_MAX_HOLD 0
+#define ACCUM_MIN_HOLD 1
+#define ACCUM_EMA 2
+
+/** Display accumulator.
+ *
+ * Maintains one trace over the spectra added to it, so that the plot
+ * can show held or smoothed traces while it only renders at its frame
+ * rate. Each update is a single branch-free pass over the bins, which
+ * the compiler vectorizes.
+ *
+ * Rates are per second rather than per sweep, so a trace looks the
+ * same whatever the sweep rate. For the holds, @param is the rate in
+ * units per second (e.g. dB/s) at which a held level decays toward the
+ * current sweep, and 0 holds it indefinitely. For the exponential
+ * average, @param is the time constant in seconds.
+ */
+struct Accumulator;
+
+/** Accumulate spectra of @len bins in @mode (ACCUM_*).
+ *
+ * Returns NULL if the arguments are invalid or on failure.
+ */
+struct Accumulator *accum_new(int mode, int len, double param);
+
+void accum_free(struct Accumulator *acc);
+
+/** Add the spectrum @in, received at @now (s).
+ */
+void accum_update(struct Accumulator *acc, const double *in, double now);
+
+/** Copy the trace into @out.
+ *
+ * Returns FALSE if nothing has been added since the last reset.
+ */
+int accum_trace(const struct Accumulator *acc, double *out);
+
+/** Start over with the next spectrum.
+ */
+void accum_reset(struct Accumulator *acc);
+
+#endif
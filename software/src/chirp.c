@@ -0,0 +1,130 @@
+#include "chirp.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#define TAPS 4
+#define ALIGN 32
+
+struct Chirp {
+	int len;
+	/* index of the first of the 4 input samples for each output */
+	int32_t *idx;
+	/* interpolation weights, one array per tap */
+	double *coeff[TAPS];
+};
+
+/**
+ * Allocate @nbytes rounded up to a multiple of ALIGN.
+ */
+static void *alloc_aligned(size_t nbytes);
+
+struct Chirp *chirp_new(const double *pos, int len)
+{
+	if (len < TAPS) {
+		return NULL;
+	}
+
+	struct Chirp *chirp = calloc(1, sizeof(struct Chirp));
+	if (chirp == NULL) {
+		return NULL;
+	}
+	chirp->len = len;
+	chirp->idx = alloc_aligned(len * sizeof(int32_t));
+	for (int j = 0; j < TAPS; ++j) {
+		chirp->coeff[j] = alloc_aligned(len * sizeof(double));
+	}
+	if (chirp->idx == NULL || chirp->coeff[0] == NULL || chirp->coeff[1] == NULL ||
+	    chirp->coeff[2] == NULL || chirp->coeff[3] == NULL) {
+		chirp_free(chirp);
+		return NULL;
+	}
+
+	for (int k = 0; k < len; ++k) {
+		double p = pos[k];
+		if (p < 0) {
+			p = 0;
+		} else if (p > len - 1) {
+			p = len - 1;
+		}
+		/* keep all 4 taps inside the sweep */
+		int i = (int)floor(p);
+		if (i < 1) {
+			i = 1;
+		} else if (i > len - 3) {
+			i = len - 3;
+		}
+		double mu = p - i;
+
+		chirp->idx[k] = i - 1;
+		chirp->coeff[0][k] = -mu * (mu - 1) * (mu - 2) / 6;
+		chirp->coeff[1][k] = (mu + 1) * (mu - 1) * (mu - 2) / 2;
+		chirp->coeff[2][k] = -(mu + 1) * mu * (mu - 2) / 2;
+		chirp->coeff[3][k] = (mu + 1) * mu * (mu - 1) / 6;
+	}
+
+	return chirp;
+}
+
+void chirp_free(struct Chirp *chirp)
+{
+	if (chirp == NULL) {
+		return;
+	}
+	free(chirp->idx);
+	for (int j = 0; j < TAPS; ++j) {
+		free(chirp->coeff[j]);
+	}
+	free(chirp);
+}
+
+int chirp_len(struct Chirp *chirp) { return chirp->len; }
+
+void chirp_apply(struct Chirp *chirp, const double *restrict in, double *restrict out)
+{
+	const int32_t *idx = chirp->idx;
+	const double *c0 = chirp->coeff[0];
+	const double *c1 = chirp->coeff[1];
+	const double *c2 = chirp->coeff[2];
+	const double *c3 = chirp->coeff[3];
+	int k = 0;
+
+#ifdef __AVX2__
+	for (; k + 4 <= chirp->len; k += 4) {
+		__m128i base = _mm_load_si128((const __m128i *)(idx + k));
+		__m256d x0 = _mm256_i32gather_pd(in, base, sizeof(double));
+		__m256d x1 = _mm256_i32gather_pd(in + 1, base, sizeof(double));
+		__m256d x2 = _mm256_i32gather_pd(in + 2, base, sizeof(double));
+		__m256d x3 = _mm256_i32gather_pd(in + 3, base, sizeof(double));
+		__m256d acc = _mm256_mul_pd(x0, _mm256_load_pd(c0 + k));
+#ifdef __FMA__
+		acc = _mm256_fmadd_pd(x1, _mm256_load_pd(c1 + k), acc);
+		acc = _mm256_fmadd_pd(x2, _mm256_load_pd(c2 + k), acc);
+		acc = _mm256_fmadd_pd(x3, _mm256_load_pd(c3 + k), acc);
+#else
+		acc = _mm256_add_pd(acc, _mm256_mul_pd(x1, _mm256_load_pd(c1 + k)));
+		acc = _mm256_add_pd(acc, _mm256_mul_pd(x2, _mm256_load_pd(c2 + k)));
+		acc = _mm256_add_pd(acc, _mm256_mul_pd(x3, _mm256_load_pd(c3 + k)));
+#endif
+		_mm256_storeu_pd(out + k, acc);
+	}
+#endif
+
+	for (; k < chirp->len; ++k) {
+		const double *x = in + idx[k];
+		out[k] = x[0] * c0[k] + x[1] * c1[k] + x[2] * c2[k] + x[3] * c3[k];
+	}
+}
+
+void *alloc_aligned(size_t nbytes)
+{
+	size_t rem = nbytes % ALIGN;
+	if (rem) {
+		nbytes += ALIGN - rem;
+	}
+	return aligned_alloc(ALIGN, nbytes);
+}
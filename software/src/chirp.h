@@ -0,0 +1,35 @@
+#ifndef __CHIRP_H__
+#define __CHIRP_H__
+
+/** Chirp nonlinearity correction.
+ *
+ * A nonlinear frequency ramp warps the beat signal in time. Given the
+ * (fractional) input sample position at which each output sample
+ * should be taken, the sweep is resampled onto a linear ramp with
+ * 4-point Lagrange interpolation. The interpolation indices and
+ * weights are computed once, so applying the correction is a fixed
+ * 4-tap gather-multiply-add per output sample.
+ */
+struct Chirp;
+
+/** Build the resampling table.
+ *
+ * @pos holds @len input positions, one per output sample, in units
+ * of input samples. Positions are clamped to the sweep.
+ *
+ * Returns NULL on failure.
+ */
+struct Chirp *chirp_new(const double *pos, int len);
+
+void chirp_free(struct Chirp *chirp);
+
+/** Number of samples in each sweep the table was built for.
+ */
+int chirp_len(struct Chirp *chirp);
+
+/** Resample @in into @out. Both must hold chirp_len() samples and
+ * must not overlap.
+ */
+void chirp_apply(struct Chirp *chirp, const double *in, double *out);
+
+#endif
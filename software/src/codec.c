@@ -0,0 +1,366 @@
+#include "codec.h"
+#include "pool.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRUE 1
+#define FALSE 0
+
+/* Rice parameters are coded in this many bits. The largest, 7, codes
+ * any zigzagged delta in at most 9 bits. */
+#define RICE_BITS 3
+#define RICE_MAX 7
+
+struct CodecEncoder {
+	int key_interval;
+	/* frames since the last key frame, negative to force one */
+	int since_key;
+	uint8_t counter;
+	/* the last frame, as the decoder reconstructs it */
+	int len;
+	int16_t db_min;
+	int16_t db_max;
+	uint8_t *prev;
+	uint8_t *cur;
+};
+
+struct CodecDecoder {
+	/* the last frame decoded, or len 0 if there is none */
+	int len;
+	uint8_t counter;
+	int16_t db_min;
+	int16_t db_max;
+	uint8_t *prev;
+	int cap;
+};
+
+struct BitWriter {
+	uint8_t *buf;
+	size_t pos;
+	uint64_t acc;
+	int nacc;
+};
+
+struct BitReader {
+	const uint8_t *buf;
+	size_t size;
+	size_t pos;
+	uint64_t acc;
+	int nacc;
+};
+
+/**
+ * Append the low @n bits of @val, n <= 32.
+ */
+static void put_bits(struct BitWriter *bw, uint32_t val, int n);
+/**
+ * Write out any partial byte. Returns the bytes written.
+ */
+static size_t flush_bits(struct BitWriter *bw);
+/**
+ * Read @n bits, n <= 32, into @val. Returns FALSE past the end.
+ */
+static int get_bits(struct BitReader *br, int n, uint32_t *val);
+/**
+ * Rice parameter that codes the @n values in @vals in the fewest bits.
+ */
+static int best_rice(const uint8_t *vals, int n);
+/**
+ * Tenths of a dB in an int16, or FALSE if @db is out of range.
+ */
+static int tenths(double db, int16_t *out);
+static void put_le16(uint8_t *buf, uint16_t val);
+static void put_le32(uint8_t *buf, uint32_t val);
+static uint16_t get_le16(const uint8_t *buf);
+static uint32_t get_le32(const uint8_t *buf);
+
+size_t codec_max_size(int len)
+{
+	int nblocks = (len + CODEC_BLOCK - 1) / CODEC_BLOCK;
+	return CODEC_HEADER_LEN + ((size_t)len * (RICE_MAX + 2) + nblocks * RICE_BITS + 7) / 8;
+}
+
+struct CodecEncoder *codec_encoder_new(int key_interval)
+{
+	if (key_interval <= 0) {
+		return NULL;
+	}
+	struct CodecEncoder *enc = pool_calloc(POOL_DSP, 1, sizeof(struct CodecEncoder));
+	if (enc == NULL) {
+		return NULL;
+	}
+	enc->key_interval = key_interval;
+	enc->since_key = -1;
+	return enc;
+}
+
+void codec_encoder_free(struct CodecEncoder *enc)
+{
+	if (enc == NULL) {
+		return;
+	}
+	pool_free(enc->prev);
+	pool_free(enc->cur);
+	pool_free(enc);
+}
+
+void codec_encoder_reset(struct CodecEncoder *enc) { enc->since_key = -1; }
+
+size_t codec_encode(struct CodecEncoder *enc, const double *db, int len, double db_min,
+		    double db_max, uint32_t seq, uint8_t *out)
+{
+	int16_t qmin;
+	int16_t qmax;
+	if (len <= 0 || len > CODEC_MAX_LEN || !tenths(db_min, &qmin) || !tenths(db_max, &qmax) ||
+	    qmax <= qmin) {
+		return 0;
+	}
+	if (len != enc->len) {
+		uint8_t *prev = pool_realloc(POOL_DSP, enc->prev, len);
+		uint8_t *cur = prev ? pool_realloc(POOL_DSP, enc->cur, len) : NULL;
+		if (prev) {
+			enc->prev = prev;
+		}
+		if (cur == NULL) {
+			enc->len = 0;
+			return 0;
+		}
+		enc->cur = cur;
+		enc->len = len;
+		enc->since_key = -1;
+	}
+	if (qmin != enc->db_min || qmax != enc->db_max) {
+		enc->db_min = qmin;
+		enc->db_max = qmax;
+		enc->since_key = -1;
+	}
+	int key = enc->since_key < 0 || enc->since_key + 1 >= enc->key_interval;
+	enc->since_key = key ? 0 : enc->since_key + 1;
+
+	double lo = qmin / 10.0;
+	double hi = qmax / 10.0;
+	double scale = (CODEC_LEVELS - 1) / (hi - lo);
+	for (int i = 0; i < len; ++i) {
+		double val = db[i] < lo ? lo : db[i] > hi ? hi : db[i];
+		enc->cur[i] = (uint8_t)lround((val - lo) * scale);
+	}
+	/* zigzagged deltas, in place in prev, which becomes cur below */
+	for (int i = 0; i < len; ++i) {
+		int8_t delta = (int8_t)(enc->cur[i] - (key ? 0 : enc->prev[i]));
+		enc->prev[i] = delta >= 0 ? 2 * delta : -2 * delta - 1;
+	}
+
+	struct BitWriter bw = {.buf = out + CODEC_HEADER_LEN};
+	for (int start = 0; start < len; start += CODEC_BLOCK) {
+		int n = len - start < CODEC_BLOCK ? len - start : CODEC_BLOCK;
+		const uint8_t *vals = enc->prev + start;
+		int k = best_rice(vals, n);
+		put_bits(&bw, k, RICE_BITS);
+		for (int i = 0; i < n; ++i) {
+			int q = vals[i] >> k;
+			/* q ones and a zero, at most 256 bits */
+			while (q >= 32) {
+				put_bits(&bw, 0xFFFFFFFF, 32);
+				q -= 32;
+			}
+			put_bits(&bw, (1u << q) - 1, q + 1);
+			put_bits(&bw, vals[i] & ((1u << k) - 1), k);
+		}
+	}
+	size_t payload = flush_bits(&bw);
+
+	uint8_t *tmp = enc->prev;
+	enc->prev = enc->cur;
+	enc->cur = tmp;
+
+	out[0] = CODEC_MAGIC;
+	out[1] = CODEC_VERSION;
+	out[2] = key ? CODEC_FLAG_KEY : 0;
+	out[3] = enc->counter++;
+	put_le16(out + 4, len);
+	put_le16(out + 6, payload);
+	put_le32(out + 8, seq);
+	put_le16(out + 12, (uint16_t)qmin);
+	put_le16(out + 14, (uint16_t)qmax);
+	return CODEC_HEADER_LEN + payload;
+}
+
+struct CodecDecoder *codec_decoder_new()
+{
+	return pool_calloc(POOL_DSP, 1, sizeof(struct CodecDecoder));
+}
+
+void codec_decoder_free(struct CodecDecoder *dec)
+{
+	if (dec == NULL) {
+		return;
+	}
+	pool_free(dec->prev);
+	pool_free(dec);
+}
+
+size_t codec_peek(const uint8_t *buf, size_t size, struct CodecFrame *frame)
+{
+	if (size < CODEC_HEADER_LEN || buf[0] != CODEC_MAGIC || buf[1] != CODEC_VERSION) {
+		return 0;
+	}
+	frame->flags = buf[2];
+	frame->counter = buf[3];
+	frame->len = get_le16(buf + 4);
+	frame->seq = get_le32(buf + 8);
+	frame->db_min = (int16_t)get_le16(buf + 12) / 10.0;
+	frame->db_max = (int16_t)get_le16(buf + 14) / 10.0;
+	if (frame->len == 0 || frame->db_max <= frame->db_min) {
+		return 0;
+	}
+	return CODEC_HEADER_LEN + get_le16(buf + 6);
+}
+
+int codec_decode(struct CodecDecoder *dec, const uint8_t *buf, size_t size, double *out,
+		 int maxlen, struct CodecFrame *frame)
+{
+	struct CodecFrame hdr;
+	size_t total = codec_peek(buf, size, &hdr);
+	if (total == 0 || total > size || hdr.len > maxlen) {
+		return -1;
+	}
+	if (frame) {
+		*frame = hdr;
+	}
+	int len = hdr.len;
+	int key = hdr.flags & CODEC_FLAG_KEY;
+	int16_t qmin = (int16_t)get_le16(buf + 12);
+	int16_t qmax = (int16_t)get_le16(buf + 14);
+	if (!key && (dec->len != len || (uint8_t)(dec->counter + 1) != hdr.counter ||
+		     dec->db_min != qmin || dec->db_max != qmax)) {
+		/* wait for a key frame */
+		dec->len = 0;
+		return 0;
+	}
+	if (len > dec->cap) {
+		uint8_t *prev = pool_realloc(POOL_DSP, dec->prev, len);
+		if (prev == NULL) {
+			return -1;
+		}
+		dec->prev = prev;
+		dec->cap = len;
+	}
+
+	struct BitReader br = {.buf = buf + CODEC_HEADER_LEN, .size = total - CODEC_HEADER_LEN};
+	for (int start = 0; start < len; start += CODEC_BLOCK) {
+		int n = len - start < CODEC_BLOCK ? len - start : CODEC_BLOCK;
+		uint32_t k;
+		if (!get_bits(&br, RICE_BITS, &k)) {
+			dec->len = 0;
+			return -1;
+		}
+		for (int i = start; i < start + n; ++i) {
+			uint32_t bit;
+			uint32_t q = 0;
+			uint32_t rem;
+			while (get_bits(&br, 1, &bit) && bit) {
+				++q;
+			}
+			if (!get_bits(&br, k, &rem) || (q << k | rem) >= CODEC_LEVELS) {
+				dec->len = 0;
+				return -1;
+			}
+			uint32_t zz = q << k | rem;
+			int delta = zz & 1 ? -(int)(zz >> 1) - 1 : (int)(zz >> 1);
+			dec->prev[i] = (uint8_t)((key ? 0 : dec->prev[i]) + delta);
+		}
+	}
+
+	dec->len = len;
+	dec->counter = hdr.counter;
+	dec->db_min = qmin;
+	dec->db_max = qmax;
+	double step = (hdr.db_max - hdr.db_min) / (CODEC_LEVELS - 1);
+	for (int i = 0; i < len; ++i) {
+		out[i] = hdr.db_min + dec->prev[i] * step;
+	}
+	return len;
+}
+
+void put_bits(struct BitWriter *bw, uint32_t val, int n)
+{
+	if (n == 0) {
+		return;
+	}
+	bw->acc |= (uint64_t)(val & (0xFFFFFFFFu >> (32 - n))) << bw->nacc;
+	bw->nacc += n;
+	while (bw->nacc >= 8) {
+		bw->buf[bw->pos++] = bw->acc & 0xFF;
+		bw->acc >>= 8;
+		bw->nacc -= 8;
+	}
+}
+
+size_t flush_bits(struct BitWriter *bw)
+{
+	if (bw->nacc > 0) {
+		bw->buf[bw->pos++] = bw->acc & 0xFF;
+		bw->acc = 0;
+		bw->nacc = 0;
+	}
+	return bw->pos;
+}
+
+int get_bits(struct BitReader *br, int n, uint32_t *val)
+{
+	while (br->nacc < n) {
+		if (br->pos == br->size) {
+			return FALSE;
+		}
+		br->acc |= (uint64_t)br->buf[br->pos++] << br->nacc;
+		br->nacc += 8;
+	}
+	*val = n ? br->acc & (0xFFFFFFFFu >> (32 - n)) : 0;
+	br->acc >>= n;
+	br->nacc -= n;
+	return TRUE;
+}
+
+int best_rice(const uint8_t *vals, int n)
+{
+	int best = 0;
+	int best_bits = -1;
+	for (int k = 0; k <= RICE_MAX; ++k) {
+		int bits = n * (k + 1);
+		for (int i = 0; i < n; ++i) {
+			bits += vals[i] >> k;
+		}
+		if (best_bits < 0 || bits < best_bits) {
+			best = k;
+			best_bits = bits;
+		}
+	}
+	return best;
+}
+
+int tenths(double db, int16_t *out)
+{
+	double val = round(db * 10);
+	if (!(val >= INT16_MIN && val <= INT16_MAX)) {
+		return FALSE;
+	}
+	*out = (int16_t)val;
+	return TRUE;
+}
+
+void put_le16(uint8_t *buf, uint16_t val)
+{
+	buf[0] = val & 0xFF;
+	buf[1] = val >> 8;
+}
+
+void put_le32(uint8_t *buf, uint32_t val)
+{
+	put_le16(buf, val & 0xFFFF);
+	put_le16(buf + 2, val >> 16);
+}
+
+uint16_t get_le16(const uint8_t *buf) { return buf[0] | buf[1] << 8; }
+
+uint32_t get_le32(const uint8_t *buf) { return get_le16(buf) | (uint32_t)get_le16(buf + 2) << 16; }
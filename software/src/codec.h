@@ -0,0 +1,119 @@
+#ifndef __CODEC_H__
+#define __CODEC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Bytes of the frame header. */
+#define CODEC_HEADER_LEN 16
+/* First byte of every frame, followed by the version. */
+#define CODEC_MAGIC 0xD8
+#define CODEC_VERSION 1
+/* Header flag of frames coded without reference to the last one. */
+#define CODEC_FLAG_KEY 0x1
+/* Levels of a quantized bin. */
+#define CODEC_LEVELS 256
+/* Bins sharing one Rice parameter. */
+#define CODEC_BLOCK 32
+/* Longest profile, so that the payload size fits its header field. */
+#define CODEC_MAX_LEN 32768
+
+/** Header of an encoded frame.
+ */
+struct CodecFrame {
+	/* CODEC_FLAG_* bits. */
+	uint8_t flags;
+	/* Bins in the profile. */
+	int len;
+	/* Sequence number of the sweep, modulo 2^32. */
+	uint32_t seq;
+	/* Frames encoded before this one, modulo 256. A delta frame
+	 * only decodes after the frame before it. */
+	uint8_t counter;
+	/* dB range the profile was quantized within, in steps of 0.1. */
+	double db_min;
+	double db_max;
+};
+
+/** Compact encoding of dB range profiles for remote displays.
+ *
+ * Each bin is quantized to CODEC_LEVELS levels spanning the display's
+ * dB range, which is all a plot can resolve. Consecutive sweeps are
+ * similar, so every frame except key frames codes the difference from
+ * the previous one, modulo CODEC_LEVELS and zigzag mapped so that small
+ * changes of either sign are small numbers. These are Rice coded in
+ * blocks of CODEC_BLOCK bins, each with the parameter that minimizes
+ * its size, so flat stretches cost about a bit per bin and noise a few.
+ *
+ * A frame is a CODEC_HEADER_LEN byte little-endian header followed by
+ * the payload:
+ *
+ *   0   CODEC_MAGIC
+ *   1   CODEC_VERSION
+ *   2   flags
+ *   3   frame counter, modulo 256
+ *   4   len (uint16)
+ *   6   payload bytes (uint16)
+ *   8   seq (uint32)
+ *   12  db_min and db_max in tenths of a dB (int16 each)
+ *
+ * The payload holds, for each block, the Rice parameter in 3 bits and
+ * then each bin's quotient in unary, as ones ended by a zero, and
+ * remainder in that many bits, packed from the least significant bit
+ * of each byte.
+ *
+ * Key frames are sent every @key_interval frames and whenever the
+ * length or dB range changes, so a decoder that joins late or loses a
+ * frame recovers at the next one.
+ */
+struct CodecEncoder;
+struct CodecDecoder;
+
+/** Largest encoding of a profile of @len bins, header included.
+ */
+size_t codec_max_size(int len);
+
+/** Returns NULL if the arguments are invalid or on failure.
+ */
+struct CodecEncoder *codec_encoder_new(int key_interval);
+
+void codec_encoder_free(struct CodecEncoder *enc);
+
+/** Encode the profile @db of @len bins, whose levels are clamped to
+ * [@db_min, @db_max] rounded to 0.1 dB, into @out, which must hold codec_max_size(@len)
+ * bytes.
+ *
+ * Returns the number of bytes written, or 0 if the arguments are
+ * invalid or on failure.
+ */
+size_t codec_encode(struct CodecEncoder *enc, const double *db, int len, double db_min,
+		    double db_max, uint32_t seq, uint8_t *out);
+
+/** Force the next frame to be a key frame.
+ */
+void codec_encoder_reset(struct CodecEncoder *enc);
+
+/** Returns NULL on failure.
+ */
+struct CodecDecoder *codec_decoder_new();
+
+void codec_decoder_free(struct CodecDecoder *dec);
+
+/** Read the header of the frame in @buf of @size bytes into @frame.
+ *
+ * Returns the size of the whole frame, or 0 if @buf does not start
+ * with a valid header.
+ */
+size_t codec_peek(const uint8_t *buf, size_t size, struct CodecFrame *frame);
+
+/** Decode the frame in @buf of @size bytes into the @maxlen bins of
+ * @out, in dB, and its header into @frame, which may be NULL.
+ *
+ * Returns the number of bins, 0 if the frame is a delta and the decoder
+ * has not seen the previous frame, or -1 if the frame is malformed or
+ * does not fit in @out.
+ */
+int codec_decode(struct CodecDecoder *dec, const uint8_t *buf, size_t size, double *out,
+		 int maxlen, struct CodecFrame *frame);
+
+#endif
@@ -1,3 +1,12 @@
+#include "device.h"
+#include "discovery.h"
+#include "governor.h"
+#include "jtag.h"
+#include "noise.h"
+#include "perf.h"
+#include "plugin.h"
+#include "pool.h"
+#include "sweep.h"
 #include "vector.h"
 #include <fcntl.h>
 #include <ftdi.h>
@@ -7,7 +16,10 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
 #include <time.h>
+#include <unistd.h>
 
 #define VENDOR_ID 0x0403
 #define MODEL_ID 0x6010
@@ -22,9 +34,46 @@
 #define START_FLAG 0xFF
 #define STOP_FLAG 0x8F
 #define NS_TO_S 1e-9
+#define TRAILER_WORDS 1
+#define CMD_START 0x00
+#define CMD_CHAN_A 0x01
+#define CMD_OUTPUT 0x03
+#define CMD_MTI 0x04
+#define CMD_ADF 0x80
+#define CMD_STOP 0xFF
+#define ADF_REG_MASK 0x07
+#define ADF_REG_BYTES 4
+#define ADF_NUM_REGS 8
+/* ADF4158 register 7 holds the number of delay clock periods between
+ * ramps */
+#define ADF_DELAY_REG 7
+#define ADF_DEL_STEPS_LSB 3
+#define ADF_DEL_STEPS_MASK 0xFFF
+/* Channel A, channel B, output, pulse canceller and ADF registers, in
+ * replay order. */
+#define CMD_SLOT_ADF 4
+#define CMD_NUM_SLOTS (CMD_SLOT_ADF + ADF_NUM_REGS)
+#define CMD_MAX_BYTES (1 + ADF_REG_BYTES)
+#define RECOVER_PURGE 0
+#define RECOVER_RESET 1
+#define RECOVER_REOPEN 2
+#define RECOVER_BACKOFF_S 1
+/* time allowed for a cancelled write to complete before it is freed */
+#define WRITE_CANCEL_US 100000
+/* bytes passed to each callback by the emulated transport, matching a
+ * full set of libftdi transfers */
+#define EMULATE_CHUNK 16384
+/* beat tone cycles per sweep in emulated frames */
+#define EMULATE_BEAT_CYCLES 64
+/* fall no further than this behind the emulated sweep rate (s) */
+#define EMULATE_MAX_LAG 1.0
+/* stdio buffer of the log and replay files, drawn from the pool */
+#define FILE_BUFFER_LEN (1 << 16)
 #define sample_t int
 
 static struct ftdi_context *ftdi = NULL;
+/* interface B, or NULL to send commands on interface A */
+static struct Jtag *_control = NULL;
 static pthread_t producer_thread;
 pthread_mutex_t *mutex = NULL;
 struct ProducerData *prod_data = NULL;
@@ -39,12 +88,77 @@ static int _stop_flags;
 static int _sweep_idx;
 static int _sweep_valid = 0;
 static FILE *_log_file = NULL;
+static char *_log_buf = NULL;
 static sample_t *sweep = NULL;
-static sample_t _last_sample;
+/* sample words of the sweep being parsed, converted on completion */
+static uint64_t *_raw = NULL;
 static int _byte_idx;
 static uint64_t _uval;
 static int _cancel;
 static struct Vector *write_data = NULL;
+static uint64_t _sweep_seq;
+static struct SweepMeta _sweep_meta;
+static int _sweep_overflow;
+static int _sweep_mti;
+static int _max_overflow = -1;
+/* time the unread sweep became ready, and the total time sweeps have
+ * waited to be read */
+static double _sweep_ready;
+static double _sweep_waiting;
+/* sets the ramp delay from the producer thread, or NULL */
+static struct Governor *_governor = NULL;
+static struct FmcwStats _stats;
+static double _watchdog_timeout = 0;
+static double _last_frame;
+static int _recover_tier;
+static uint8_t _cmd_bytes[CMD_NUM_SLOTS][CMD_MAX_BYTES];
+static int _cmd_len[CMD_NUM_SLOTS];
+static int _started;
+/* serial of the open radar, empty if it has none */
+static char _serial[DISCOVERY_STR_LEN];
+static struct Discovery *_discovery = NULL;
+/* Hotplug state has its own lock so that hotplug events are never
+ * held up by a recovery in progress. */
+static pthread_mutex_t hotplug_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int _detached;
+static int _reattached;
+static uint64_t _nattach;
+static uint64_t _ndetach;
+static int _profile = FALSE;
+static int _transport = FMCW_TRANSPORT_USB;
+static char *_replay_path = NULL;
+static double _emulate_rate;
+/* created and used by the producer thread */
+static struct Perf *_perf = NULL;
+/* sweep point plugins, loaded by fmcw_start_acquisition */
+static char *_plugin_path[FMCW_MAX_PLUGINS];
+static char *_plugin_args[FMCW_MAX_PLUGINS];
+static double _plugin_spacing[FMCW_MAX_PLUGINS];
+static double _plugin_sweep_rate[FMCW_MAX_PLUGINS];
+static struct Plugin *_plugins[FMCW_MAX_PLUGINS];
+static int _nplugins;
+/* evaluated on each FFT sweep in the producer thread, owned by the caller */
+static struct Zones *_zones = NULL;
+/* signalled when a sweep becomes ready, created on first use */
+static int _sweep_efd = -1;
+/* Writes submitted with fmcw_submit_pending. They complete as the
+ * producer thread handles USB events and are reaped by its callback. */
+struct PendingWrite {
+	uint64_t id;
+	struct ftdi_transfer_control *tc;
+	uint8_t *buf;
+	int len;
+};
+static struct PendingWrite _writes[FMCW_MAX_COMMANDS];
+static int _nwrites;
+/* completed commands awaiting fmcw_pop_command, oldest first */
+static struct {
+	uint64_t id;
+	int ok;
+} _done[FMCW_MAX_COMMANDS];
+static int _ndone;
+static uint64_t _next_command = 1;
+static int _command_efd = -1;
 
 /**
  * Nearest greater or equal power of 2.
@@ -55,9 +169,52 @@ static int pow2ceil(int val);
  */
 static int callback(uint8_t *buffer, int length, FTDIProgressInfo *progress, void *userdata);
 /**
- * Initialize the radar.
+ * Initialize the first radar found.
  */
 int fmcw_open();
+/**
+ * Initialize the radar with serial number @serial, or the first radar
+ * found if @serial is NULL or empty.
+ */
+int fmcw_open_serial(const char *serial);
+/**
+ * Open an emulated radar instead of USB hardware, for exercising the
+ * host stack without a board. If @replay_path is NULL, identical frames
+ * containing a beat tone are generated, otherwise the bytes of
+ * @replay_path, a log written by fmcw_start_acquisition, are replayed
+ * in a loop. Frames are emitted at @sweep_rate sweeps per second, or as
+ * fast as they are parsed if @sweep_rate is not positive. Commands are
+ * accepted and dropped, and there is no watchdog or hotplug.
+ */
+int fmcw_open_emulated(const char *replay_path, double sweep_rate);
+/**
+ * Follow the open radar across unplug and replug when @enable is
+ * TRUE. While it is unplugged the stream is quiesced, and when a
+ * board with the same serial number reappears it is reopened and
+ * reconfigured as after a watchdog recovery. Must be called after
+ * fmcw_open. Returns FALSE if hotplug is unavailable.
+ */
+int fmcw_set_hotplug(int enable);
+/**
+ * Send commands on the FT2232H's interface B, through the FPGA's JTAG
+ * port, when @enable is TRUE instead of interleaving them with the
+ * data stream on interface A. The gateware applies them between
+ * frames without leaving its transmit states. Must be called after
+ * fmcw_open and before fmcw_start_acquisition. Returns FALSE if
+ * interface B cannot be opened, or without a USB radar.
+ */
+int fmcw_set_control(int enable);
+/**
+ * Count hardware events for each FMCW_PERF_* stage of the producer
+ * thread when @enable is TRUE. Takes effect at the next call to
+ * fmcw_start_acquisition.
+ */
+void fmcw_set_profile(int enable);
+/**
+ * Copy the hardware event totals for @stage into @counts. Returns
+ * FALSE if profiling is disabled or the counters are unavailable.
+ */
+int fmcw_get_profile(int stage, struct PerfCounts *counts);
 /**
  * Free the radar.
  */
@@ -77,15 +234,184 @@ void fmcw_close();
  * flag length is therefore equal to the number of bytes of the sample
  * + padding.
  *
- * @sweep_len is the number of samples in each sweep.
+ * @sweep_len is the number of samples in each sweep. Each sweep's
+ * samples are followed by a single trailer word, of the same width as
+ * a sample, holding the number of ADC overflows during the sweep and
+ * whether the gateware pulse canceller was applied to it.
  *
  * Returns TRUE on success and FALSE on failure.
  */
 int fmcw_start_acquisition(char *log_path, int sample_bits, int sweep_len, int fft);
 /**
  * Retrieves the next sweep if one is available, or NULL otherwise.
+ *
+ * If @meta is not NULL, it is filled with the sweep's metadata.
+ */
+int fmcw_read_sweep(int *arr, struct SweepMeta *meta);
+/**
+ * Discard sweeps with more than @max_overflow ADC overflows instead
+ * of passing them to fmcw_read_sweep. A negative value keeps every
+ * sweep, which is the default.
+ */
+void fmcw_set_max_overflow(int max_overflow);
+/**
+ * Copy the acquisition counters into @stats.
+ */
+void fmcw_get_stats(struct FmcwStats *stats);
+/**
+ * Recover the USB link when no complete frame has arrived for
+ * @timeout seconds. Recovery escalates from purging the FTDI buffers,
+ * to resetting the FT2232H, to reopening it, and the last command of
+ * each kind is re-sent afterward. A slow consumer does not count as a
+ * stall. A @timeout of 0 or less disables the watchdog, which is the
+ * default.
+ */
+void fmcw_set_watchdog(double timeout);
+/**
+ * Adjust the ADF4158 delay between ramps so that sweeps arrive about
+ * as fast as fmcw_read_sweep takes them, rather than being dropped
+ * (see governor.h). The delay is kept within @min_steps and @max_steps
+ * periods of the delay clock, @step_time seconds each, and is changed
+ * by restarting the ramp with the last ADF register 7 written. A
+ * @step_time of 0 or less disables the governor, which is the default.
+ * Returns FALSE without a USB radar or if the bounds are invalid.
+ */
+int fmcw_set_governor(double step_time, int min_steps, int max_steps);
+/**
+ * Run the plugin at @path (see fmcw_plugin.h) with the user string
+ * @args at the sweep point, after the plugins added before it. The
+ * plugin is given the sample rate or bin spacing @spacing (Hz) and
+ * @sweep_rate, which the library does not know. Plugins are loaded by
+ * fmcw_start_acquisition and unloaded by fmcw_close. Returns FALSE if
+ * FMCW_MAX_PLUGINS have already been added.
+ */
+int fmcw_add_plugin(const char *path, const char *args, double spacing, double sweep_rate);
+/**
+ * Evaluate @zones on each range profile as soon as its stop flags
+ * arrive, in the producer thread. Only FFT output is a range profile,
+ * so other outputs are not evaluated. @zones remains owned by the
+ * caller and must outlive acquisition, or be removed by passing NULL.
+ */
+void fmcw_set_zones(struct Zones *zones);
+/**
+ * An eventfd that becomes readable when a sweep is ready for
+ * fmcw_read_sweep, so that an event loop can wait for sweeps without
+ * polling. It is not cleared by fmcw_read_sweep; read it before
+ * reading sweeps. Returns -1 on failure.
+ */
+int fmcw_sweep_eventfd();
+/**
+ * Write the commands queued with fmcw_add_write without waiting for
+ * the transfer, which completes as the producer thread handles USB
+ * events. Before acquisition starts, or without a USB radar, the write
+ * completes before this returns.
+ *
+ * Returns an identifier, increasing from 1, that fmcw_pop_command
+ * reports on completion, or 0 if FMCW_MAX_COMMANDS are outstanding.
+ */
+uint64_t fmcw_submit_pending();
+/**
+ * An eventfd that becomes readable when a submitted command completes.
+ * Returns -1 on failure.
+ */
+int fmcw_command_eventfd();
+/**
+ * Remove the oldest completed command, setting @id to its identifier
+ * and @ok to whether it was written. Returns FALSE if there is none.
+ */
+int fmcw_pop_command(uint64_t *id, int *ok);
+/**
+ * Report completed writes. Must be called with the mutex held.
+ */
+static void reap_writes();
+/**
+ * Cancel outstanding writes and report them as failed, before the FTDI
+ * context they were submitted on is reset or closed. Must be called
+ * with the mutex held, outside the stream callback.
+ */
+static void fail_writes();
+static void command_done(uint64_t id, int ok);
+static void signal_eventfd(int efd);
+/**
+ * Load the plugins added with fmcw_add_plugin for the current sweep
+ * format. Returns FALSE, with none loaded, if any fails to load.
+ */
+static int load_plugins();
+/**
+ * Free the loaded plugin instances, keeping the plugins added with
+ * fmcw_add_plugin so that they can be loaded again.
+ */
+static void unload_plugins();
+/**
+ * Forget the plugins added with fmcw_add_plugin.
+ */
+static void clear_plugins();
+/**
+ * Free what fmcw_start_acquisition allocated. The producer thread
+ * must not be running.
+ */
+static void release_acquisition();
+/**
+ * Open and configure interface A of the FT2232H.
+ */
+static int usb_open();
+/**
+ * Configure an open FT2232H for synchronous FIFO reads.
+ */
+static int usb_configure();
+/**
+ * Remember the last command of each kind in @buf so that it can be
+ * replayed after a recovery.
+ */
+static void record_commands(const uint8_t *buf, int len);
+static int replay_commands();
+/**
+ * Number of bytes in the command starting with @cmd, including @cmd,
+ * or 0 if @cmd is unknown.
+ */
+static int command_bytes(uint8_t cmd);
+/**
+ * Write the commands in @buf to the radar on the control channel if
+ * it is open and on interface A otherwise.
+ */
+static int write_commands(const uint8_t *buf, int len);
+static int control_write(const uint8_t *buf, int len);
+/**
+ * Run the governor on the frame just completed, and restart the ramp
+ * with its delay if that changed.
+ */
+static void govern();
+/**
+ * Restart the ramp with ADF register 7 set to @val, without reporting
+ * completion to fmcw_pop_command. Returns FALSE if the write could not
+ * be started.
+ */
+static int write_delay(uint32_t val);
+/**
+ * Attempt the next recovery step after a stall. Must be called with
+ * the mutex held. Returns TRUE if the link was restored.
+ */
+static int recover();
+/**
+ * Wait out an unplugged radar, otherwise attempt recovery. Must be
+ * called with the mutex held. Returns TRUE if the link was restored.
  */
-int fmcw_read_sweep(int *arr);
+static int try_recover();
+static int detached_p();
+static void hotplug_event(const struct FmcwDeviceInfo *info, int attached, void *userdata);
+/**
+ * Stream from the FT2232H, recovering from stalls, until cancelled.
+ */
+static void usb_stream();
+/**
+ * Feed emulated or replayed frames through the callback until
+ * cancelled.
+ */
+static void emulate_stream();
+/**
+ * Write one emulated frame of @len bytes to @buf.
+ */
+static void emulate_frame(uint8_t *buf, int len);
 /**
  * Producer function to read data from radar.
  */
@@ -104,30 +430,128 @@ static int read_stop_seq(uint8_t *buffer, int length, int read_idx);
 static int read_sample_seq(uint8_t *buffer, int length, int read_idx);
 static int read_start_seq(uint8_t *buffer, int length, int read_idx);
 static sample_t sample_val(uint64_t uval);
+static double tsec(struct timespec tspec);
+
+int fmcw_open() { return fmcw_open_serial(NULL); }
 
-int fmcw_open()
+int fmcw_open_serial(const char *serial)
 {
+	_serial[0] = '\0';
+	if (serial && serial[0]) {
+		snprintf(_serial, DISCOVERY_STR_LEN, "%s", serial);
+	} else {
+		/* pin the first radar so that a reopen finds the same one */
+		struct FmcwDeviceInfo info;
+		if (discovery_list(&info, 1) > 0) {
+			snprintf(_serial, DISCOVERY_STR_LEN, "%s", info.serial);
+		}
+	}
+
 	if ((ftdi = ftdi_new()) == 0) {
 		fprintf(stderr, "ftdi_new failed\n");
 		fmcw_close();
 		return FALSE;
 	}
 
+	if (!usb_open()) {
+		fmcw_close();
+		return FALSE;
+	}
+
+	if ((write_data = vector_new()) == NULL) {
+		fmcw_close();
+		return FALSE;
+	}
+	for (int i = 0; i < CMD_NUM_SLOTS; ++i) {
+		_cmd_len[i] = 0;
+	}
+	_started = FALSE;
+	pthread_mutex_lock(&hotplug_mutex);
+	_detached = FALSE;
+	_reattached = FALSE;
+	pthread_mutex_unlock(&hotplug_mutex);
+
+	return TRUE;
+}
+
+int fmcw_open_emulated(const char *replay_path, double sweep_rate)
+{
+	_transport = replay_path ? FMCW_TRANSPORT_REPLAY : FMCW_TRANSPORT_EMULATE;
+	free(_replay_path);
+	_replay_path = replay_path ? strdup(replay_path) : NULL;
+	_emulate_rate = sweep_rate;
+	_serial[0] = '\0';
+	_watchdog_timeout = 0;
+
+	if ((write_data = vector_new()) == NULL) {
+		fmcw_close();
+		return FALSE;
+	}
+	for (int i = 0; i < CMD_NUM_SLOTS; ++i) {
+		_cmd_len[i] = 0;
+	}
+	_started = FALSE;
+	return TRUE;
+}
+
+int fmcw_set_hotplug(int enable)
+{
+	if (!enable) {
+		discovery_free(_discovery);
+		_discovery = NULL;
+		return TRUE;
+	}
+	if (_transport != FMCW_TRANSPORT_USB) {
+		return FALSE;
+	}
+	if (_discovery) {
+		return TRUE;
+	}
+	if (!_serial[0]) {
+		fputs("Hotplug requires a radar with a serial number.\n", stderr);
+		return FALSE;
+	}
+	_discovery = discovery_new(&hotplug_event, NULL);
+	return _discovery != NULL;
+}
+
+int fmcw_set_control(int enable)
+{
+	if (!enable) {
+		jtag_free(_control);
+		_control = NULL;
+		return TRUE;
+	}
+	if (_transport != FMCW_TRANSPORT_USB) {
+		return FALSE;
+	}
+	if (_control) {
+		return TRUE;
+	}
+	_control = jtag_new(_serial);
+	return _control != NULL;
+}
+
+int usb_open()
+{
 	if (ftdi_set_interface(ftdi, INTERFACE_A) < 0) {
 		fprintf(stderr, "ftdi_set_interface failed\n");
-		fmcw_close();
 		return FALSE;
 	}
 
-	if (ftdi_usb_open_desc(ftdi, VENDOR_ID, MODEL_ID, NULL, NULL) < 0) {
+	if (ftdi_usb_open_desc(ftdi, VENDOR_ID, MODEL_ID, NULL, _serial[0] ? _serial : NULL) <
+	    0) {
 		fprintf(stderr, "Can't open ftdi device: %s\n", ftdi_get_error_string(ftdi));
-		fmcw_close();
 		return FALSE;
 	}
 
+	return usb_configure();
+}
+
+int usb_configure()
+{
 	if (ftdi_set_latency_timer(ftdi, LATENCY)) {
 		fprintf(stderr, "Can't set latency, Error %s\n", ftdi_get_error_string(ftdi));
-		fmcw_close();
 		return FALSE;
 	}
 
@@ -135,85 +559,151 @@ int fmcw_open()
 	if (ftdi_set_bitmode(ftdi, BITMASK_ON, BITMODE_SYNCFF) < 0) {
 		fprintf(stderr, "Can't set synchronous fifo mode, Error %s\n",
 			ftdi_get_error_string(ftdi));
-		fmcw_close();
 		return FALSE;
 	}
 
 	if (ftdi_read_data_set_chunksize(ftdi, CHUNKSIZE) < 0) {
 		fprintf(stderr, "Unable to set read chunk size %s\n", ftdi_get_error_string(ftdi));
-		fmcw_close();
 		return FALSE;
 	}
 
 	if (ftdi_write_data_set_chunksize(ftdi, CHUNKSIZE) < 0) {
 		fprintf(stderr, "Unable to set write chunk size %s\n", ftdi_get_error_string(ftdi));
-		fmcw_close();
 		return FALSE;
 	}
 
 	if (ftdi_setflowctrl(ftdi, SIO_RTS_CTS_HS) < 0) {
 		fprintf(stderr, "Unable to set flow control %s\n", ftdi_get_error_string(ftdi));
-		fmcw_close();
 		return FALSE;
 	}
 
 	/* TODO this will be deprecated for ftdi_tcioflush. */
 	if (ftdi_usb_purge_buffers(ftdi) < 0) {
 		fprintf(stderr, "Unable to purge tx/rx buffers %s\n", ftdi_get_error_string(ftdi));
-		fmcw_close();
 		return FALSE;
 	}
 
-	write_data = vector_new();
-
 	return TRUE;
 }
 
 void fmcw_close()
 {
-	pthread_mutex_lock(mutex);
-	_cancel = 1;
-	pthread_mutex_unlock(mutex);
-	pthread_join(producer_thread, NULL);
-	_cancel = 0;
-	if (_log_file) {
-		fclose(_log_file);
-		_log_file = NULL;
+	fmcw_set_hotplug(FALSE);
+	/* there is no producer thread if acquisition failed to start */
+	if (mutex) {
+		pthread_mutex_lock(mutex);
+		_cancel = 1;
+		pthread_mutex_unlock(mutex);
+		pthread_join(producer_thread, NULL);
+		_cancel = 0;
 	}
+	fail_writes();
+	release_acquisition();
 	vector_free(write_data);
 	write_data = NULL;
-	ftdi_usb_purge_buffers(ftdi);
-	ftdi_usb_close(ftdi);
-	ftdi_free(ftdi);
-	ftdi = NULL;
-	free(mutex);
-	mutex = NULL;
-	free(sweep);
-	sweep = NULL;
+	jtag_free(_control);
+	_control = NULL;
+	if (ftdi) {
+		ftdi_usb_purge_buffers(ftdi);
+		ftdi_usb_close(ftdi);
+		ftdi_free(ftdi);
+		ftdi = NULL;
+	}
+	free(_replay_path);
+	_replay_path = NULL;
+	_transport = FMCW_TRANSPORT_USB;
+	clear_plugins();
+	_zones = NULL;
+	governor_free(_governor);
+	_governor = NULL;
+	if (_sweep_efd >= 0) {
+		close(_sweep_efd);
+		_sweep_efd = -1;
+	}
+	if (_command_efd >= 0) {
+		close(_command_efd);
+		_command_efd = -1;
+	}
+	_ndone = 0;
 }
 
 int fmcw_start_acquisition(char *log_path, int sample_bits, int sweep_len, int fft)
 {
-	mutex = malloc(sizeof(pthread_mutex_t));
+	if (mutex) {
+		/* already acquiring */
+		return FALSE;
+	}
+	if ((mutex = pool_alloc(POOL_SWEEP, sizeof(pthread_mutex_t))) == NULL) {
+		return FALSE;
+	}
 	pthread_mutex_init(mutex, NULL);
 	_fft = fft;
 	_sample_bits = sample_bits;
 	_sample_bytes = sample_bytes(_sample_bits);
 	_nflags = num_flags(_sample_bits);
 	_sweep_len = sweep_len;
+	_sweep_seq = 0;
+	_stats = (struct FmcwStats){0};
+	_sweep_waiting = 0;
+	struct timespec tspec;
+	clock_gettime(CLOCK_MONOTONIC, &tspec);
+	_last_frame = tsec(tspec);
+	_recover_tier = RECOVER_PURGE;
+	pthread_mutex_lock(&hotplug_mutex);
+	_nattach = 0;
+	_ndetach = 0;
+	pthread_mutex_unlock(&hotplug_mutex);
 	if (log_path) {
-		if ((_log_file = fopen(log_path, "w")) < 0) {
+		if ((_log_file = fopen(log_path, "w")) == NULL) {
 			fputs("Failed to open log file.\n", stderr);
-			return FALSE;
+			goto fail;
+		}
+		if ((_log_buf = pool_alloc(POOL_LOG, FILE_BUFFER_LEN)) != NULL) {
+			setvbuf(_log_file, _log_buf, _IOFBF, FILE_BUFFER_LEN);
 		}
 	}
-	sweep = malloc(_sweep_len * sizeof(int));
+	sweep = pool_alloc(POOL_SWEEP, _sweep_len * sizeof(int));
+	_raw = pool_alloc(POOL_SWEEP, _sweep_len * sizeof(uint64_t));
+	if (sweep == NULL || _raw == NULL) {
+		fputs("Sweep pool exhausted.\n", stderr);
+		goto fail;
+	}
+	if (!load_plugins()) {
+		goto fail;
+	}
 
-	pthread_create(&producer_thread, NULL, &producer, NULL);
+	if (pthread_create(&producer_thread, NULL, &producer, NULL)) {
+		unload_plugins();
+		goto fail;
+	}
 	return TRUE;
+
+fail:
+	release_acquisition();
+	return FALSE;
+}
+
+void release_acquisition()
+{
+	if (_log_file) {
+		fclose(_log_file);
+		_log_file = NULL;
+	}
+	pool_free(_log_buf);
+	_log_buf = NULL;
+	unload_plugins();
+	pool_free(sweep);
+	sweep = NULL;
+	pool_free(_raw);
+	_raw = NULL;
+	if (mutex) {
+		pthread_mutex_destroy(mutex);
+		pool_free(mutex);
+		mutex = NULL;
+	}
 }
 
-int fmcw_read_sweep(int *arr)
+int fmcw_read_sweep(int *arr, struct SweepMeta *meta)
 {
 	int ret = FALSE;
 	pthread_mutex_lock(mutex);
@@ -222,12 +712,161 @@ int fmcw_read_sweep(int *arr)
 		for (int i = 0; i < _sweep_len; ++i) {
 			arr[i] = sweep[i];
 		}
+		if (meta) {
+			*meta = _sweep_meta;
+		}
 		_sweep_valid = 0;
+		struct timespec tspec;
+		clock_gettime(CLOCK_MONOTONIC, &tspec);
+		_sweep_waiting += tsec(tspec) - _sweep_ready;
 	}
 	pthread_mutex_unlock(mutex);
 	return ret;
 }
 
+void fmcw_set_max_overflow(int max_overflow)
+{
+	if (mutex) {
+		pthread_mutex_lock(mutex);
+	}
+	_max_overflow = max_overflow;
+	if (mutex) {
+		pthread_mutex_unlock(mutex);
+	}
+}
+
+void fmcw_get_stats(struct FmcwStats *stats)
+{
+	if (mutex) {
+		pthread_mutex_lock(mutex);
+	}
+	*stats = _stats;
+	if (mutex) {
+		pthread_mutex_unlock(mutex);
+	}
+	pthread_mutex_lock(&hotplug_mutex);
+	stats->attaches = _nattach;
+	stats->detaches = _ndetach;
+	pthread_mutex_unlock(&hotplug_mutex);
+}
+
+void fmcw_set_watchdog(double timeout)
+{
+	if (mutex) {
+		pthread_mutex_lock(mutex);
+	}
+	if (_transport == FMCW_TRANSPORT_USB) {
+		_watchdog_timeout = timeout;
+	}
+	if (mutex) {
+		pthread_mutex_unlock(mutex);
+	}
+}
+
+int fmcw_set_governor(double step_time, int min_steps, int max_steps)
+{
+	struct Governor *gov = NULL;
+	if (_transport != FMCW_TRANSPORT_USB) {
+		return FALSE;
+	}
+	if (step_time > 0 && (gov = governor_new(step_time, min_steps, max_steps)) == NULL) {
+		return FALSE;
+	}
+	if (mutex) {
+		pthread_mutex_lock(mutex);
+	}
+	governor_free(_governor);
+	_governor = gov;
+	if (mutex) {
+		pthread_mutex_unlock(mutex);
+	}
+	return TRUE;
+}
+
+void fmcw_set_profile(int enable) { _profile = enable; }
+
+int fmcw_get_profile(int stage, struct PerfCounts *counts)
+{
+	int ret = FALSE;
+	if (mutex) {
+		pthread_mutex_lock(mutex);
+	}
+	if (_perf && stage >= 0 && stage < FMCW_PERF_NUM_STAGES) {
+		perf_read(_perf, stage, counts);
+		ret = TRUE;
+	}
+	if (mutex) {
+		pthread_mutex_unlock(mutex);
+	}
+	return ret;
+}
+
+void fmcw_set_zones(struct Zones *zones)
+{
+	if (mutex) {
+		pthread_mutex_lock(mutex);
+	}
+	_zones = zones;
+	if (mutex) {
+		pthread_mutex_unlock(mutex);
+	}
+}
+
+int fmcw_add_plugin(const char *path, const char *args, double spacing, double sweep_rate)
+{
+	for (int i = 0; i < FMCW_MAX_PLUGINS; ++i) {
+		if (_plugin_path[i] == NULL) {
+			_plugin_path[i] = strdup(path);
+			_plugin_args[i] = strdup(args ? args : "");
+			_plugin_spacing[i] = spacing;
+			_plugin_sweep_rate[i] = sweep_rate;
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+int load_plugins()
+{
+	struct FmcwFormat format = {
+		.len = _sweep_len,
+		.type = FMCW_SAMPLE_INT32,
+		.domain = _fft ? FMCW_DOMAIN_SPECTRUM : FMCW_DOMAIN_TIME,
+	};
+	for (_nplugins = 0; _nplugins < FMCW_MAX_PLUGINS && _plugin_path[_nplugins];
+	     ++_nplugins) {
+		format.spacing = _plugin_spacing[_nplugins];
+		format.sweep_rate = _plugin_sweep_rate[_nplugins];
+		/* the consumer always reads _sweep_len samples */
+		_plugins[_nplugins] =
+			plugin_load(_plugin_path[_nplugins], _plugin_args[_nplugins], &format, FALSE);
+		if (_plugins[_nplugins] == NULL) {
+			unload_plugins();
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+void unload_plugins()
+{
+	for (int i = 0; i < _nplugins; ++i) {
+		plugin_free(_plugins[i]);
+		_plugins[i] = NULL;
+	}
+	_nplugins = 0;
+}
+
+void clear_plugins()
+{
+	for (int i = 0; i < FMCW_MAX_PLUGINS; ++i) {
+		free(_plugin_path[i]);
+		free(_plugin_args[i]);
+		_plugin_path[i] = NULL;
+		_plugin_args[i] = NULL;
+	}
+}
+
 int fmcw_add_write(uint32_t val, int nbytes)
 {
 	unsigned char buf[nbytes];
@@ -244,33 +883,569 @@ int fmcw_add_write(uint32_t val, int nbytes)
 
 int fmcw_write_pending()
 {
-	if (ftdi_write_data(ftdi, write_data->buf, write_data->size) != write_data->size) {
+	if (mutex) {
+		pthread_mutex_lock(mutex);
+	}
+	/* recovery purges, reopens and writes to the device from the
+	 * producer thread while holding the mutex */
+	int ok = TRUE;
+	if (_control) {
+		ok = control_write(write_data->buf, write_data->size);
+	} else if (_transport == FMCW_TRANSPORT_USB) {
+		ok = ftdi_write_data(ftdi, write_data->buf, write_data->size) == write_data->size;
+	}
+	if (ok) {
+		record_commands(write_data->buf, write_data->size);
+	}
+	if (mutex) {
+		pthread_mutex_unlock(mutex);
+	}
+	if (!ok) {
 		return FALSE;
 	}
 	vector_empty(write_data);
 	return TRUE;
 }
 
+int fmcw_sweep_eventfd()
+{
+	if (_sweep_efd < 0) {
+		_sweep_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	}
+	return _sweep_efd;
+}
+
+uint64_t fmcw_submit_pending()
+{
+	uint64_t id;
+	if (mutex == NULL) {
+		/* no producer thread handles USB events yet */
+		if (_ndone >= FMCW_MAX_COMMANDS) {
+			return 0;
+		}
+		id = _next_command++;
+		command_done(id, fmcw_write_pending());
+		return id;
+	}
+
+	pthread_mutex_lock(mutex);
+	if (_nwrites + _ndone >= FMCW_MAX_COMMANDS) {
+		pthread_mutex_unlock(mutex);
+		return 0;
+	}
+	id = _next_command++;
+	if (_transport != FMCW_TRANSPORT_USB) {
+		record_commands(write_data->buf, write_data->size);
+		command_done(id, TRUE);
+		goto done;
+	}
+	if (_control) {
+		/* a few short scans, written synchronously */
+		int ok = control_write(write_data->buf, write_data->size);
+		if (ok) {
+			record_commands(write_data->buf, write_data->size);
+		}
+		command_done(id, ok);
+		goto done;
+	}
+
+	/* libftdi writes from the buffer until the transfer completes */
+	struct PendingWrite *pw = &_writes[_nwrites];
+	pw->id = id;
+	pw->len = write_data->size;
+	pw->buf = pool_alloc(POOL_COMMANDS, pw->len);
+	if (pw->buf == NULL) {
+		command_done(id, FALSE);
+		goto done;
+	}
+	memcpy(pw->buf, write_data->buf, pw->len);
+	pw->tc = ftdi_write_data_submit(ftdi, pw->buf, pw->len);
+	if (pw->tc == NULL) {
+		pool_free(pw->buf);
+		command_done(id, FALSE);
+		goto done;
+	}
+	++_nwrites;
+done:
+	pthread_mutex_unlock(mutex);
+	vector_empty(write_data);
+	return id;
+}
+
+int fmcw_command_eventfd()
+{
+	if (_command_efd < 0) {
+		_command_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	}
+	return _command_efd;
+}
+
+int fmcw_pop_command(uint64_t *id, int *ok)
+{
+	int ret = FALSE;
+	if (mutex) {
+		pthread_mutex_lock(mutex);
+	}
+	if (_ndone) {
+		*id = _done[0].id;
+		*ok = _done[0].ok;
+		memmove(_done, _done + 1, --_ndone * sizeof(_done[0]));
+		ret = TRUE;
+	}
+	if (mutex) {
+		pthread_mutex_unlock(mutex);
+	}
+	return ret;
+}
+
+void reap_writes()
+{
+	int kept = 0;
+	for (int i = 0; i < _nwrites; ++i) {
+		struct PendingWrite *pw = &_writes[i];
+		if (!pw->tc->completed) {
+			_writes[kept++] = *pw;
+			continue;
+		}
+		/* returns at once for a completed transfer */
+		int ok = ftdi_transfer_data_done(pw->tc) == pw->len;
+		if (ok) {
+			record_commands(pw->buf, pw->len);
+		}
+		pool_free(pw->buf);
+		/* the governor's writes have no identifier */
+		if (pw->id) {
+			command_done(pw->id, ok);
+		}
+	}
+	_nwrites = kept;
+}
+
+void fail_writes()
+{
+	/* a transfer must not be freed while the cancellation is in flight */
+	struct timeval tv = {0, WRITE_CANCEL_US};
+	reap_writes();
+	for (int i = 0; i < _nwrites; ++i) {
+		ftdi_transfer_data_cancel(_writes[i].tc, &tv);
+		pool_free(_writes[i].buf);
+		if (_writes[i].id) {
+			command_done(_writes[i].id, FALSE);
+		}
+	}
+	_nwrites = 0;
+}
+
+void command_done(uint64_t id, int ok)
+{
+	/* submission is refused before this can overflow */
+	_done[_ndone].id = id;
+	_done[_ndone].ok = ok;
+	++_ndone;
+	signal_eventfd(_command_efd);
+}
+
+void signal_eventfd(int efd)
+{
+	if (efd < 0) {
+		return;
+	}
+	uint64_t one = 1;
+	if (write(efd, &one, sizeof(one)) != sizeof(one)) {
+		/* the counter is saturated, so the fd is readable anyway */
+	}
+}
+
 void *producer(void *arg)
 {
-	ftdi_readstream(ftdi, &callback, NULL, PACKETS_PER_TRANSFER, TRANSFERS_PER_CALLBACK);
+	if (_profile) {
+		struct Perf *perf = perf_new(FMCW_PERF_NUM_STAGES);
+		pthread_mutex_lock(mutex);
+		_perf = perf;
+		pthread_mutex_unlock(mutex);
+	}
+
+	if (_transport == FMCW_TRANSPORT_USB) {
+		usb_stream();
+	} else {
+		emulate_stream();
+	}
+
+	pthread_mutex_lock(mutex);
+	perf_free(_perf);
+	_perf = NULL;
+	pthread_mutex_unlock(mutex);
 	return NULL;
 }
 
+void usb_stream()
+{
+	struct timespec backoff = {RECOVER_BACKOFF_S, 0};
+
+	while (1) {
+		ftdi_readstream(ftdi, &callback, NULL, PACKETS_PER_TRANSFER,
+				TRANSFERS_PER_CALLBACK);
+
+		pthread_mutex_lock(mutex);
+		if (_cancel || (_watchdog_timeout <= 0 && !_discovery)) {
+			pthread_mutex_unlock(mutex);
+			return;
+		}
+		/* The stream ended without being cancelled, either because
+		 * the watchdog tripped, the radar was unplugged or because of
+		 * a USB error. The mutex is held during recovery so that no
+		 * one else uses the FTDI context while it is reopened. */
+		if (!detached_p()) {
+			++_stats.stalls;
+		}
+		int cancel = FALSE;
+		while (!cancel && !try_recover()) {
+			pthread_mutex_unlock(mutex);
+			nanosleep(&backoff, NULL);
+			pthread_mutex_lock(mutex);
+			cancel = _cancel;
+		}
+		pthread_mutex_unlock(mutex);
+		if (cancel) {
+			return;
+		}
+	}
+}
+
+void emulate_stream()
+{
+	int frame_len = _sample_bytes * (_sweep_len + TRAILER_WORDS) + 2 * _nflags;
+	uint8_t *buf = pool_alloc(POOL_SWEEP, frame_len);
+	char *replay_buf = NULL;
+	FILE *replay = NULL;
+	if (buf == NULL) {
+		return;
+	}
+	if (_transport == FMCW_TRANSPORT_REPLAY) {
+		if ((replay = fopen(_replay_path, "rb")) == NULL) {
+			fprintf(stderr, "Failed to open replay file %s.\n", _replay_path);
+			pool_free(buf);
+			return;
+		}
+		if ((replay_buf = pool_alloc(POOL_LOG, FILE_BUFFER_LEN)) != NULL) {
+			setvbuf(replay, replay_buf, _IOFBF, FILE_BUFFER_LEN);
+		}
+	} else {
+		emulate_frame(buf, frame_len);
+	}
+
+	struct timespec tspec;
+	clock_gettime(CLOCK_MONOTONIC, &tspec);
+	double next = tsec(tspec);
+	while (1) {
+		/* a replayed log is paced a frame's worth of bytes at a
+		 * time, wherever its frames actually fall */
+		int len = frame_len;
+		if (replay) {
+			len = fread(buf, sizeof(uint8_t), frame_len, replay);
+			if (len < frame_len) {
+				rewind(replay);
+			}
+			if (len == 0) {
+				fputs("Replay file is empty.\n", stderr);
+				break;
+			}
+		}
+
+		for (int off = 0; off < len; off += EMULATE_CHUNK) {
+			int chunk = len - off < EMULATE_CHUNK ? len - off : EMULATE_CHUNK;
+			if (callback(buf + off, chunk, NULL, NULL)) {
+				goto done;
+			}
+		}
+
+		if (_emulate_rate > 0) {
+			next += 1 / _emulate_rate;
+			clock_gettime(CLOCK_MONOTONIC, &tspec);
+			double now = tsec(tspec);
+			if (now - next > EMULATE_MAX_LAG) {
+				next = now;
+			}
+			tspec.tv_sec = (time_t)next;
+			tspec.tv_nsec = (long)((next - tspec.tv_sec) / NS_TO_S);
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &tspec, NULL);
+		}
+	}
+
+done:
+	if (replay) {
+		fclose(replay);
+	}
+	pool_free(replay_buf);
+	pool_free(buf);
+}
+
+void emulate_frame(uint8_t *buf, int len)
+{
+	uint64_t mask = ((uint64_t)1 << _sample_bits) - 1;
+	double amp = (double)((uint64_t)1 << (_sample_bits - 2));
+	int pos = 0;
+
+	for (int i = 0; i < _nflags; ++i) {
+		buf[pos++] = START_FLAG;
+	}
+	for (int i = 0; i < _sweep_len; ++i) {
+		double theta = 2 * M_PI * EMULATE_BEAT_CYCLES * i / _sweep_len;
+		uint64_t word = (uint64_t)llround(amp * cos(theta)) & mask;
+		if (_fft) {
+			word |= ((uint64_t)llround(amp * sin(theta)) & mask) << _sample_bits;
+		}
+		for (int b = _sample_bytes - 1; b >= 0; --b) {
+			buf[pos++] = (word >> (BYTE_BITS * b)) & 0xFF;
+		}
+	}
+	/* no overflows */
+	for (int i = 0; i < TRAILER_WORDS * _sample_bytes; ++i) {
+		buf[pos++] = 0;
+	}
+	while (pos < len) {
+		buf[pos++] = STOP_FLAG;
+	}
+}
+
+int try_recover()
+{
+	fail_writes();
+	pthread_mutex_lock(&hotplug_mutex);
+	int detached = _detached;
+	if (_reattached) {
+		/* the old handle refers to a device that no longer exists */
+		_reattached = FALSE;
+		_recover_tier = RECOVER_REOPEN;
+	}
+	pthread_mutex_unlock(&hotplug_mutex);
+
+	if (detached) {
+		/* release the handle while unplugged, this is idempotent */
+		ftdi_usb_close(ftdi);
+		return FALSE;
+	}
+	if (!recover()) {
+		++_stats.recover_failed;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+int detached_p()
+{
+	pthread_mutex_lock(&hotplug_mutex);
+	int detached = _detached;
+	pthread_mutex_unlock(&hotplug_mutex);
+	return detached;
+}
+
+void hotplug_event(const struct FmcwDeviceInfo *info, int attached, void *userdata)
+{
+	if (strcmp(info->serial, _serial) != 0) {
+		return;
+	}
+
+	pthread_mutex_lock(&hotplug_mutex);
+	if (attached && _detached) {
+		_detached = FALSE;
+		_reattached = TRUE;
+		++_nattach;
+	} else if (!attached && !_detached) {
+		_detached = TRUE;
+		++_ndetach;
+	}
+	pthread_mutex_unlock(&hotplug_mutex);
+}
+
+int recover()
+{
+	int tier = _recover_tier;
+	if (_recover_tier < RECOVER_REOPEN) {
+		++_recover_tier;
+	}
+
+	switch (tier) {
+	case RECOVER_PURGE:
+		if (ftdi_usb_purge_buffers(ftdi) < 0) {
+			return FALSE;
+		}
+		break;
+	case RECOVER_RESET:
+		/* a reset returns the FT2232H to its default mode */
+		if (ftdi_usb_reset(ftdi) < 0 || !usb_configure()) {
+			return FALSE;
+		}
+		break;
+	default:
+		ftdi_usb_close(ftdi);
+		if (!usb_open()) {
+			return FALSE;
+		}
+		if (_control) {
+			/* commands fall back to interface A if this fails */
+			jtag_free(_control);
+			_control = jtag_new(_serial);
+		}
+		break;
+	}
+	if (!replay_commands()) {
+		return FALSE;
+	}
+
+	switch (tier) {
+	case RECOVER_PURGE:
+		++_stats.recover_purge;
+		break;
+	case RECOVER_RESET:
+		++_stats.recover_reset;
+		break;
+	default:
+		++_stats.recover_reopen;
+		break;
+	}
+
+	/* any partially parsed sweep is lost */
+	_sweep_idx = 0;
+	_start_flags = 0;
+	_stop_flags = 0;
+	_byte_idx = 0;
+	_uval = 0;
+	struct timespec tspec;
+	clock_gettime(CLOCK_MONOTONIC, &tspec);
+	_last_frame = tsec(tspec);
+	return TRUE;
+}
+
+void record_commands(const uint8_t *buf, int len)
+{
+	int i = 0;
+	while (i < len) {
+		int slot;
+		int nbytes = command_bytes(buf[i]);
+		if (buf[i] == CMD_START || buf[i] == CMD_STOP) {
+			_started = buf[i] == CMD_START;
+			++i;
+			continue;
+		} else if (nbytes == 0) {
+			++i;
+			continue;
+		} else if (buf[i] & CMD_ADF) {
+			slot = CMD_SLOT_ADF + (buf[i] & ADF_REG_MASK);
+		} else {
+			slot = buf[i] - CMD_CHAN_A;
+		}
+		if (i + nbytes > len) {
+			return;
+		}
+		memcpy(_cmd_bytes[slot], buf + i, nbytes);
+		_cmd_len[slot] = nbytes;
+		i += nbytes;
+	}
+}
+
+int replay_commands()
+{
+	uint8_t buf[2 + CMD_NUM_SLOTS * CMD_MAX_BYTES];
+	int len = 0;
+
+	/* restart from a stopped state, as at the start of acquisition */
+	buf[len++] = CMD_STOP;
+	for (int i = 0; i < CMD_NUM_SLOTS; ++i) {
+		memcpy(buf + len, _cmd_bytes[i], _cmd_len[i]);
+		len += _cmd_len[i];
+	}
+	if (_started) {
+		buf[len++] = CMD_START;
+	}
+
+	return write_commands(buf, len);
+}
+
+int command_bytes(uint8_t cmd)
+{
+	if (cmd == CMD_START || cmd == CMD_STOP) {
+		return 1;
+	} else if (cmd & CMD_ADF) {
+		return 1 + ADF_REG_BYTES;
+	} else if (cmd <= CMD_MTI) {
+		return 2;
+	}
+	return 0;
+}
+
+int write_commands(const uint8_t *buf, int len)
+{
+	if (_control) {
+		return control_write(buf, len);
+	}
+	return ftdi_write_data(ftdi, buf, len) == len;
+}
+
+int control_write(const uint8_t *buf, int len)
+{
+	/* every command is at least one byte */
+	uint8_t cmds[len];
+	uint32_t vals[len];
+	int n = 0;
+	int i = 0;
+	while (i < len) {
+		int nbytes = command_bytes(buf[i]);
+		if (nbytes == 0) {
+			++i;
+			continue;
+		}
+		if (i + nbytes > len) {
+			break;
+		}
+		cmds[n] = buf[i];
+		vals[n] = 0;
+		for (int j = 1; j < nbytes; ++j) {
+			vals[n] |= (uint32_t)buf[i + j] << (BYTE_BITS * (j - 1));
+		}
+		++n;
+		i += nbytes;
+	}
+	return n == 0 || jtag_write(_control, cmds, vals, n);
+}
+
 int callback(uint8_t *buffer, int length, FTDIProgressInfo *progress, void *userdata)
 {
 	pthread_mutex_lock(mutex);
+	reap_writes();
 	if (_cancel) {
 		pthread_mutex_unlock(mutex);
 		return 1;
 	}
 
+	if (_discovery && detached_p()) {
+		pthread_mutex_unlock(mutex);
+		return 1;
+	}
+
+	if (_watchdog_timeout > 0) {
+		struct timespec tspec;
+		clock_gettime(CLOCK_MONOTONIC, &tspec);
+		double now = tsec(tspec);
+		if (_sweep_valid) {
+			/* waiting on the consumer is not a stall */
+			_last_frame = now;
+		} else if (now - _last_frame > _watchdog_timeout) {
+			pthread_mutex_unlock(mutex);
+			return 1;
+		}
+	}
+
 	if (length == 0 || _sweep_valid) {
+		_stats.skipped_bytes += length;
 		pthread_mutex_unlock(mutex);
 		return 0;
 	}
 
 	int read_idx = 0;
+	if (_perf) {
+		perf_begin(_perf);
+	}
 
 	/* break out if we read the full buffer. */
 	while (1) {
@@ -296,12 +1471,15 @@ int callback(uint8_t *buffer, int length, FTDIProgressInfo *progress, void *user
 		goto log;
 	}
 
-log:
+log:;
+	int nread = read_idx ? read_idx : length;
+	if (_perf) {
+		perf_end(_perf, FMCW_PERF_PARSE, nread);
+	}
 	if (_log_file) {
-		if (!read_idx) {
-			fwrite(buffer, sizeof(uint8_t), length, _log_file);
-		} else {
-			fwrite(buffer, sizeof(uint8_t), read_idx, _log_file);
+		fwrite(buffer, sizeof(uint8_t), nread, _log_file);
+		if (_perf) {
+			perf_end(_perf, FMCW_PERF_LOG, nread);
 		}
 	}
 	pthread_mutex_unlock(mutex);
@@ -314,6 +1492,8 @@ int read_stop_seq(uint8_t *buffer, int length, int read_idx)
 		if (buffer[read_idx] == STOP_FLAG) {
 			++_stop_flags;
 		} else {
+			/* the frame was malformed, hunt for the next start */
+			++_stats.resyncs;
 			read_idx = inc_check_idx(read_idx, length);
 			goto cleanup;
 		}
@@ -323,8 +1503,71 @@ int read_stop_seq(uint8_t *buffer, int length, int read_idx)
 			return FALSE;
 		}
 	}
+	struct timespec tspec;
+	clock_gettime(CLOCK_MONOTONIC, &tspec);
+	_last_frame = tsec(tspec);
+	_recover_tier = RECOVER_PURGE;
+	++_stats.sweeps;
+	if (_sweep_overflow) {
+		++_stats.overflow_sweeps;
+		_stats.overflow_samples += _sweep_overflow;
+	}
+	if (_governor) {
+		govern();
+	}
+	if (_max_overflow >= 0 && _sweep_overflow > _max_overflow) {
+		++_stats.dropped_overflow;
+		++_sweep_seq;
+		goto cleanup;
+	}
+	if (_perf) {
+		perf_end(_perf, FMCW_PERF_PARSE, 0);
+	}
+	for (int i = 0; i < _sweep_len; ++i) {
+		sweep[i] = sample_val(_raw[i]);
+	}
+	if (_perf) {
+		perf_end(_perf, _fft ? FMCW_PERF_MAGNITUDE : FMCW_PERF_UNPACK,
+			 (uint64_t)_sweep_len * _sample_bytes);
+	}
+	_sweep_meta.seq = _sweep_seq++;
+	_sweep_meta.time = _last_frame;
+	_sweep_meta.flags = _sweep_overflow ? SWEEP_FLAG_OVERFLOW : 0;
+	if (_sweep_mti) {
+		_sweep_meta.flags |= SWEEP_FLAG_MTI;
+	}
+	_sweep_meta.interference = 0;
+	_sweep_meta.overflow = _sweep_overflow;
+	_sweep_meta.noise_floor = 0;
+	/* each stage is profiled on its own so that none is counted as
+	 * parsing */
+	uint64_t sweep_bytes = (uint64_t)_sweep_len * sizeof(sweep[0]);
+	int dropped = FALSE;
+	for (int i = 0; i < _nplugins && !dropped; ++i) {
+		dropped = plugin_process(_plugins[i], sweep, NULL, &_sweep_meta) != FMCW_PLUGIN_OK;
+	}
+	if (_perf && _nplugins) {
+		perf_end(_perf, FMCW_PERF_PLUGINS, sweep_bytes);
+	}
+	if (dropped) {
+		++_stats.dropped_plugin;
+		goto cleanup;
+	}
+	if (_fft) {
+		_sweep_meta.noise_floor = noise_floor_int(sweep, _sweep_len, NOISE_FLOOR_PCT);
+		if (_perf) {
+			perf_end(_perf, FMCW_PERF_NOISE, sweep_bytes);
+		}
+	}
+	if (_zones && _fft) {
+		zones_eval_int(_zones, sweep, _sweep_len, &_sweep_meta);
+		if (_perf) {
+			perf_end(_perf, FMCW_PERF_ZONES, sweep_bytes);
+		}
+	}
 	_sweep_valid = 1;
-	sweep[_sweep_idx] = _last_sample;
+	_sweep_ready = _last_frame;
+	signal_eventfd(_sweep_efd);
 cleanup:
 	_sweep_idx = 0;
 	_start_flags = 0;
@@ -332,9 +1575,75 @@ cleanup:
 	return read_idx;
 }
 
+void govern()
+{
+	const uint8_t *reg = _cmd_bytes[CMD_SLOT_ADF + ADF_DELAY_REG];
+	if (!_started || _cmd_len[CMD_SLOT_ADF + ADF_DELAY_REG] != CMD_MAX_BYTES) {
+		return;
+	}
+	uint32_t val = 0;
+	for (int i = 0; i < ADF_REG_BYTES; ++i) {
+		val |= (uint32_t)reg[1 + i] << (BYTE_BITS * i);
+	}
+	int steps = (val >> ADF_DEL_STEPS_LSB) & ADF_DEL_STEPS_MASK;
+
+	/* frames are skipped whole while the previous sweep is unread */
+	int frame_len = _sample_bytes * (_sweep_len + TRAILER_WORDS) + 2 * _nflags;
+	uint64_t dropped = _stats.skipped_bytes / frame_len;
+	int next = governor_update(_governor, _last_frame, _stats.sweeps, dropped, _sweep_waiting,
+				   steps);
+	if (next == steps) {
+		return;
+	}
+	val &= ~((uint32_t)ADF_DEL_STEPS_MASK << ADF_DEL_STEPS_LSB);
+	val |= (uint32_t)(next & ADF_DEL_STEPS_MASK) << ADF_DEL_STEPS_LSB;
+	if (write_delay(val)) {
+		++_stats.governor_changes;
+	}
+}
+
+int write_delay(uint32_t val)
+{
+	uint8_t buf[2 + CMD_MAX_BYTES];
+	int len = 0;
+
+	/* the ADF4158 only loads its registers when the ramp starts */
+	buf[len++] = CMD_STOP;
+	buf[len++] = CMD_ADF | ADF_DELAY_REG;
+	for (int i = 0; i < ADF_REG_BYTES; ++i) {
+		buf[len++] = (val >> (BYTE_BITS * i)) & 0xFF;
+	}
+	buf[len++] = CMD_START;
+
+	if (_control) {
+		if (!control_write(buf, len)) {
+			return FALSE;
+		}
+		record_commands(buf, len);
+		return TRUE;
+	}
+	/* synchronous writes must not be made from the read callback */
+	if (_nwrites + _ndone >= FMCW_MAX_COMMANDS) {
+		return FALSE;
+	}
+	struct PendingWrite *pw = &_writes[_nwrites];
+	pw->id = 0;
+	pw->len = len;
+	if ((pw->buf = pool_alloc(POOL_COMMANDS, len)) == NULL) {
+		return FALSE;
+	}
+	memcpy(pw->buf, buf, len);
+	if ((pw->tc = ftdi_write_data_submit(ftdi, pw->buf, len)) == NULL) {
+		pool_free(pw->buf);
+		return FALSE;
+	}
+	++_nwrites;
+	return TRUE;
+}
+
 int read_sample_seq(uint8_t *buffer, int length, int read_idx)
 {
-	while (_sweep_idx < _sweep_len) {
+	while (_sweep_idx < _sweep_len + TRAILER_WORDS) {
 		while (_byte_idx < _sample_bytes) {
 			_uval |= ((uint64_t)buffer[read_idx]
 				  << (BYTE_BITS * (_sample_bytes - 1 - _byte_idx++)));
@@ -343,16 +1652,17 @@ int read_sample_seq(uint8_t *buffer, int length, int read_idx)
 			}
 		}
 		_byte_idx = 0;
-		/* fmcw_read_sweep will only perform a read if the
-		 * queue has at least one full sweep. This delays
-		 * writing the last value to the queue until we get
-		 * the full stop sequence (see
-		 * read_stop_seq). Otherwise, there is a small
-		 * possibility that an invalid sweep could be read. */
-		if (_sweep_idx < _sweep_len - 1) {
-			sweep[_sweep_idx] = sample_val(_uval);
+		/* Samples are only converted into the sweep buffer
+		 * once the full stop sequence arrives (see
+		 * read_stop_seq), so fmcw_read_sweep never sees a
+		 * partial sweep and dropped sweeps are never
+		 * converted. */
+		if (_sweep_idx < _sweep_len) {
+			_raw[_sweep_idx] = _uval;
 		} else {
-			_last_sample = sample_val(_uval);
+			/* the trailer is unsigned */
+			_sweep_overflow = (int)(_uval & SWEEP_OVERFLOW_MAX);
+			_sweep_mti = (_uval & SWEEP_TRAILER_MTI) != 0;
 		}
 		++_sweep_idx;
 		_uval = 0;
@@ -1,13 +1,89 @@
 #ifndef __READ_H__
 #define __READ_H__
 
+#include "perf.h"
+#include "sweep.h"
+#include "zone.h"
 #include <stdint.h>
 
+/* Source of the byte stream. */
+#define FMCW_TRANSPORT_USB 0
+#define FMCW_TRANSPORT_EMULATE 1
+#define FMCW_TRANSPORT_REPLAY 2
+
+/* Producer thread stages for fmcw_get_profile. */
+#define FMCW_PERF_PARSE 0
+#define FMCW_PERF_UNPACK 1
+#define FMCW_PERF_MAGNITUDE 2
+#define FMCW_PERF_LOG 3
+#define FMCW_PERF_PLUGINS 4
+#define FMCW_PERF_NOISE 5
+#define FMCW_PERF_ZONES 6
+#define FMCW_PERF_NUM_STAGES 7
+
+/* Plugins at the sweep point (see fmcw_plugin.h). */
+#define FMCW_MAX_PLUGINS 8
+
+/* Commands submitted with fmcw_submit_pending and not yet reported by
+ * fmcw_pop_command. */
+#define FMCW_MAX_COMMANDS 16
+
+/** Acquisition counters since the last call to
+ * fmcw_start_acquisition.
+ */
+struct FmcwStats {
+	/* Complete sweeps parsed, including dropped sweeps. */
+	uint64_t sweeps;
+	/* Sweeps with at least one ADC overflow. */
+	uint64_t overflow_sweeps;
+	/* ADC overflows summed over all sweeps. */
+	uint64_t overflow_samples;
+	/* Sweeps discarded by the overflow limit. */
+	uint64_t dropped_overflow;
+	/* Bytes discarded because the consumer had not yet read the
+	 * previous sweep. */
+	uint64_t skipped_bytes;
+	/* Frames whose stop flags were missing or corrupt. */
+	uint64_t resyncs;
+	/* Sweeps discarded by, or that failed in, a sweep plugin. */
+	uint64_t dropped_plugin;
+	/* Watchdog trips and unexpected ends of the read stream. */
+	uint64_t stalls;
+	/* Completed recovery steps: purging the FTDI buffers,
+	 * resetting the FT2232H and reopening it. */
+	uint64_t recover_purge;
+	uint64_t recover_reset;
+	uint64_t recover_reopen;
+	/* Recovery attempts that failed. */
+	uint64_t recover_failed;
+	/* Times the open radar was unplugged and plugged back in. */
+	uint64_t detaches;
+	uint64_t attaches;
+	/* Ramp delay changes made by the sweep rate governor. */
+	uint64_t governor_changes;
+};
+
 int fmcw_open();
+int fmcw_open_serial(const char *serial);
+int fmcw_open_emulated(const char *replay_path, double sweep_rate);
+int fmcw_set_hotplug(int enable);
+int fmcw_set_control(int enable);
+void fmcw_set_profile(int enable);
+int fmcw_get_profile(int stage, struct PerfCounts *counts);
 void fmcw_close();
 int fmcw_start_acquisition(char *log_path, int sample_bits, int sweep_len, int fft);
-int fmcw_read_sweep(int *arr);
+int fmcw_read_sweep(int *arr, struct SweepMeta *meta);
 int fmcw_add_write(uint32_t val, int nbytes);
 int fmcw_write_pending();
+void fmcw_set_max_overflow(int max_overflow);
+void fmcw_get_stats(struct FmcwStats *stats);
+void fmcw_set_watchdog(double timeout);
+int fmcw_set_governor(double step_time, int min_steps, int max_steps);
+int fmcw_add_plugin(const char *path, const char *args, double spacing, double sweep_rate);
+void fmcw_set_zones(struct Zones *zones);
+int fmcw_sweep_eventfd();
+uint64_t fmcw_submit_pending();
+int fmcw_command_eventfd();
+int fmcw_pop_command(uint64_t *id, int *ok);
 
 #endif
@@ -0,0 +1,262 @@
+#include "discovery.h"
+#include <libusb.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define VENDOR_ID 0x0403
+#define MODEL_ID 0x6010
+#define TRUE 1
+#define FALSE 0
+/* USB 3.0 limits a port chain to 7 hubs */
+#define MAX_PORTS 7
+#define EVENT_QUEUE_LEN 32
+#define POLL_US 100000
+/* udev may not have set permissions by the time a board arrives */
+#define OPEN_RETRIES 10
+#define OPEN_RETRY_NS 100000000
+
+struct DiscoveryEvent {
+	libusb_device *dev;
+	int attached;
+};
+
+struct DiscoveryEntry {
+	libusb_device *dev;
+	struct FmcwDeviceInfo info;
+};
+
+struct Discovery {
+	libusb_context *ctx;
+	libusb_hotplug_callback_handle handle;
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	int quit;
+	discovery_cb cb;
+	void *userdata;
+	/* Filled by the hotplug callback and drained after each call to
+	 * libusb_handle_events, both on the discovery thread. */
+	struct DiscoveryEvent queue[EVENT_QUEUE_LEN];
+	int nqueue;
+	/* attached boards */
+	struct DiscoveryEntry entries[DISCOVERY_MAX_DEVICES];
+	int nentries;
+};
+
+/**
+ * Fill @info from @dev, trying to open it up to @retries times to read
+ * its string descriptors.
+ */
+static void device_info(libusb_device *dev, struct FmcwDeviceInfo *info, int retries);
+static void get_string(libusb_device_handle *hdl, uint8_t idx, char *buf);
+static int radar_p(libusb_device *dev);
+static int LIBUSB_CALL hotplug_cb(libusb_context *ctx, libusb_device *dev,
+				  libusb_hotplug_event event, void *userdata);
+static void dispatch_events(struct Discovery *disc);
+static void *discovery_thread(void *arg);
+
+int discovery_list(struct FmcwDeviceInfo *info, int max)
+{
+	libusb_context *ctx;
+	if (libusb_init(&ctx) < 0) {
+		return -1;
+	}
+
+	libusb_device **list;
+	ssize_t ndev = libusb_get_device_list(ctx, &list);
+	if (ndev < 0) {
+		libusb_exit(ctx);
+		return -1;
+	}
+
+	int nradar = 0;
+	for (ssize_t i = 0; i < ndev; ++i) {
+		if (!radar_p(list[i])) {
+			continue;
+		}
+		if (nradar < max) {
+			device_info(list[i], &info[nradar], 1);
+		}
+		++nradar;
+	}
+
+	libusb_free_device_list(list, 1);
+	libusb_exit(ctx);
+	return nradar;
+}
+
+struct Discovery *discovery_new(discovery_cb cb, void *userdata)
+{
+	struct Discovery *disc = calloc(1, sizeof(struct Discovery));
+	if (disc == NULL) {
+		return NULL;
+	}
+	disc->cb = cb;
+	disc->userdata = userdata;
+	pthread_mutex_init(&disc->mutex, NULL);
+
+	if (libusb_init(&disc->ctx) < 0) {
+		free(disc);
+		return NULL;
+	}
+	if (!libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) {
+		fputs("libusb hotplug is not supported on this platform.\n", stderr);
+		libusb_exit(disc->ctx);
+		free(disc);
+		return NULL;
+	}
+
+	/* boards already attached are enumerated into the queue here */
+	if (libusb_hotplug_register_callback(
+		    disc->ctx, LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT,
+		    LIBUSB_HOTPLUG_ENUMERATE, VENDOR_ID, MODEL_ID, LIBUSB_HOTPLUG_MATCH_ANY,
+		    &hotplug_cb, disc, &disc->handle) != LIBUSB_SUCCESS) {
+		fputs("Failed to register hotplug callback.\n", stderr);
+		libusb_exit(disc->ctx);
+		free(disc);
+		return NULL;
+	}
+
+	pthread_create(&disc->thread, NULL, &discovery_thread, disc);
+	return disc;
+}
+
+void discovery_free(struct Discovery *disc)
+{
+	if (disc == NULL) {
+		return;
+	}
+
+	pthread_mutex_lock(&disc->mutex);
+	disc->quit = TRUE;
+	pthread_mutex_unlock(&disc->mutex);
+	pthread_join(disc->thread, NULL);
+
+	libusb_hotplug_deregister_callback(disc->ctx, disc->handle);
+	for (int i = 0; i < disc->nqueue; ++i) {
+		libusb_unref_device(disc->queue[i].dev);
+	}
+	for (int i = 0; i < disc->nentries; ++i) {
+		libusb_unref_device(disc->entries[i].dev);
+	}
+	libusb_exit(disc->ctx);
+	pthread_mutex_destroy(&disc->mutex);
+	free(disc);
+}
+
+void *discovery_thread(void *arg)
+{
+	struct Discovery *disc = arg;
+	struct timeval tv = {0, POLL_US};
+
+	while (1) {
+		pthread_mutex_lock(&disc->mutex);
+		int quit = disc->quit;
+		pthread_mutex_unlock(&disc->mutex);
+		if (quit) {
+			return NULL;
+		}
+		dispatch_events(disc);
+		libusb_handle_events_timeout_completed(disc->ctx, &tv, NULL);
+	}
+}
+
+int hotplug_cb(libusb_context *ctx, libusb_device *dev, libusb_hotplug_event event,
+	       void *userdata)
+{
+	/* Blocking libusb calls are not allowed here, so the descriptor
+	 * strings are read later by dispatch_events. */
+	struct Discovery *disc = userdata;
+	if (disc->nqueue == EVENT_QUEUE_LEN) {
+		fputs("Discovery event queue full, dropping event.\n", stderr);
+		return 0;
+	}
+	disc->queue[disc->nqueue].dev = libusb_ref_device(dev);
+	disc->queue[disc->nqueue].attached = event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED;
+	++disc->nqueue;
+	return 0;
+}
+
+void dispatch_events(struct Discovery *disc)
+{
+	for (int i = 0; i < disc->nqueue; ++i) {
+		struct DiscoveryEvent *ev = &disc->queue[i];
+		if (ev->attached) {
+			if (disc->nentries == DISCOVERY_MAX_DEVICES) {
+				fputs("Too many radars attached, ignoring new arrival.\n", stderr);
+			} else {
+				struct DiscoveryEntry *entry = &disc->entries[disc->nentries++];
+				entry->dev = libusb_ref_device(ev->dev);
+				device_info(ev->dev, &entry->info, OPEN_RETRIES);
+				disc->cb(&entry->info, TRUE, disc->userdata);
+			}
+		} else {
+			for (int j = 0; j < disc->nentries; ++j) {
+				if (disc->entries[j].dev != ev->dev) {
+					continue;
+				}
+				struct FmcwDeviceInfo info = disc->entries[j].info;
+				libusb_unref_device(disc->entries[j].dev);
+				disc->entries[j] = disc->entries[--disc->nentries];
+				disc->cb(&info, FALSE, disc->userdata);
+				break;
+			}
+		}
+		libusb_unref_device(ev->dev);
+	}
+	disc->nqueue = 0;
+}
+
+void device_info(libusb_device *dev, struct FmcwDeviceInfo *info, int retries)
+{
+	memset(info, 0, sizeof(struct FmcwDeviceInfo));
+	info->bus = libusb_get_bus_number(dev);
+	info->address = libusb_get_device_address(dev);
+
+	uint8_t ports[MAX_PORTS];
+	int nports = libusb_get_port_numbers(dev, ports, MAX_PORTS);
+	int len = snprintf(info->path, DISCOVERY_PATH_LEN, "%d", info->bus);
+	for (int i = 0; i < nports && len < DISCOVERY_PATH_LEN; ++i) {
+		len += snprintf(info->path + len, DISCOVERY_PATH_LEN - len, "%c%d", i ? '.' : '-',
+				ports[i]);
+	}
+
+	struct libusb_device_descriptor desc;
+	if (libusb_get_device_descriptor(dev, &desc) < 0) {
+		return;
+	}
+	info->release = desc.bcdDevice;
+
+	libusb_device_handle *hdl;
+	struct timespec delay = {0, OPEN_RETRY_NS};
+	for (int i = 0; libusb_open(dev, &hdl) < 0; ++i) {
+		if (i + 1 >= retries) {
+			return;
+		}
+		nanosleep(&delay, NULL);
+	}
+	get_string(hdl, desc.iSerialNumber, info->serial);
+	get_string(hdl, desc.iManufacturer, info->manufacturer);
+	get_string(hdl, desc.iProduct, info->product);
+	libusb_close(hdl);
+}
+
+void get_string(libusb_device_handle *hdl, uint8_t idx, char *buf)
+{
+	if (idx == 0 ||
+	    libusb_get_string_descriptor_ascii(hdl, idx, (unsigned char *)buf, DISCOVERY_STR_LEN) <
+		    0) {
+		buf[0] = '\0';
+	}
+}
+
+int radar_p(libusb_device *dev)
+{
+	struct libusb_device_descriptor desc;
+	if (libusb_get_device_descriptor(dev, &desc) < 0) {
+		return FALSE;
+	}
+	return desc.idVendor == VENDOR_ID && desc.idProduct == MODEL_ID;
+}
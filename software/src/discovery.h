@@ -0,0 +1,56 @@
+#ifndef __DISCOVERY_H__
+#define __DISCOVERY_H__
+
+#include <stdint.h>
+
+#define DISCOVERY_STR_LEN 64
+#define DISCOVERY_PATH_LEN 32
+#define DISCOVERY_MAX_DEVICES 16
+
+/** Description of an attached radar.
+ */
+struct FmcwDeviceInfo {
+	char serial[DISCOVERY_STR_LEN];
+	char manufacturer[DISCOVERY_STR_LEN];
+	char product[DISCOVERY_STR_LEN];
+	/* Bus and port chain, e.g. "1-2.4", matching the sysfs name. */
+	char path[DISCOVERY_PATH_LEN];
+	int bus;
+	int address;
+	/* bcdDevice from the device descriptor. */
+	uint16_t release;
+};
+
+/** Watches for radars being attached and detached.
+ *
+ * libusb hotplug events are handled on a dedicated thread, which
+ * keeps a registry of attached boards. Descriptor strings are read
+ * when a board arrives, so that it can still be identified by serial
+ * once it has left.
+ */
+struct Discovery;
+
+/** Called on the discovery thread for each board that arrives
+ * (@attached is 1) or leaves (@attached is 0). Boards already present
+ * when discovery starts are reported as arriving. The callback should
+ * return promptly, since it delays the handling of later events.
+ */
+typedef void (*discovery_cb)(const struct FmcwDeviceInfo *info, int attached, void *userdata);
+
+/** List the attached radars.
+ *
+ * Fills up to @max entries of @info and returns the number of radars
+ * found, or -1 on failure.
+ */
+int discovery_list(struct FmcwDeviceInfo *info, int max);
+
+/** Start watching for radars, calling @cb for each event.
+ *
+ * Returns NULL if hotplug is not supported on this platform or on
+ * failure.
+ */
+struct Discovery *discovery_new(discovery_cb cb, void *userdata);
+
+void discovery_free(struct Discovery *disc);
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef __FMCW_PLUGIN_H__
+#define __FMCW_PLUGIN_H__
+
+#include "sweep.h"
+#include <stdint.h>
+
+/** Processing stage plugin ABI.
+ *
+ * A plugin is a shared object exporting FMCW_PLUGIN_ENTRY, a function
+ * returning a pointer to a static struct FmcwPlugin. The host checks
+ * abi_version against FMCW_PLUGIN_ABI_VERSION and refuses plugins
+ * built against another version. Within a version, structs are only
+ * extended by appending fields, and struct SweepMeta (sweep.h) is part
+ * of the ABI.
+ *
+ * Plugins are inserted at named points of the pipeline:
+ *
+ *   sweep   Producer thread, on each parsed sweep before it is handed
+ *           to the consumer. FMCW_SAMPLE_INT32, in place only.
+ *   input   Processing, after interference repair and chirp correction
+ *           and before the FIR. FMCW_SAMPLE_DOUBLE, in place only.
+ *   output  Processing, on the sweep or dB spectrum about to be
+ *           displayed. FMCW_SAMPLE_DOUBLE, and the plugin may change
+ *           the length.
+ *
+ * Sweep buffers are passed without copying. A plugin is only ever
+ * called from one thread at a time, but not necessarily the thread
+ * that created it.
+ */
+
+#define FMCW_PLUGIN_ABI_VERSION 1
+/* Name of the exported entry point. */
+#define FMCW_PLUGIN_ENTRY "fmcw_plugin_entry"
+
+/* Sample types. */
+#define FMCW_SAMPLE_INT32 0
+#define FMCW_SAMPLE_DOUBLE 1
+
+/* Sample domains. */
+#define FMCW_DOMAIN_TIME 0
+/* Linear magnitude spectrum. */
+#define FMCW_DOMAIN_SPECTRUM 1
+/* Magnitude spectrum in dB, clipped to the display range. */
+#define FMCW_DOMAIN_DB 2
+
+/* Return values of process. */
+#define FMCW_PLUGIN_OK 0
+/* Discard this sweep. */
+#define FMCW_PLUGIN_DROP 1
+#define FMCW_PLUGIN_ERROR -1
+
+/** Layout of the sweeps passing a pipeline point.
+ */
+struct FmcwFormat {
+	/* Samples per sweep. */
+	int len;
+	/* FMCW_SAMPLE_* */
+	int type;
+	/* FMCW_DOMAIN_* */
+	int domain;
+	/* Sample rate (Hz) in the time domain, or bin spacing (Hz) in the
+	 * spectral domains. */
+	double spacing;
+	/* Sweeps per second, or 0 if unknown. */
+	double sweep_rate;
+};
+
+struct FmcwPlugin {
+	/* FMCW_PLUGIN_ABI_VERSION the plugin was built against. */
+	uint32_t abi_version;
+	const char *name;
+	/** Create the plugin state in @state for sweeps of format @in,
+	 * configured by the user string @args (never NULL).
+	 *
+	 * @out starts as a copy of @in. A plugin that produces a
+	 * different format sets it here, where the point allows it.
+	 *
+	 * Returns 0 on success.
+	 */
+	int (*init)(void **state, const char *args, const struct FmcwFormat *in,
+		    struct FmcwFormat *out);
+	/** Process one sweep from @in into @out, which is the same buffer
+	 * as @in unless init changed the format. @meta may be updated.
+	 *
+	 * Returns FMCW_PLUGIN_OK, FMCW_PLUGIN_DROP or FMCW_PLUGIN_ERROR.
+	 */
+	int (*process)(void *state, const void *in, void *out, struct SweepMeta *meta);
+	/** Release @state. May be NULL.
+	 */
+	void (*finish)(void *state);
+};
+
+typedef const struct FmcwPlugin *(*fmcw_plugin_entry_fn)(void);
+
+#endif
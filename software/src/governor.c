@@ -0,0 +1,107 @@
+#include "governor.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define TRUE 1
+#define FALSE 0
+
+struct Governor {
+	double step_time;
+	int min_steps;
+	int max_steps;
+	/* shortest period the consumer sustained, 0 until a drop */
+	double limit;
+	/* start of the window, negative before the first frame */
+	double start;
+	uint64_t frames;
+	uint64_t dropped;
+	double waiting;
+	/* the ramp restarted during the current window */
+	int settling;
+};
+
+/**
+ * Begin a window with the totals at @now.
+ */
+static void restart(struct Governor *gov, double now, uint64_t frames, uint64_t dropped,
+		    double waiting);
+
+struct Governor *governor_new(double step_time, int min_steps, int max_steps)
+{
+	if (step_time <= 0 || min_steps < 0 || max_steps < min_steps) {
+		return NULL;
+	}
+	struct Governor *gov = calloc(1, sizeof(struct Governor));
+	if (gov == NULL) {
+		return NULL;
+	}
+	gov->step_time = step_time;
+	gov->min_steps = min_steps;
+	gov->max_steps = max_steps;
+	gov->start = -1;
+	return gov;
+}
+
+void governor_free(struct Governor *gov) { free(gov); }
+
+int governor_update(struct Governor *gov, double now, uint64_t frames, uint64_t dropped,
+		    double waiting, int steps)
+{
+	if (gov->start < 0) {
+		restart(gov, now, frames, dropped, waiting);
+		return steps;
+	}
+	double elapsed = now - gov->start;
+	uint64_t nframes = frames - gov->frames;
+	uint64_t ndropped = dropped - gov->dropped;
+	if (elapsed < GOVERNOR_WINDOW || nframes < GOVERNOR_MIN_FRAMES) {
+		return steps;
+	}
+	double waited = (waiting - gov->waiting) / elapsed;
+	int settling = gov->settling;
+	restart(gov, now, frames, dropped, waiting);
+	if (settling) {
+		return steps;
+	}
+
+	/* dropped frames were still produced at the same period */
+	double period = elapsed / (nframes + ndropped);
+	double target;
+	if (ndropped) {
+		/* the consumer read nframes in the time of nframes + ndropped */
+		gov->limit = period * (nframes + ndropped) / nframes;
+		target = gov->limit * (1 + GOVERNOR_MARGIN);
+	} else {
+		gov->limit *= 1 - GOVERNOR_DECAY;
+		if (waited > GOVERNOR_WAITING) {
+			return steps;
+		}
+		target = period * (1 - GOVERNOR_SPEEDUP);
+		if (target < gov->limit * (1 + GOVERNOR_MARGIN)) {
+			target = gov->limit * (1 + GOVERNOR_MARGIN);
+		}
+		if (target >= period) {
+			return steps;
+		}
+	}
+
+	long next = steps + lround((target - period) / gov->step_time);
+	if (next < gov->min_steps) {
+		next = gov->min_steps;
+	} else if (next > gov->max_steps) {
+		next = gov->max_steps;
+	}
+	if (next != steps) {
+		gov->settling = TRUE;
+	}
+	return (int)next;
+}
+
+void restart(struct Governor *gov, double now, uint64_t frames, uint64_t dropped, double waiting)
+{
+	gov->start = now;
+	gov->frames = frames;
+	gov->dropped = dropped;
+	gov->waiting = waiting;
+	gov->settling = FALSE;
+}
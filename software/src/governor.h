@@ -0,0 +1,60 @@
+#ifndef __GOVERNOR_H__
+#define __GOVERNOR_H__
+
+#include <stdint.h>
+
+/* Seconds of frames observed before each adjustment. */
+#define GOVERNOR_WINDOW 1.0
+/* Fewer frames than this in a window are too few to judge. */
+#define GOVERNOR_MIN_FRAMES 8
+/* Sweep period kept above the measured limit, as a fraction. */
+#define GOVERNOR_MARGIN 0.1
+/* Without drops, the period is shortened by this fraction per window
+ * while sweeps wait for the consumer less than GOVERNOR_WAITING of the
+ * time. */
+#define GOVERNOR_SPEEDUP 0.05
+#define GOVERNOR_WAITING 0.2
+/* Fraction by which the remembered limit relaxes per window without
+ * drops, so a consumer that became faster is eventually found. */
+#define GOVERNOR_DECAY 0.01
+
+/** Closed-loop sweep rate governor.
+ *
+ * Chooses the ADF4158 delay between ramps so that the radar produces
+ * sweeps about as fast as the consumer reads them. Sweeps that arrive
+ * while the previous one is unread are dropped, and the fraction
+ * dropped over a window gives the shortest period the consumer
+ * sustained, which is remembered as a limit. The period is then set
+ * GOVERNOR_MARGIN above that limit. Without drops, the period is only
+ * shortened while sweeps rarely wait for the consumer, and never below
+ * the limit, so the rate settles rather than oscillating around the
+ * point where drops begin.
+ *
+ * Each adjustment restarts the ramp, so the window after one is
+ * discarded.
+ */
+struct Governor;
+
+/** Create a governor for a delay clock period of @step_time seconds,
+ * keeping the delay within @min_steps and @max_steps.
+ *
+ * Returns NULL on failure.
+ */
+struct Governor *governor_new(double step_time, int min_steps, int max_steps);
+
+void governor_free(struct Governor *gov);
+
+/** Account for a frame completed at @now (s).
+ *
+ * @frames and @dropped are the totals of frames parsed and frames
+ * dropped because the consumer had not read the previous sweep, and
+ * @waiting the total seconds that sweeps waited to be read. @steps is
+ * the current delay.
+ *
+ * Returns the delay to use from now on, which is @steps if it should
+ * not change.
+ */
+int governor_update(struct Governor *gov, double now, uint64_t frames, uint64_t dropped,
+		    double waiting, int steps);
+
+#endif
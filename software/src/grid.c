@@ -0,0 +1,129 @@
+#include "grid.h"
+#include "pool.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define TRUE 1
+#define FALSE 0
+
+struct RangeGrid {
+	double start;
+	double step;
+	int len;
+	/* profile the weights were built for */
+	int nbins;
+	double bin_dist;
+	/* weights of point i are at [row[i], row[i + 1]) */
+	int *row;
+	int *col;
+	double *weight;
+};
+
+/**
+ * Build the weights for profiles of @nbins bins @bin_dist apart.
+ */
+static int build(struct RangeGrid *grid, int nbins, double bin_dist);
+
+struct RangeGrid *grid_new(double start, double step, int len)
+{
+	if (step <= 0 || len <= 0) {
+		return NULL;
+	}
+	struct RangeGrid *grid = pool_calloc(POOL_DSP, 1, sizeof(struct RangeGrid));
+	if (grid == NULL) {
+		return NULL;
+	}
+	grid->start = start;
+	grid->step = step;
+	grid->len = len;
+	grid->row = pool_calloc(POOL_DSP, len + 1, sizeof(int));
+	if (grid->row == NULL) {
+		pool_free(grid);
+		return NULL;
+	}
+	return grid;
+}
+
+void grid_free(struct RangeGrid *grid)
+{
+	if (grid == NULL) {
+		return;
+	}
+	pool_free(grid->row);
+	pool_free(grid->col);
+	pool_free(grid->weight);
+	pool_free(grid);
+}
+
+int grid_map(struct RangeGrid *grid, const double *in, int nbins, double bin_dist, double *out)
+{
+	if ((nbins != grid->nbins || bin_dist != grid->bin_dist) &&
+	    !build(grid, nbins, bin_dist)) {
+		return FALSE;
+	}
+
+	for (int i = 0; i < grid->len; ++i) {
+		double acc = 0;
+		for (int k = grid->row[i]; k < grid->row[i + 1]; ++k) {
+			acc += grid->weight[k] * in[grid->col[k]];
+		}
+		out[i] = acc;
+	}
+	return TRUE;
+}
+
+int grid_nweights(const struct RangeGrid *grid) { return grid->row[grid->len]; }
+
+int build(struct RangeGrid *grid, int nbins, double bin_dist)
+{
+	if (nbins <= 0 || bin_dist <= 0) {
+		return FALSE;
+	}
+	double half = grid->step > bin_dist ? grid->step : bin_dist;
+	/* bins strictly within half of a point */
+	int per_point = (int)(2 * half / bin_dist) + 1;
+	int *col = pool_realloc(POOL_DSP, grid->col, (size_t)grid->len * per_point * sizeof(int));
+	if (col == NULL) {
+		return FALSE;
+	}
+	grid->col = col;
+	double *weight =
+		pool_realloc(POOL_DSP, grid->weight, (size_t)grid->len * per_point * sizeof(double));
+	if (weight == NULL) {
+		return FALSE;
+	}
+	grid->weight = weight;
+
+	int nweights = 0;
+	for (int i = 0; i < grid->len; ++i) {
+		grid->row[i] = nweights;
+		double dist = grid->start + i * grid->step;
+		int lo = (int)ceil((dist - half) / bin_dist);
+		int hi = (int)floor((dist + half) / bin_dist);
+		if (lo < 0) {
+			lo = 0;
+		}
+		if (hi > nbins - 1) {
+			hi = nbins - 1;
+		}
+
+		double sum = 0;
+		int first = nweights;
+		for (int j = lo; j <= hi; ++j) {
+			double w = 1 - fabs(j * bin_dist - dist) / half;
+			if (w <= 0) {
+				continue;
+			}
+			grid->col[nweights] = j;
+			grid->weight[nweights++] = w;
+			sum += w;
+		}
+		for (int k = first; k < nweights; ++k) {
+			grid->weight[k] /= sum;
+		}
+	}
+	grid->row[grid->len] = nweights;
+	grid->nbins = nbins;
+	grid->bin_dist = bin_dist;
+	return TRUE;
+}
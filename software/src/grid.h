@@ -0,0 +1,38 @@
+#ifndef __GRID_H__
+#define __GRID_H__
+
+/** Resampling of range profiles onto a fixed distance grid.
+ *
+ * The bin spacing of a range profile depends on the sweep bandwidth,
+ * sweep time and decimation, so profiles captured with different
+ * settings do not line up. A grid maps each profile onto @len points
+ * at @start + i * @step meters. Each point is a weighted sum of the
+ * bins within one grid step or one bin of it, whichever is wider,
+ * with triangular weights normalized to 1. This is linear
+ * interpolation when the grid is finer than the bins and averaging
+ * when it is coarser. Points outside the profile are 0.
+ *
+ * The weights are kept in compressed sparse rows, so mapping costs a
+ * few multiply-adds per grid point. They are rebuilt only when the
+ * profile length or bin spacing changes.
+ */
+struct RangeGrid;
+
+/** Returns NULL on failure.
+ */
+struct RangeGrid *grid_new(double start, double step, int len);
+
+void grid_free(struct RangeGrid *grid);
+
+/** Map the profile @in of @nbins bins, each @bin_dist meters apart, to
+ * the grid's points in @out.
+ *
+ * Returns FALSE if the weights could not be built.
+ */
+int grid_map(struct RangeGrid *grid, const double *in, int nbins, double bin_dist, double *out);
+
+/** Number of weights in use, for estimating the cost of grid_map.
+ */
+int grid_nweights(const struct RangeGrid *grid);
+
+#endif
@@ -0,0 +1,194 @@
+#include "integrate.h"
+#include "pool.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRUE 1
+#define FALSE 0
+
+struct Integrator {
+	int mode;
+	int len;
+	int cplx;
+	int window;
+	int stride;
+	/* doubles per sweep in the sum and the ring */
+	int width;
+	double *sum;
+	/* the last @window sweeps, only kept for sliding windows */
+	double *ring;
+	/* sequence number and flags of each slot */
+	uint64_t *seq;
+	uint32_t *flags;
+	/* next slot to fill and number of sweeps in the window */
+	int head;
+	int count;
+	/* sweeps pushed since the last result and the last re-sum */
+	int since;
+	int since_sum;
+	/* sequence number for sweeps pushed without metadata */
+	uint64_t next_seq;
+};
+
+/**
+ * Element @i of the sum contributed by @in: the interleaved element
+ * itself for coherent integration, otherwise the magnitude or power of
+ * bin @i.
+ */
+static inline double contribution(const struct Integrator *integ, const double *in, int i);
+/**
+ * Recompute the sum from the ring.
+ */
+static void resum(struct Integrator *integ);
+
+struct Integrator *integrator_new(int mode, int len, int cplx, int window, int stride)
+{
+	if (mode < INTEGRATE_COHERENT || mode > INTEGRATE_POWER || len <= 0 || window <= 0 ||
+	    stride <= 0 || stride > window || (mode == INTEGRATE_COHERENT && !cplx)) {
+		return NULL;
+	}
+	struct Integrator *integ = pool_calloc(POOL_DSP, 1, sizeof(struct Integrator));
+	if (integ == NULL) {
+		return NULL;
+	}
+	integ->mode = mode;
+	integ->len = len;
+	integ->cplx = cplx;
+	integ->window = window;
+	integ->stride = stride;
+	integ->width = mode == INTEGRATE_COHERENT ? 2 * len : len;
+	integ->sum = pool_calloc(POOL_DSP, integ->width, sizeof(double));
+	integ->seq = pool_calloc(POOL_DSP, window, sizeof(uint64_t));
+	integ->flags = pool_calloc(POOL_DSP, window, sizeof(uint32_t));
+	if (stride < window) {
+		integ->ring = pool_calloc(POOL_DSP, (size_t)window * integ->width, sizeof(double));
+	}
+	if (integ->sum == NULL || integ->seq == NULL || integ->flags == NULL ||
+	    (stride < window && integ->ring == NULL)) {
+		integrator_free(integ);
+		return NULL;
+	}
+	return integ;
+}
+
+void integrator_free(struct Integrator *integ)
+{
+	if (integ == NULL) {
+		return;
+	}
+	pool_free(integ->sum);
+	pool_free(integ->ring);
+	pool_free(integ->seq);
+	pool_free(integ->flags);
+	pool_free(integ);
+}
+
+int integrator_push(struct Integrator *integ, const double *in, const struct SweepMeta *meta)
+{
+	double *sum = integ->sum;
+	int width = integ->width;
+
+	if (integ->ring == NULL) {
+		/* the previous block was emitted */
+		if (integ->count == integ->window) {
+			memset(sum, 0, width * sizeof(double));
+			integ->count = 0;
+		}
+		for (int i = 0; i < width; ++i) {
+			sum[i] += contribution(integ, in, i);
+		}
+	} else {
+		double *slot = integ->ring + (size_t)integ->head * width;
+		if (integ->count == integ->window) {
+			for (int i = 0; i < width; ++i) {
+				double val = contribution(integ, in, i);
+				sum[i] += val - slot[i];
+				slot[i] = val;
+			}
+		} else {
+			for (int i = 0; i < width; ++i) {
+				double val = contribution(integ, in, i);
+				sum[i] += val;
+				slot[i] = val;
+			}
+		}
+	}
+
+	integ->seq[integ->head] = meta ? meta->seq : integ->next_seq;
+	integ->flags[integ->head] = meta ? meta->flags : 0;
+	integ->next_seq = integ->seq[integ->head] + 1;
+	integ->head = (integ->head + 1) % integ->window;
+	if (integ->count < integ->window) {
+		++integ->count;
+	}
+
+	if (integ->ring && ++integ->since_sum == integ->window) {
+		resum(integ);
+		integ->since_sum = 0;
+	}
+	if (++integ->since >= integ->stride && integ->count == integ->window) {
+		integ->since = 0;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+int integrator_result(struct Integrator *integ, double *out, struct IntegrateMeta *meta)
+{
+	if (integ->count == 0) {
+		return FALSE;
+	}
+	double scale = 1.0 / integ->count;
+	for (int i = 0; i < integ->width; ++i) {
+		out[i] = integ->sum[i] * scale;
+	}
+
+	if (meta) {
+		int oldest = (integ->head - integ->count + integ->window) % integ->window;
+		int newest = (integ->head - 1 + integ->window) % integ->window;
+		meta->first_seq = integ->seq[oldest];
+		meta->last_seq = integ->seq[newest];
+		meta->nsweeps = integ->count;
+		meta->flags = 0;
+		for (int i = 0; i < integ->count; ++i) {
+			meta->flags |= integ->flags[(oldest + i) % integ->window];
+		}
+	}
+	return TRUE;
+}
+
+void integrator_reset(struct Integrator *integ)
+{
+	memset(integ->sum, 0, integ->width * sizeof(double));
+	integ->head = 0;
+	integ->count = 0;
+	integ->since = 0;
+	integ->since_sum = 0;
+}
+
+double contribution(const struct Integrator *integ, const double *in, int i)
+{
+	if (integ->mode == INTEGRATE_COHERENT) {
+		/* interleaved complex, summed as is */
+		return in[i];
+	}
+	double re = integ->cplx ? in[2 * i] : in[i];
+	double im = integ->cplx ? in[2 * i + 1] : 0;
+	if (integ->mode == INTEGRATE_MAGNITUDE) {
+		return integ->cplx ? hypot(re, im) : fabs(re);
+	}
+	return re * re + im * im;
+}
+
+void resum(struct Integrator *integ)
+{
+	int width = integ->width;
+	memset(integ->sum, 0, width * sizeof(double));
+	for (int s = 0; s < integ->count; ++s) {
+		const double *slot = integ->ring + (size_t)s * width;
+		for (int i = 0; i < width; ++i) {
+			integ->sum[i] += slot[i];
+		}
+	}
+}
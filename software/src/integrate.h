@@ -0,0 +1,71 @@
+#ifndef __INTEGRATE_H__
+#define __INTEGRATE_H__
+
+#include "sweep.h"
+#include <stdint.h>
+
+/* Integration modes. Coherent integration averages complex bins, so
+ * it needs complex input and gains against noise only while the
+ * target's phase is stable. Incoherent integration averages bin
+ * magnitudes or powers and works on any input. */
+#define INTEGRATE_COHERENT 0
+#define INTEGRATE_MAGNITUDE 1
+#define INTEGRATE_POWER 2
+
+/** Sweeps that contributed to an integrated result.
+ */
+struct IntegrateMeta {
+	/* Sequence numbers of the first and last sweeps. */
+	uint64_t first_seq;
+	uint64_t last_seq;
+	/* Number of sweeps averaged. Fewer than last_seq - first_seq + 1
+	 * means some sweeps in between were dropped. */
+	int nsweeps;
+	/* SWEEP_FLAG_* bits of any contributing sweep. */
+	uint32_t flags;
+};
+
+/** Multi-sweep integration.
+ *
+ * Averages each bin over a window of @window sweeps and emits a result
+ * every @stride sweeps. With @stride equal to @window the windows are
+ * consecutive blocks, and the sum is simply cleared after each result.
+ * With a smaller @stride the windows slide, and the last @window
+ * sweeps are kept in a ring so that each new sweep updates the running
+ * sum in constant time per bin, by adding it and subtracting the sweep
+ * it replaces. The sum is recomputed from the ring once per window, so
+ * rounding errors cannot accumulate.
+ */
+struct Integrator;
+
+/** Integrate sweeps of @len bins in @mode (INTEGRATE_*). Sweeps are
+ * complex, as interleaved real and imaginary parts, if @cplx is TRUE
+ * and real otherwise.
+ *
+ * Returns NULL if the arguments are invalid, if coherent integration
+ * is requested for real input, or on failure.
+ */
+struct Integrator *integrator_new(int mode, int len, int cplx, int window, int stride);
+
+void integrator_free(struct Integrator *integ);
+
+/** Add the sweep @in, described by @meta, which may be NULL.
+ *
+ * Returns TRUE if a result is ready for integrator_result.
+ */
+int integrator_push(struct Integrator *integ, const double *in, const struct SweepMeta *meta);
+
+/** Copy the mean of the current window into @out and a description of
+ * it into @meta, which may be NULL. A coherent result is complex,
+ * interleaved like the input, and otherwise it is @len magnitudes or
+ * powers.
+ *
+ * Returns FALSE if no sweep has been pushed since the last block.
+ */
+int integrator_result(struct Integrator *integ, double *out, struct IntegrateMeta *meta);
+
+/** Forget all sweeps, e.g. after a configuration change.
+ */
+void integrator_reset(struct Integrator *integ);
+
+#endif
@@ -0,0 +1,162 @@
+#include "interference.h"
+#include "pool.h"
+#include <math.h>
+#include <stdlib.h>
+
+struct Interference {
+	int len;
+	int win;
+	double threshold;
+	int guard;
+	int mode;
+	/* detected burst cores, [start, end] inclusive */
+	int *start;
+	int *end;
+	int nregion;
+};
+
+/**
+ * Record the detection window [@lo, @hi], merging it with the
+ * previous region when their guard bands would overlap.
+ */
+static void add_region(struct Interference *intf, int lo, int hi);
+static void repair_region(struct Interference *intf, double *seq, int len, double mean, int lo,
+			  int hi);
+
+struct Interference *interference_new(int len, int win, double threshold, int guard, int mode)
+{
+	if (len <= 0 || win <= 0 || win > len || guard < 0) {
+		return NULL;
+	}
+
+	struct Interference *intf = pool_calloc(POOL_DSP, 1, sizeof(struct Interference));
+	if (intf == NULL) {
+		return NULL;
+	}
+	intf->len = len;
+	intf->win = win;
+	intf->threshold = threshold;
+	intf->guard = guard;
+	intf->mode = mode;
+	intf->start = pool_alloc(POOL_DSP, len * sizeof(int));
+	intf->end = pool_alloc(POOL_DSP, len * sizeof(int));
+	if (intf->start == NULL || intf->end == NULL) {
+		interference_free(intf);
+		return NULL;
+	}
+
+	return intf;
+}
+
+void interference_free(struct Interference *intf)
+{
+	if (intf == NULL) {
+		return;
+	}
+	pool_free(intf->start);
+	pool_free(intf->end);
+	pool_free(intf);
+}
+
+int interference_repair(struct Interference *intf, double *seq, int len, struct SweepMeta *meta)
+{
+	if (len > intf->len) {
+		len = intf->len;
+	}
+
+	double sum = 0;
+	double sumsq = 0;
+	for (int i = 0; i < len; ++i) {
+		sum += seq[i];
+		sumsq += seq[i] * seq[i];
+	}
+	double mean = sum / len;
+	double power = sumsq / len - mean * mean;
+	if (power <= 0) {
+		return 0;
+	}
+
+	/* compare window energy against the threshold without dividing */
+	int win = intf->win;
+	double limit = intf->threshold * power * win;
+	double wsum = 0;
+	intf->nregion = 0;
+	for (int i = 0; i < len; ++i) {
+		double d = seq[i] - mean;
+		wsum += d * d;
+		if (i >= win) {
+			d = seq[i - win] - mean;
+			wsum -= d * d;
+		}
+		if (i >= win - 1 && wsum > limit) {
+			add_region(intf, i - win + 1, i);
+		}
+	}
+
+	int nrepair = 0;
+	for (int r = 0; r < intf->nregion; ++r) {
+		int lo = intf->start[r] - intf->guard;
+		int hi = intf->end[r] + intf->guard;
+		if (lo < 0) {
+			lo = 0;
+		}
+		if (hi > len - 1) {
+			hi = len - 1;
+		}
+		repair_region(intf, seq, len, mean, lo, hi);
+		nrepair += hi - lo + 1;
+	}
+
+	if (meta && nrepair) {
+		meta->flags |= SWEEP_FLAG_INTERFERENCE;
+		meta->interference = nrepair;
+	}
+	return nrepair;
+}
+
+void add_region(struct Interference *intf, int lo, int hi)
+{
+	int last = intf->nregion - 1;
+	if (last >= 0 && lo <= intf->end[last] + 2 * intf->guard + 1) {
+		intf->end[last] = hi;
+		return;
+	}
+	intf->start[intf->nregion] = lo;
+	intf->end[intf->nregion] = hi;
+	++intf->nregion;
+}
+
+void repair_region(struct Interference *intf, double *seq, int len, double mean, int lo, int hi)
+{
+	switch (intf->mode) {
+	case INTERFERENCE_INTERPOLATE: {
+		double left = lo > 0 ? seq[lo - 1] : mean;
+		double right = hi < len - 1 ? seq[hi + 1] : mean;
+		double step = (right - left) / (hi - lo + 2);
+		for (int i = lo; i <= hi; ++i) {
+			seq[i] = left + step * (i - lo + 1);
+		}
+		break;
+	}
+	case INTERFERENCE_TAPER: {
+		/* raised-cosine ramps across the guard bands, mean in the
+		 * detected core */
+		int guard = intf->guard;
+		for (int i = lo; i <= hi; ++i) {
+			int edge = i - lo < hi - i ? i - lo : hi - i;
+			double w = 0;
+			if (edge < guard) {
+				w = 0.5 * (1 + cos(M_PI * (edge + 1) / (guard + 1)));
+			}
+			seq[i] = mean + w * (seq[i] - mean);
+		}
+		break;
+	}
+	default:
+		/* zero the beat signal, leaving the DC level */
+		for (int i = lo; i <= hi; ++i) {
+			seq[i] = mean;
+		}
+		break;
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef __INTERFERENCE_H__
+#define __INTERFERENCE_H__
+
+#include "sweep.h"
+
+#define INTERFERENCE_ZERO 0
+#define INTERFERENCE_TAPER 1
+#define INTERFERENCE_INTERPOLATE 2
+
+/** Time-domain interference burst detection and repair.
+ *
+ * Other FMCW radars sweeping through our band appear as short
+ * high-amplitude bursts in the beat signal. A burst is detected when
+ * the mean power over a sliding window of @win samples exceeds
+ * @threshold times the mean power of the sweep. Each detection is
+ * widened by @guard samples on both sides and then zeroed, tapered to
+ * zero with a raised cosine, or replaced by a line between the
+ * samples that bound it. The stage makes two passes over the sweep
+ * with a handful of operations per sample, plus a pass over the
+ * repaired regions.
+ */
+struct Interference;
+
+/** Returns NULL on failure.
+ */
+struct Interference *interference_new(int len, int win, double threshold, int guard, int mode);
+
+void interference_free(struct Interference *intf);
+
+/** Detect and repair bursts in @seq (@len samples, at most the length
+ * given to interference_new) in place.
+ *
+ * If any samples were repaired, SWEEP_FLAG_INTERFERENCE is set in
+ * @meta (which may be NULL) and its interference field is set to the
+ * number of repaired samples.
+ *
+ * Returns the number of repaired samples.
+ */
+int interference_repair(struct Interference *intf, double *seq, int len, struct SweepMeta *meta);
+
+#endif
@@ -0,0 +1,257 @@
+#include "jtag.h"
+#include <ftdi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define VENDOR_ID 0x0403
+#define MODEL_ID 0x6010
+#define TRUE 1
+#define FALSE 0
+#define LATENCY 2
+/* MPSSE opcodes, clocking data out on the falling edge, LSB first */
+#define MPSSE_BYTES_OUT 0x19
+#define MPSSE_BITS_OUT 0x1B
+/* as MPSSE_BITS_OUT, also reading TDO on the rising edge */
+#define MPSSE_BITS_INOUT 0x3B
+#define MPSSE_TMS_OUT 0x4B
+#define MPSSE_SET_LOW 0x80
+#define MPSSE_LOOPBACK_OFF 0x85
+#define MPSSE_DIVISOR 0x86
+#define MPSSE_DIV5_OFF 0x8A
+#define MPSSE_3PHASE_OFF 0x8D
+#define MPSSE_ADAPTIVE_OFF 0x97
+#define MPSSE_SEND_IMMEDIATE 0x87
+/* TCK = 30MHz / (1 + div), the 3MHz that the openocd scripts use */
+#define TCK_DIV 9
+/* ADBUS value and direction: TCK, TDI and TMS out, TDO in, as in
+ * the openocd interface configuration */
+#define ADBUS_VALUE 0x58
+#define ADBUS_DIR 0x7B
+/* 7-series instruction register */
+#define IR_BITS 6
+#define IR_USER1 0x02
+/* command byte and 32-bit payload */
+#define DR_BYTES 5
+#define RESET_BYTES 3
+#define IR_SCAN_BYTES 9
+#define DR_SCAN_BYTES 18
+/* the gateware discards commands while its FIFO is full, which lasts
+ * at most a frame per command */
+#define BUSY_RETRIES 1000
+#define BUSY_WAIT_US 1000
+#define READ_TRIES 10
+
+struct Jtag {
+	struct ftdi_context *ftdi;
+};
+
+/**
+ * Append an MPSSE sequence to @buf that clocks the low @nbits of @tms
+ * onto TMS, holding TDI at @tdi. Returns the number of bytes appended.
+ */
+static int append_tms(uint8_t *buf, uint8_t tms, int nbits, int tdi);
+/**
+ * Append a scan of USER1 into the instruction register, from and back
+ * to Run-Test/Idle.
+ */
+static int append_ir(uint8_t *buf);
+/**
+ * Append a scan of @cmd and @val into the data register, from and back
+ * to Run-Test/Idle, reading back the first byte the gateware captured.
+ */
+static int append_dr(uint8_t *buf, uint8_t cmd, uint32_t val);
+static int write_all(struct Jtag *jtag, const uint8_t *buf, int len);
+static int read_all(struct Jtag *jtag, uint8_t *buf, int len);
+
+struct Jtag *jtag_new(const char *serial)
+{
+	struct Jtag *jtag = calloc(1, sizeof(struct Jtag));
+	if (jtag == NULL) {
+		return NULL;
+	}
+	if ((jtag->ftdi = ftdi_new()) == NULL) {
+		free(jtag);
+		return NULL;
+	}
+	if (ftdi_set_interface(jtag->ftdi, INTERFACE_B) < 0) {
+		fprintf(stderr, "ftdi_set_interface failed\n");
+		ftdi_free(jtag->ftdi);
+		free(jtag);
+		return NULL;
+	}
+	if (ftdi_usb_open_desc(jtag->ftdi, VENDOR_ID, MODEL_ID, NULL,
+			       serial && serial[0] ? serial : NULL) < 0) {
+		fprintf(stderr, "Can't open control channel: %s\n",
+			ftdi_get_error_string(jtag->ftdi));
+		ftdi_free(jtag->ftdi);
+		free(jtag);
+		return NULL;
+	}
+
+	if (ftdi_set_latency_timer(jtag->ftdi, LATENCY) < 0 ||
+	    ftdi_set_bitmode(jtag->ftdi, 0, BITMODE_RESET) < 0 ||
+	    ftdi_set_bitmode(jtag->ftdi, 0, BITMODE_MPSSE) < 0 ||
+	    ftdi_usb_purge_buffers(jtag->ftdi) < 0) {
+		fprintf(stderr, "Can't set MPSSE mode: %s\n", ftdi_get_error_string(jtag->ftdi));
+		jtag_free(jtag);
+		return NULL;
+	}
+
+	uint8_t buf[16];
+	int len = 0;
+	buf[len++] = MPSSE_DIV5_OFF;
+	buf[len++] = MPSSE_ADAPTIVE_OFF;
+	buf[len++] = MPSSE_3PHASE_OFF;
+	buf[len++] = MPSSE_DIVISOR;
+	buf[len++] = TCK_DIV & 0xFF;
+	buf[len++] = TCK_DIV >> 8;
+	buf[len++] = MPSSE_LOOPBACK_OFF;
+	buf[len++] = MPSSE_SET_LOW;
+	buf[len++] = ADBUS_VALUE;
+	buf[len++] = ADBUS_DIR;
+	/* Test-Logic-Reset, then Run-Test/Idle */
+	len += append_tms(buf + len, 0x1F, 6, 0);
+	if (!write_all(jtag, buf, len)) {
+		jtag_free(jtag);
+		return NULL;
+	}
+	return jtag;
+}
+
+void jtag_free(struct Jtag *jtag)
+{
+	if (jtag == NULL) {
+		return;
+	}
+	ftdi_set_bitmode(jtag->ftdi, 0, BITMODE_RESET);
+	ftdi_usb_close(jtag->ftdi);
+	ftdi_free(jtag->ftdi);
+	free(jtag);
+}
+
+int jtag_write(struct Jtag *jtag, const uint8_t *cmds, const uint32_t *vals, int n)
+{
+	uint8_t *buf = malloc(RESET_BYTES + IR_SCAN_BYTES + n * DR_SCAN_BYTES + 1);
+	uint8_t *busy = malloc(n);
+	if (buf == NULL || busy == NULL) {
+		free(buf);
+		free(busy);
+		return FALSE;
+	}
+
+	int ret = FALSE;
+	int ndone = 0;
+	for (int retry = 0; retry <= BUSY_RETRIES; ++retry) {
+		if (retry) {
+			usleep(BUSY_WAIT_US);
+		}
+		/* Test-Logic-Reset makes the gateware take commands again
+		 * after discarding some, and another JTAG user, such as
+		 * openocd, may have changed the instruction since the last
+		 * write */
+		int len = append_tms(buf, 0x1F, 6, 0);
+		len += append_ir(buf + len);
+		for (int i = ndone; i < n; ++i) {
+			len += append_dr(buf + len, cmds[i], vals[i]);
+		}
+		buf[len++] = MPSSE_SEND_IMMEDIATE;
+		if (!write_all(jtag, buf, len) || !read_all(jtag, busy, n - ndone)) {
+			break;
+		}
+		/* the first discarded command and every one after it are
+		 * sent again */
+		int i = 0;
+		while (i < n - ndone && !(busy[i] & 1)) {
+			++i;
+		}
+		ndone += i;
+		if (ndone == n) {
+			ret = TRUE;
+			break;
+		}
+		if (retry == BUSY_RETRIES) {
+			fprintf(stderr, "Control channel stayed busy\n");
+		}
+	}
+	free(buf);
+	free(busy);
+	return ret;
+}
+
+int append_tms(uint8_t *buf, uint8_t tms, int nbits, int tdi)
+{
+	buf[0] = MPSSE_TMS_OUT;
+	buf[1] = nbits - 1;
+	buf[2] = (tdi ? 0x80 : 0) | tms;
+	return 3;
+}
+
+int append_ir(uint8_t *buf)
+{
+	int len = 0;
+	/* Run-Test/Idle to Shift-IR */
+	len += append_tms(buf + len, 0x03, 4, 0);
+	buf[len++] = MPSSE_BITS_OUT;
+	buf[len++] = IR_BITS - 2;
+	buf[len++] = IR_USER1;
+	/* the last bit moves to Exit1-IR, then Update-IR and
+	 * Run-Test/Idle */
+	len += append_tms(buf + len, 0x03, 3, (IR_USER1 >> (IR_BITS - 1)) & 1);
+	return len;
+}
+
+int append_dr(uint8_t *buf, uint8_t cmd, uint32_t val)
+{
+	uint8_t dr[DR_BYTES] = {cmd, val, val >> 8, val >> 16, val >> 24};
+	int len = 0;
+	/* Run-Test/Idle to Shift-DR */
+	len += append_tms(buf + len, 0x01, 3, 0);
+	/* bit 0 of the captured value is set when the gateware will
+	 * discard this scan */
+	buf[len++] = MPSSE_BITS_INOUT;
+	buf[len++] = 7;
+	buf[len++] = dr[0];
+	buf[len++] = MPSSE_BYTES_OUT;
+	buf[len++] = DR_BYTES - 3;
+	buf[len++] = 0;
+	memcpy(buf + len, dr + 1, DR_BYTES - 2);
+	len += DR_BYTES - 2;
+	buf[len++] = MPSSE_BITS_OUT;
+	buf[len++] = 6;
+	buf[len++] = dr[DR_BYTES - 1];
+	/* the last bit moves to Exit1-DR, then Update-DR and
+	 * Run-Test/Idle */
+	len += append_tms(buf + len, 0x03, 3, dr[DR_BYTES - 1] >> 7);
+	return len;
+}
+
+int read_all(struct Jtag *jtag, uint8_t *buf, int len)
+{
+	int nread = 0;
+	for (int try = 0; nread < len && try < READ_TRIES; ++try) {
+		int ret = ftdi_read_data(jtag->ftdi, buf + nread, len - nread);
+		if (ret < 0) {
+			fprintf(stderr, "Control channel read failed: %s\n",
+				ftdi_get_error_string(jtag->ftdi));
+			return FALSE;
+		}
+		nread += ret;
+	}
+	if (nread < len) {
+		fprintf(stderr, "Control channel read timed out\n");
+		return FALSE;
+	}
+	return TRUE;
+}
+
+int write_all(struct Jtag *jtag, const uint8_t *buf, int len)
+{
+	if (ftdi_write_data(jtag->ftdi, buf, len) != len) {
+		fprintf(stderr, "Control channel write failed: %s\n",
+			ftdi_get_error_string(jtag->ftdi));
+		return FALSE;
+	}
+	return TRUE;
+}
@@ -0,0 +1,37 @@
+#ifndef __JTAG_H__
+#define __JTAG_H__
+
+#include <stdint.h>
+
+/** Control channel on the FT2232H's interface B.
+ *
+ * Interface B is wired to the FPGA's JTAG port. Commands are shifted
+ * into a user data register (USER1) in MPSSE mode, and the gateware
+ * applies them between frames, so sending them does not take the
+ * synchronous FIFO on interface A out of its transmit states.
+ *
+ * Each command is the command byte of the interface A protocol and up
+ * to 4 payload bytes, packed LSB first into @val.
+ */
+struct Jtag;
+
+/** Open interface B of the radar with serial number @serial, or the
+ * first radar found if @serial is NULL or empty.
+ *
+ * Returns NULL on failure.
+ */
+struct Jtag *jtag_new(const char *serial);
+
+void jtag_free(struct Jtag *jtag);
+
+/** Shift the @n commands @cmds with payloads @vals, in order.
+ *
+ * The gateware discards commands while its command FIFO is full, and
+ * reports each one it discards. Those are sent again until the FIFO
+ * has room for them.
+ *
+ * Returns 1 once every command has been taken and 0 on failure.
+ */
+int jtag_write(struct Jtag *jtag, const uint8_t *cmds, const uint32_t *vals, int n);
+
+#endif
@@ -0,0 +1,78 @@
+#include "noise.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NOISE_BUCKETS (NOISE_SUB * NOISE_OCTAVES)
+
+/**
+ * Histogram bucket of magnitude @val.
+ */
+static inline int bucket(double val);
+
+/**
+ * Interpolate the @pct percentile of the @len values counted in @hist.
+ */
+static double percentile(const uint32_t *hist, int len, double pct);
+
+double noise_floor(const double *spec, int len, double pct)
+{
+	uint32_t hist[NOISE_BUCKETS];
+	if (len <= 0) {
+		return 0;
+	}
+	memset(hist, 0, sizeof(hist));
+	for (int i = 0; i < len; ++i) {
+		++hist[bucket(spec[i])];
+	}
+	return percentile(hist, len, pct);
+}
+
+double noise_floor_int(const int *spec, int len, double pct)
+{
+	uint32_t hist[NOISE_BUCKETS];
+	if (len <= 0) {
+		return 0;
+	}
+	memset(hist, 0, sizeof(hist));
+	for (int i = 0; i < len; ++i) {
+		++hist[bucket(spec[i])];
+	}
+	return percentile(hist, len, pct);
+}
+
+int bucket(double val)
+{
+	if (!(val > 0)) {
+		return 0;
+	}
+	int exp;
+	/* val = mant * 2^exp with mant in [0.5, 1) */
+	double mant = frexp(val, &exp);
+	int idx = (exp - 1 - NOISE_MIN_EXP) * NOISE_SUB + (int)((2 * mant - 1) * NOISE_SUB);
+	if (idx < 0) {
+		return 0;
+	}
+	return idx < NOISE_BUCKETS ? idx : NOISE_BUCKETS - 1;
+}
+
+double percentile(const uint32_t *hist, int len, double pct)
+{
+	double rank = pct / 100 * len;
+	uint32_t below = 0;
+	int idx = 0;
+	while (idx < NOISE_BUCKETS - 1 && below + hist[idx] < rank) {
+		below += hist[idx++];
+	}
+
+	double frac = hist[idx] ? (rank - below) / hist[idx] : 0;
+	if (frac < 0) {
+		frac = 0;
+	} else if (frac > 1) {
+		frac = 1;
+	}
+	double lo = ldexp(1 + (double)(idx % NOISE_SUB) / NOISE_SUB,
+			  idx / NOISE_SUB + NOISE_MIN_EXP);
+	double width = ldexp(1.0 / NOISE_SUB, idx / NOISE_SUB + NOISE_MIN_EXP);
+	return lo + frac * width;
+}
@@ -0,0 +1,27 @@
+#ifndef __NOISE_H__
+#define __NOISE_H__
+
+/* Histogram buckets per octave of magnitude, about 0.4dB each. */
+#define NOISE_SUB 16
+/* The histogram covers magnitudes from 2^NOISE_MIN_EXP upward. */
+#define NOISE_MIN_EXP -32
+#define NOISE_OCTAVES 72
+/* Percentile of the bin magnitudes taken as the noise floor. */
+#define NOISE_FLOOR_PCT 50
+
+/** Noise floor of the magnitude spectrum @spec of @len bins.
+ *
+ * The floor is the @pct percentile of the bin magnitudes. Targets
+ * occupy few bins, so the median is barely moved by them. Rather than
+ * sorting, the bins are counted into a histogram with NOISE_SUB
+ * log-spaced buckets per octave, and the value is interpolated within
+ * the bucket holding the requested rank. This costs one pass over the
+ * spectrum and one over the histogram. Magnitudes outside the
+ * histogram are counted in its end buckets.
+ *
+ * Returns 0 if @len is 0.
+ */
+double noise_floor(const double *spec, int len, double pct);
+double noise_floor_int(const int *spec, int len, double pct);
+
+#endif
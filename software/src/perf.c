@@ -0,0 +1,128 @@
+#include "perf.h"
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define PERF_NUM_EVENTS 4
+
+static const uint64_t events[PERF_NUM_EVENTS] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_COUNT_HW_CACHE_MISSES,
+	PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+struct Perf {
+	/* group leader first */
+	int fd[PERF_NUM_EVENTS];
+	int nstages;
+	struct PerfCounts *stages;
+	uint64_t last[PERF_NUM_EVENTS];
+};
+
+/**
+ * Read the group's counters into @vals, scaled for multiplexing.
+ */
+static void read_counters(struct Perf *perf, uint64_t *vals);
+
+struct Perf *perf_new(int nstages)
+{
+	struct Perf *perf = calloc(1, sizeof(struct Perf));
+	if (perf == NULL) {
+		return NULL;
+	}
+	for (int i = 0; i < PERF_NUM_EVENTS; ++i) {
+		perf->fd[i] = -1;
+	}
+	perf->nstages = nstages;
+	perf->stages = calloc(nstages, sizeof(struct PerfCounts));
+	if (perf->stages == NULL) {
+		perf_free(perf);
+		return NULL;
+	}
+
+	for (int i = 0; i < PERF_NUM_EVENTS; ++i) {
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(struct perf_event_attr));
+		attr.size = sizeof(struct perf_event_attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = events[i];
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+				   PERF_FORMAT_TOTAL_TIME_RUNNING;
+		/* the whole group is enabled at once through the leader */
+		attr.disabled = i == 0;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		perf->fd[i] = syscall(SYS_perf_event_open, &attr, 0, -1, i ? perf->fd[0] : -1, 0);
+		if (perf->fd[i] < 0) {
+			fprintf(stderr, "perf_event_open failed: %s\n", strerror(errno));
+			perf_free(perf);
+			return NULL;
+		}
+	}
+
+	ioctl(perf->fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(perf->fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	return perf;
+}
+
+void perf_free(struct Perf *perf)
+{
+	if (perf == NULL) {
+		return;
+	}
+	for (int i = PERF_NUM_EVENTS - 1; i >= 0; --i) {
+		if (perf->fd[i] >= 0) {
+			close(perf->fd[i]);
+		}
+	}
+	free(perf->stages);
+	free(perf);
+}
+
+void perf_begin(struct Perf *perf) { read_counters(perf, perf->last); }
+
+void perf_end(struct Perf *perf, int stage, uint64_t bytes)
+{
+	uint64_t cur[PERF_NUM_EVENTS];
+	uint64_t delta[PERF_NUM_EVENTS];
+	read_counters(perf, cur);
+	for (int i = 0; i < PERF_NUM_EVENTS; ++i) {
+		/* a change in the multiplexing scale can make a scaled
+		 * count step backward */
+		delta[i] = cur[i] > perf->last[i] ? cur[i] - perf->last[i] : 0;
+	}
+
+	struct PerfCounts *counts = &perf->stages[stage];
+	counts->bytes += bytes;
+	counts->cycles += delta[0];
+	counts->instructions += delta[1];
+	counts->cache_misses += delta[2];
+	counts->branch_misses += delta[3];
+	memcpy(perf->last, cur, sizeof(cur));
+}
+
+void perf_read(struct Perf *perf, int stage, struct PerfCounts *counts)
+{
+	*counts = perf->stages[stage];
+}
+
+void read_counters(struct Perf *perf, uint64_t *vals)
+{
+	/* nr, time enabled, time running, then one value per event */
+	uint64_t buf[3 + PERF_NUM_EVENTS];
+	if (read(perf->fd[0], buf, sizeof(buf)) != sizeof(buf) || buf[2] == 0) {
+		memcpy(vals, perf->last, PERF_NUM_EVENTS * sizeof(uint64_t));
+		return;
+	}
+
+	double scale = (double)buf[1] / buf[2];
+	for (int i = 0; i < PERF_NUM_EVENTS; ++i) {
+		vals[i] = (uint64_t)(buf[3 + i] * scale);
+	}
+}
@@ -0,0 +1,50 @@
+#ifndef __PERF_H__
+#define __PERF_H__
+
+#include <stdint.h>
+
+/** Hardware counter totals for one stage.
+ *
+ * Counts are scaled up when the kernel had to multiplex the counters.
+ */
+struct PerfCounts {
+	/* Bytes processed, as reported to perf_end. */
+	uint64_t bytes;
+	uint64_t cycles;
+	uint64_t instructions;
+	uint64_t cache_misses;
+	uint64_t branch_misses;
+};
+
+/** Per-stage hardware performance counters.
+ *
+ * The counters are opened with perf_event_open for the calling thread
+ * only and count user-space events, so a Perf must only be used from
+ * the thread that created it.
+ */
+struct Perf;
+
+/** Open counters for @nstages stages.
+ *
+ * Returns NULL if the counters are unavailable, e.g. because of
+ * perf_event_paranoid or a virtual machine without a PMU.
+ */
+struct Perf *perf_new(int nstages);
+
+void perf_free(struct Perf *perf);
+
+/** Start attributing counts.
+ */
+void perf_begin(struct Perf *perf);
+
+/** Attribute the counts since the last perf_begin or perf_end to
+ * @stage, which processed @bytes bytes. Consecutive stages therefore
+ * need only one perf_begin.
+ */
+void perf_end(struct Perf *perf, int stage, uint64_t bytes);
+
+/** Copy the totals for @stage into @counts.
+ */
+void perf_read(struct Perf *perf, int stage, struct PerfCounts *counts);
+
+#endif
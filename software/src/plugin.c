@@ -0,0 +1,130 @@
+#include "plugin.h"
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRUE 1
+#define FALSE 0
+
+struct Plugin {
+	void *handle;
+	const struct FmcwPlugin *vtable;
+	void *state;
+	struct FmcwFormat in;
+	struct FmcwFormat out;
+	/* output sweep, NULL for in-place plugins */
+	void *buf;
+};
+
+static int sample_size(int type);
+static int format_equal(const struct FmcwFormat *a, const struct FmcwFormat *b);
+
+struct Plugin *plugin_load(const char *path, const char *args, const struct FmcwFormat *in,
+			   int resize)
+{
+	struct Plugin *plugin = calloc(1, sizeof(struct Plugin));
+	if (plugin == NULL) {
+		return NULL;
+	}
+	plugin->in = *in;
+	plugin->out = *in;
+
+	/* RTLD_LOCAL so that plugins cannot interpose on one another */
+	if ((plugin->handle = dlopen(path, RTLD_NOW | RTLD_LOCAL)) == NULL) {
+		fprintf(stderr, "Failed to load plugin: %s\n", dlerror());
+		free(plugin);
+		return NULL;
+	}
+	fmcw_plugin_entry_fn entry;
+	*(void **)&entry = dlsym(plugin->handle, FMCW_PLUGIN_ENTRY);
+	if (entry == NULL || (plugin->vtable = entry()) == NULL) {
+		fprintf(stderr, "%s does not export %s.\n", path, FMCW_PLUGIN_ENTRY);
+		plugin_free(plugin);
+		return NULL;
+	}
+	if (plugin->vtable->abi_version != FMCW_PLUGIN_ABI_VERSION) {
+		fprintf(stderr, "%s was built for plugin ABI %u, expected %u.\n", path,
+			plugin->vtable->abi_version, FMCW_PLUGIN_ABI_VERSION);
+		plugin->vtable = NULL;
+		plugin_free(plugin);
+		return NULL;
+	}
+	if (plugin->vtable->process == NULL ||
+	    (plugin->vtable->init && plugin->vtable->init(&plugin->state, args ? args : "",
+							  &plugin->in, &plugin->out) != 0)) {
+		fprintf(stderr, "Failed to initialize plugin %s.\n", path);
+		plugin->state = NULL;
+		plugin->vtable = NULL;
+		plugin_free(plugin);
+		return NULL;
+	}
+
+	if (!format_equal(&plugin->in, &plugin->out)) {
+		if (!resize || plugin->out.len <= 0 || sample_size(plugin->out.type) == 0) {
+			fprintf(stderr, "Plugin %s cannot change the sweep format here.\n",
+				plugin_name(plugin));
+			plugin_free(plugin);
+			return NULL;
+		}
+		plugin->buf = malloc((size_t)plugin->out.len * sample_size(plugin->out.type));
+		if (plugin->buf == NULL) {
+			plugin_free(plugin);
+			return NULL;
+		}
+	}
+	return plugin;
+}
+
+void plugin_free(struct Plugin *plugin)
+{
+	if (plugin == NULL) {
+		return;
+	}
+	if (plugin->vtable && plugin->vtable->finish) {
+		plugin->vtable->finish(plugin->state);
+	}
+	if (plugin->handle) {
+		dlclose(plugin->handle);
+	}
+	free(plugin->buf);
+	free(plugin);
+}
+
+const char *plugin_name(const struct Plugin *plugin)
+{
+	if (plugin->vtable && plugin->vtable->name) {
+		return plugin->vtable->name;
+	}
+	return "(unnamed)";
+}
+
+const struct FmcwFormat *plugin_format(const struct Plugin *plugin) { return &plugin->out; }
+
+int plugin_process(struct Plugin *plugin, void *buf, void **out, struct SweepMeta *meta)
+{
+	void *dst = plugin->buf ? plugin->buf : buf;
+	int ret = plugin->vtable->process(plugin->state, buf, dst, meta);
+	if (ret == FMCW_PLUGIN_OK && out) {
+		*out = dst;
+	}
+	return ret;
+}
+
+int sample_size(int type)
+{
+	switch (type) {
+	case FMCW_SAMPLE_INT32:
+		return sizeof(int32_t);
+	case FMCW_SAMPLE_DOUBLE:
+		return sizeof(double);
+	default:
+		return 0;
+	}
+}
+
+int format_equal(const struct FmcwFormat *a, const struct FmcwFormat *b)
+{
+	return a->len == b->len && a->type == b->type && a->domain == b->domain &&
+	       a->spacing == b->spacing && a->sweep_rate == b->sweep_rate;
+}
@@ -0,0 +1,34 @@
+#ifndef __PLUGIN_H__
+#define __PLUGIN_H__
+
+#include "fmcw_plugin.h"
+#include "sweep.h"
+
+/** A loaded processing stage plugin (see fmcw_plugin.h).
+ */
+struct Plugin;
+
+/** Load the plugin at @path and initialize it for sweeps of format
+ * @in. Unless @resize is TRUE, a plugin that changes the format is
+ * rejected.
+ *
+ * Returns NULL and prints the reason on failure.
+ */
+struct Plugin *plugin_load(const char *path, const char *args, const struct FmcwFormat *in,
+			   int resize);
+
+void plugin_free(struct Plugin *plugin);
+
+const char *plugin_name(const struct Plugin *plugin);
+
+/** Format of the sweeps the plugin produces.
+ */
+const struct FmcwFormat *plugin_format(const struct Plugin *plugin);
+
+/** Run the plugin on @buf. On FMCW_PLUGIN_OK, @out (which may be NULL
+ * for in-place plugins) is set to the processed sweep: @buf itself,
+ * or a buffer owned by the plugin that is valid until the next call.
+ */
+int plugin_process(struct Plugin *plugin, void *buf, void **out, struct SweepMeta *meta);
+
+#endif
@@ -0,0 +1,226 @@
+#include "pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRUE 1
+#define FALSE 0
+
+#define ARENA_ALIGN 64
+
+/* Precedes each block, keeping the caller's memory 16-byte aligned. */
+struct Header {
+	_Alignas(16) union {
+		struct {
+			uint8_t cls;
+			uint8_t arena;
+			uint8_t subsys;
+			size_t size;
+		};
+		/* the next free block of the class while on a free list */
+		struct Header *next;
+	};
+};
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t *_arena = NULL;
+static size_t _budget = 0;
+static size_t _carved = 0;
+/* blocks of the arena in use */
+static uint64_t _arena_blocks = 0;
+static struct Header *_free_list[POOL_NUM_CLASSES];
+static struct PoolStats _stats[POOL_NUM_SUBSYSTEMS];
+
+/**
+ * Smallest class whose blocks hold @size bytes and a header, or -1.
+ */
+static int size_class(size_t size);
+static size_t class_size(int cls);
+/**
+ * A block of class @cls, from its free list or fresh. Call with the
+ * mutex held.
+ */
+static struct Header *take_block(int cls, int *fresh);
+
+int pool_set_budget(size_t budget)
+{
+	int ret = TRUE;
+	budget = budget / ARENA_ALIGN * ARENA_ALIGN;
+	pthread_mutex_lock(&pool_mutex);
+	if (budget == _budget) {
+		goto done;
+	}
+	if (_arena_blocks) {
+		ret = FALSE;
+		goto done;
+	}
+	uint8_t *arena = NULL;
+	if (budget) {
+		if ((arena = aligned_alloc(ARENA_ALIGN, budget)) == NULL) {
+			ret = FALSE;
+			goto done;
+		}
+		/* fault the pages in now rather than on the hot path */
+		memset(arena, 0, budget);
+	}
+	/* free blocks of the old arena go with it, and those from malloc
+	 * are returned so that only the new arena is held */
+	for (int i = 0; i < POOL_NUM_CLASSES; ++i) {
+		while (_free_list[i]) {
+			struct Header *hdr = _free_list[i];
+			_free_list[i] = hdr->next;
+			if ((uint8_t *)hdr < _arena || (uint8_t *)hdr >= _arena + _budget) {
+				free(hdr);
+			}
+		}
+	}
+	free(_arena);
+	_arena = arena;
+	_budget = budget;
+	_carved = 0;
+done:
+	pthread_mutex_unlock(&pool_mutex);
+	return ret;
+}
+
+size_t pool_budget()
+{
+	pthread_mutex_lock(&pool_mutex);
+	size_t budget = _budget;
+	pthread_mutex_unlock(&pool_mutex);
+	return budget;
+}
+
+size_t pool_carved()
+{
+	pthread_mutex_lock(&pool_mutex);
+	size_t carved = _carved;
+	pthread_mutex_unlock(&pool_mutex);
+	return carved;
+}
+
+void *pool_alloc(int subsys, size_t size)
+{
+	int cls = size_class(size);
+	int fresh = FALSE;
+	pthread_mutex_lock(&pool_mutex);
+	struct PoolStats *stats = &_stats[subsys];
+	++stats->allocs;
+	struct Header *hdr = cls < 0 ? NULL : take_block(cls, &fresh);
+	if (hdr == NULL) {
+		++stats->failures;
+		pthread_mutex_unlock(&pool_mutex);
+		return NULL;
+	}
+	if (fresh) {
+		++stats->fresh;
+	}
+	hdr->subsys = subsys;
+	hdr->size = size;
+	stats->used += size;
+	if (stats->used > stats->peak) {
+		stats->peak = stats->used;
+	}
+	pthread_mutex_unlock(&pool_mutex);
+	return hdr + 1;
+}
+
+void *pool_calloc(int subsys, size_t n, size_t size)
+{
+	if (size && n > SIZE_MAX / size) {
+		return NULL;
+	}
+	void *ptr = pool_alloc(subsys, n * size);
+	if (ptr) {
+		memset(ptr, 0, n * size);
+	}
+	return ptr;
+}
+
+void *pool_realloc(int subsys, void *ptr, size_t size)
+{
+	if (ptr == NULL) {
+		return pool_alloc(subsys, size);
+	}
+	struct Header *hdr = (struct Header *)ptr - 1;
+	if (hdr->subsys == subsys && size + sizeof(struct Header) <= class_size(hdr->cls)) {
+		pthread_mutex_lock(&pool_mutex);
+		_stats[subsys].used += size - hdr->size;
+		if (_stats[subsys].used > _stats[subsys].peak) {
+			_stats[subsys].peak = _stats[subsys].used;
+		}
+		hdr->size = size;
+		pthread_mutex_unlock(&pool_mutex);
+		return ptr;
+	}
+	void *newptr = pool_alloc(subsys, size);
+	if (newptr == NULL) {
+		return NULL;
+	}
+	memcpy(newptr, ptr, hdr->size < size ? hdr->size : size);
+	pool_free(ptr);
+	return newptr;
+}
+
+void pool_free(void *ptr)
+{
+	if (ptr == NULL) {
+		return;
+	}
+	struct Header *hdr = (struct Header *)ptr - 1;
+	pthread_mutex_lock(&pool_mutex);
+	_stats[hdr->subsys].used -= hdr->size;
+	int cls = hdr->cls;
+	if (hdr->arena) {
+		--_arena_blocks;
+	}
+	hdr->next = _free_list[cls];
+	_free_list[cls] = hdr;
+	pthread_mutex_unlock(&pool_mutex);
+}
+
+void pool_stats(int subsys, struct PoolStats *stats)
+{
+	pthread_mutex_lock(&pool_mutex);
+	*stats = _stats[subsys];
+	pthread_mutex_unlock(&pool_mutex);
+}
+
+int size_class(size_t size)
+{
+	size_t block = POOL_MIN_BLOCK;
+	for (int cls = 0; cls < POOL_NUM_CLASSES; ++cls, block <<= 1) {
+		if (size <= block - sizeof(struct Header)) {
+			return cls;
+		}
+	}
+	return -1;
+}
+
+size_t class_size(int cls) { return (size_t)POOL_MIN_BLOCK << cls; }
+
+struct Header *take_block(int cls, int *fresh)
+{
+	struct Header *hdr = _free_list[cls];
+	if (hdr) {
+		_free_list[cls] = hdr->next;
+	} else if (_arena) {
+		if (class_size(cls) > _budget - _carved) {
+			return NULL;
+		}
+		hdr = (struct Header *)(_arena + _carved);
+		_carved += class_size(cls);
+		*fresh = TRUE;
+	} else {
+		if ((hdr = malloc(class_size(cls))) == NULL) {
+			return NULL;
+		}
+		*fresh = TRUE;
+	}
+	hdr->cls = cls;
+	hdr->arena = _arena && (uint8_t *)hdr >= _arena && (uint8_t *)hdr < _arena + _budget;
+	if (hdr->arena) {
+		++_arena_blocks;
+	}
+	return hdr;
+}
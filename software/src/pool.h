@@ -0,0 +1,98 @@
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Subsystems, accounted separately. */
+/* Sweep buffers and the raw sample ring of the parser. */
+#define POOL_SWEEP 0
+/* Command buffers and pending writes. */
+#define POOL_COMMANDS 1
+/* Workspaces of the processing stages. */
+#define POOL_DSP 2
+/* Log and replay file buffers. */
+#define POOL_LOG 3
+#define POOL_NUM_SUBSYSTEMS 4
+
+/* Smallest block, header included. Blocks are powers of 2 from here. */
+#define POOL_MIN_BLOCK 32
+#define POOL_NUM_CLASSES 40
+
+/** Memory use of one subsystem.
+ */
+struct PoolStats {
+	/* Bytes requested and not yet freed, and their maximum. */
+	size_t used;
+	size_t peak;
+	/* Allocations, and how many of them could not reuse a freed
+	 * block. Once these stop growing, the subsystem no longer
+	 * allocates from the system in steady state. */
+	uint64_t allocs;
+	uint64_t fresh;
+	/* Allocations refused because the budget was exhausted. */
+	uint64_t failures;
+};
+
+/** Global buffer pool.
+ *
+ * Host subsystems draw their buffers from here rather than from malloc,
+ * so their memory is accounted per subsystem and, with a budget,
+ * bounded in total. Blocks are powers of 2 from POOL_MIN_BLOCK bytes,
+ * and freed blocks are kept on a free list per size for the next
+ * allocation of that size. Buffers that are freed and allocated again
+ * every acquisition, command or sweep are therefore recycled rather
+ * than requested from the system.
+ *
+ * Without a budget, fresh blocks come from malloc. With a budget, one
+ * arena of that many bytes is reserved and touched up front, and fresh
+ * blocks are carved from it, so the process never grows past it once
+ * running and an allocation either fits or fails at once. Blocks
+ * freed to one size are not split or merged, so a workload whose sizes
+ * keep changing needs headroom in the budget.
+ *
+ * All functions are thread-safe.
+ */
+
+/** Reserve an arena of @budget bytes, or use malloc if @budget is 0.
+ * Setting the current budget again keeps the arena.
+ *
+ * Returns FALSE if the arena cannot be reserved or if blocks from the
+ * current arena are still in use, in which case the pool is unchanged.
+ */
+int pool_set_budget(size_t budget);
+
+/** Bytes in the arena, or 0 without a budget.
+ */
+size_t pool_budget();
+
+/** Bytes of the arena carved into blocks so far.
+ */
+size_t pool_carved();
+
+/** Allocate @size bytes for @subsys (POOL_*), aligned to 16 bytes.
+ *
+ * Returns NULL on failure.
+ */
+void *pool_alloc(int subsys, size_t size);
+
+/** pool_alloc for @n zeroed elements of @size bytes.
+ */
+void *pool_calloc(int subsys, size_t n, size_t size);
+
+/** Resize @ptr, which may be NULL, to @size bytes for @subsys. The
+ * block is kept if it is large enough.
+ *
+ * Returns NULL on failure, leaving @ptr allocated.
+ */
+void *pool_realloc(int subsys, void *ptr, size_t size);
+
+/** Free @ptr, which may be NULL, to the pool.
+ */
+void pool_free(void *ptr);
+
+/** Copy the accounting of @subsys into @stats.
+ */
+void pool_stats(int subsys, struct PoolStats *stats);
+
+#endif
@@ -0,0 +1,41 @@
+#include "soak.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#define TRUE 1
+#define FALSE 0
+
+int soak_sample(struct SoakSample *sample)
+{
+	memset(sample, 0, sizeof(struct SoakSample));
+
+	/* total program size, then resident, in pages */
+	FILE *statm = fopen("/proc/self/statm", "r");
+	if (statm == NULL) {
+		return FALSE;
+	}
+	unsigned long size, resident;
+	int nread = fscanf(statm, "%lu %lu", &size, &resident);
+	fclose(statm);
+	if (nread != 2) {
+		return FALSE;
+	}
+	sample->rss = (uint64_t)resident * sysconf(_SC_PAGESIZE);
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	struct mallinfo2 info = mallinfo2();
+#elif defined(__GLIBC__)
+	/* the fields of mallinfo wrap at 2 GiB */
+	struct mallinfo info = mallinfo();
+#endif
+#ifdef __GLIBC__
+	sample->heap_used = info.uordblks;
+	sample->heap_free = info.fordblks;
+	sample->mmap_bytes = info.hblkhd;
+#endif
+	return TRUE;
+}
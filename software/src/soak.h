@@ -0,0 +1,25 @@
+#ifndef __SOAK_H__
+#define __SOAK_H__
+
+#include <stdint.h>
+
+/** Process memory at one point in a soak test, in bytes.
+ */
+struct SoakSample {
+	/* Resident set size. */
+	uint64_t rss;
+	/* Heap in use and held free by malloc. */
+	uint64_t heap_used;
+	uint64_t heap_free;
+	/* Allocations served directly by mmap. */
+	uint64_t mmap_bytes;
+};
+
+/** Sample the memory of the calling process into @sample.
+ *
+ * Returns 0 (FALSE) if the resident set size cannot be read. The
+ * allocator fields are 0 when not built against glibc.
+ */
+int soak_sample(struct SoakSample *sample);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef __SWEEP_H__
+#define __SWEEP_H__
+
+#include <stdint.h>
+
+/* Sweep contained an interference burst that was repaired. */
+#define SWEEP_FLAG_INTERFERENCE 0x1
+/* The ADC overflowed at least once during the sweep. */
+#define SWEEP_FLAG_OVERFLOW 0x2
+/* The gateware pulse canceller removed stationary returns. */
+#define SWEEP_FLAG_MTI 0x4
+
+/* Largest overflow count the gateware can report. */
+#define SWEEP_OVERFLOW_MAX 0x3FFF
+/* Trailer bit set when the pulse canceller was applied. */
+#define SWEEP_TRAILER_MTI 0x4000
+
+/** Metadata accompanying each sweep.
+ *
+ * The parser fills in the sequence number and receive time. Later
+ * processing stages may set flags and stage-specific fields.
+ */
+struct SweepMeta {
+	/* Number of sweeps parsed before this one since the start of
+	 * acquisition. */
+	uint64_t seq;
+	/* CLOCK_MONOTONIC time (s) at which the stop flags arrived. */
+	double time;
+	/* SWEEP_FLAG_* bits. */
+	uint32_t flags;
+	/* Number of samples repaired by the interference stage. */
+	int interference;
+	/* Number of ADC samples that overflowed during the sweep, as
+	 * reported in the frame trailer. Saturates at SWEEP_OVERFLOW_MAX. */
+	int overflow;
+	/* Noise floor of the sweep's magnitude spectrum, in the units of
+	 * the spectrum, or 0 if it has not been estimated. */
+	double noise_floor;
+};
+
+#endif
@@ -0,0 +1,301 @@
+#include "tbd.h"
+#include "pool.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TRUE 1
+#define FALSE 0
+
+struct Tbd {
+	int len;
+	int window;
+	double threshold;
+	double budget;
+	int nrates;
+	double max_rate;
+	/* normalized spectra, newest at head - 1 */
+	double *ring;
+	int head;
+	int count;
+	/* score of each bin for each hypothesis, nrates rows of len */
+	double *scores;
+	/* best score of each bin and its hypothesis */
+	double *best;
+	int *best_rate;
+
+	/* hypothesis evaluated first on the next sweep */
+	int start;
+	/* pool state, guarded by mutex */
+	pthread_mutex_t mutex;
+	pthread_cond_t work;
+	pthread_cond_t idle;
+	pthread_t *threads;
+	int nthreads;
+	uint64_t generation;
+	int busy;
+	int quit;
+	/* claimed with atomics while the pool runs */
+	int next;
+	double deadline;
+
+	struct TbdStats stats;
+};
+
+/**
+ * Rate of hypothesis @h in bins per sweep.
+ */
+static double rate(const struct Tbd *tbd, int h);
+/**
+ * Score every bin for the @h-th hypothesis after tbd->start.
+ */
+static void evaluate(struct Tbd *tbd, int h);
+/**
+ * Claim and evaluate hypotheses until all are claimed or the deadline
+ * passes. With @progress set, the first is claimed regardless of the
+ * deadline, so every sweep evaluates at least one hypothesis.
+ */
+static void drain(struct Tbd *tbd, int progress);
+static void *worker(void *arg);
+static double now(void);
+
+struct Tbd *tbd_new(int len, int window, double max_rate, double threshold, int nthreads,
+		    double budget)
+{
+	if (len <= 0 || window <= 0 || max_rate < 0 || threshold <= 0 || nthreads <= 0 ||
+	    budget < 0) {
+		return NULL;
+	}
+	struct Tbd *tbd = pool_calloc(POOL_DSP, 1, sizeof(struct Tbd));
+	if (tbd == NULL) {
+		return NULL;
+	}
+	tbd->len = len;
+	tbd->window = window;
+	tbd->threshold = threshold;
+	tbd->budget = budget;
+	tbd->max_rate = max_rate;
+	/* adjacent tracks diverge by one bin over the window */
+	tbd->nrates = 2 * (int)ceil(max_rate * (window - 1)) + 1;
+	tbd->ring = pool_calloc(POOL_DSP, (size_t)window * len, sizeof(double));
+	tbd->scores = pool_calloc(POOL_DSP, (size_t)tbd->nrates * len, sizeof(double));
+	tbd->best = pool_calloc(POOL_DSP, len, sizeof(double));
+	tbd->best_rate = pool_calloc(POOL_DSP, len, sizeof(int));
+	tbd->threads = pool_calloc(POOL_DSP, nthreads, sizeof(pthread_t));
+	if (tbd->ring == NULL || tbd->scores == NULL || tbd->best == NULL ||
+	    tbd->best_rate == NULL || tbd->threads == NULL) {
+		pool_free(tbd->ring);
+		pool_free(tbd->scores);
+		pool_free(tbd->best);
+		pool_free(tbd->best_rate);
+		pool_free(tbd->threads);
+		pool_free(tbd);
+		return NULL;
+	}
+
+	pthread_mutex_init(&tbd->mutex, NULL);
+	pthread_cond_init(&tbd->work, NULL);
+	pthread_cond_init(&tbd->idle, NULL);
+	/* the caller is the last thread of the pool */
+	for (int i = 0; i < nthreads - 1; ++i) {
+		if (pthread_create(&tbd->threads[i], NULL, &worker, tbd) != 0) {
+			break;
+		}
+		++tbd->nthreads;
+	}
+	return tbd;
+}
+
+void tbd_free(struct Tbd *tbd)
+{
+	if (tbd == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&tbd->mutex);
+	tbd->quit = TRUE;
+	pthread_cond_broadcast(&tbd->work);
+	pthread_mutex_unlock(&tbd->mutex);
+	for (int i = 0; i < tbd->nthreads; ++i) {
+		pthread_join(tbd->threads[i], NULL);
+	}
+	pthread_cond_destroy(&tbd->work);
+	pthread_cond_destroy(&tbd->idle);
+	pthread_mutex_destroy(&tbd->mutex);
+	pool_free(tbd->ring);
+	pool_free(tbd->scores);
+	pool_free(tbd->best);
+	pool_free(tbd->best_rate);
+	pool_free(tbd->threads);
+	pool_free(tbd);
+}
+
+int tbd_nrates(const struct Tbd *tbd) { return tbd->nrates; }
+
+int tbd_process(struct Tbd *tbd, const double *spec, const struct SweepMeta *meta,
+		struct TbdDetection *dets)
+{
+	int len = tbd->len;
+	double floor = meta && meta->noise_floor > 0 ? meta->noise_floor : 1;
+	double *slot = tbd->ring + (size_t)tbd->head * len;
+	for (int i = 0; i < len; ++i) {
+		slot[i] = spec[i] / floor;
+	}
+	tbd->head = (tbd->head + 1) % tbd->window;
+	if (tbd->count < tbd->window) {
+		++tbd->count;
+	}
+	if (tbd->count < tbd->window) {
+		return 0;
+	}
+
+	double begin = now();
+	tbd->deadline = tbd->budget > 0 ? begin + tbd->budget : INFINITY;
+	__atomic_store_n(&tbd->next, 0, __ATOMIC_RELAXED);
+	pthread_mutex_lock(&tbd->mutex);
+	++tbd->generation;
+	tbd->busy = tbd->nthreads;
+	pthread_cond_broadcast(&tbd->work);
+	pthread_mutex_unlock(&tbd->mutex);
+	drain(tbd, TRUE);
+	pthread_mutex_lock(&tbd->mutex);
+	while (tbd->busy) {
+		pthread_cond_wait(&tbd->idle, &tbd->mutex);
+	}
+	pthread_mutex_unlock(&tbd->mutex);
+
+	/* every claimed hypothesis was evaluated */
+	int claimed = tbd->next < tbd->nrates ? tbd->next : tbd->nrates;
+	tbd->start = (tbd->start + claimed) % tbd->nrates;
+	tbd->stats.evaluated += claimed;
+	if (claimed < tbd->nrates) {
+		tbd->stats.deferred += tbd->nrates - claimed;
+		++tbd->stats.over_budget;
+	}
+
+	for (int i = 0; i < len; ++i) {
+		tbd->best[i] = tbd->scores[i];
+		tbd->best_rate[i] = 0;
+	}
+	for (int h = 1; h < tbd->nrates; ++h) {
+		const double *row = tbd->scores + (size_t)h * len;
+		for (int i = 0; i < len; ++i) {
+			if (row[i] > tbd->best[i]) {
+				tbd->best[i] = row[i];
+				tbd->best_rate[i] = h;
+			}
+		}
+	}
+
+	int ndets = 0;
+	for (int i = 0; i < len; ++i) {
+		double score = tbd->best[i];
+		if (score < tbd->threshold || (i > 0 && tbd->best[i - 1] > score) ||
+		    (i < len - 1 && tbd->best[i + 1] >= score)) {
+			continue;
+		}
+		/* insert in descending order, dropping the weakest */
+		int pos = ndets < TBD_MAX_DETECTIONS ? ndets++ : TBD_MAX_DETECTIONS;
+		while (pos > 0 && dets[pos - 1].score < score) {
+			if (pos < TBD_MAX_DETECTIONS) {
+				dets[pos] = dets[pos - 1];
+			}
+			--pos;
+		}
+		if (pos < TBD_MAX_DETECTIONS) {
+			dets[pos].bin = i;
+			dets[pos].rate = rate(tbd, tbd->best_rate[i]);
+			dets[pos].score = score;
+		}
+	}
+
+	double elapsed = now() - begin;
+	++tbd->stats.sweeps;
+	tbd->stats.mean += (elapsed - tbd->stats.mean) / tbd->stats.sweeps;
+	if (elapsed > tbd->stats.max) {
+		tbd->stats.max = elapsed;
+	}
+	return ndets;
+}
+
+void tbd_stats(const struct Tbd *tbd, struct TbdStats *stats) { *stats = tbd->stats; }
+
+double rate(const struct Tbd *tbd, int h)
+{
+	if (tbd->nrates == 1) {
+		return 0;
+	}
+	return -tbd->max_rate + 2 * tbd->max_rate * h / (tbd->nrates - 1);
+}
+
+void evaluate(struct Tbd *tbd, int h)
+{
+	int len = tbd->len;
+	h = (tbd->start + h) % tbd->nrates;
+	double v = rate(tbd, h);
+	double *out = tbd->scores + (size_t)h * len;
+	memset(out, 0, len * sizeof(double));
+	for (int k = 0; k < tbd->window; ++k) {
+		/* the sweep k before the newest, where the track was off bins
+		 * nearer */
+		int s = (tbd->head - 1 - k + 2 * tbd->window) % tbd->window;
+		const double *in = tbd->ring + (size_t)s * len;
+		long off = lround(v * k);
+		int lo = off > 0 ? off : 0;
+		int hi = off < 0 ? len + off : len;
+		for (int i = lo; i < hi; ++i) {
+			out[i] += in[i - off];
+		}
+	}
+	double scale = 1.0 / tbd->window;
+	for (int i = 0; i < len; ++i) {
+		out[i] *= scale;
+	}
+}
+
+void drain(struct Tbd *tbd, int progress)
+{
+	for (;; progress = FALSE) {
+		if (!progress && now() > tbd->deadline) {
+			return;
+		}
+		int h = __atomic_fetch_add(&tbd->next, 1, __ATOMIC_RELAXED);
+		if (h >= tbd->nrates) {
+			return;
+		}
+		evaluate(tbd, h);
+	}
+}
+
+void *worker(void *arg)
+{
+	struct Tbd *tbd = arg;
+	uint64_t seen = 0;
+
+	pthread_mutex_lock(&tbd->mutex);
+	for (;;) {
+		while (!tbd->quit && tbd->generation == seen) {
+			pthread_cond_wait(&tbd->work, &tbd->mutex);
+		}
+		if (tbd->quit) {
+			break;
+		}
+		seen = tbd->generation;
+		pthread_mutex_unlock(&tbd->mutex);
+		drain(tbd, FALSE);
+		pthread_mutex_lock(&tbd->mutex);
+		if (--tbd->busy == 0) {
+			pthread_cond_signal(&tbd->idle);
+		}
+	}
+	pthread_mutex_unlock(&tbd->mutex);
+	return NULL;
+}
+
+double now(void)
+{
+	struct timespec tspec;
+	clock_gettime(CLOCK_MONOTONIC, &tspec);
+	return tspec.tv_sec + tspec.tv_nsec * 1e-9;
+}
@@ -0,0 +1,89 @@
+#ifndef __TBD_H__
+#define __TBD_H__
+
+#include "sweep.h"
+#include <stdint.h>
+
+/* Detections reported per sweep. The strongest are kept. */
+#define TBD_MAX_DETECTIONS 16
+
+/** A track whose mean level over the window exceeds the threshold.
+ */
+struct TbdDetection {
+	/* Bin of the target in the newest sweep. */
+	int bin;
+	/* Range rate of the track in bins per sweep. */
+	double rate;
+	/* Mean level along the track, relative to the noise floor. */
+	double score;
+};
+
+/** Processing cost over all sweeps.
+ */
+struct TbdStats {
+	/* Sweeps processed once the window was full. */
+	uint64_t sweeps;
+	/* Hypotheses evaluated and deferred to a later sweep because the
+	 * budget ran out. */
+	uint64_t evaluated;
+	uint64_t deferred;
+	/* Sweeps that used up the budget. */
+	uint64_t over_budget;
+	/* Processing time (s) per sweep. */
+	double mean;
+	double max;
+};
+
+/** Track-before-detect.
+ *
+ * Targets too faint to cross a detection threshold in any one sweep
+ * are found by integrating along their track. The last @window
+ * magnitude spectra, normalized by their noise floors, are kept in a
+ * ring. For each range-rate hypothesis v, the score of bin b is the
+ * mean of the normalized levels at b - v * k, k sweeps ago, which is a
+ * Hough transform restricted to straight tracks that end in the newest
+ * sweep. Hypotheses are spaced so that adjacent tracks diverge by one
+ * bin over the window, and a bin is detected when its best hypothesis
+ * exceeds the threshold and its neighbors do not score higher.
+ *
+ * Hypotheses are evaluated in parallel by a pool of threads, of which
+ * the calling thread is one. The work per sweep is bounded by a time
+ * budget: once it is spent, the remaining hypotheses keep their
+ * previous scores and are evaluated first on the next sweep, so a
+ * consumer that is too slow degrades to a lower update rate per
+ * hypothesis rather than falling behind.
+ */
+struct Tbd;
+
+/** Search spectra of @len bins over @window sweeps for tracks moving up
+ * to @max_rate bins per sweep in either direction, and detect those
+ * whose mean level is at least @threshold times the noise floor. Use
+ * @nthreads threads and spend at most @budget seconds per sweep, or
+ * any time if @budget is 0.
+ *
+ * Returns NULL if the arguments are invalid or on failure.
+ */
+struct Tbd *tbd_new(int len, int window, double max_rate, double threshold, int nthreads,
+		    double budget);
+
+void tbd_free(struct Tbd *tbd);
+
+/** Number of range-rate hypotheses.
+ */
+int tbd_nrates(const struct Tbd *tbd);
+
+/** Add the magnitude spectrum @spec, whose noise floor is taken from
+ * @meta if it has been estimated, and search the window.
+ *
+ * Returns the number of detections stored in @dets, which must hold
+ * TBD_MAX_DETECTIONS, strongest first. Returns 0 until the window is
+ * full.
+ */
+int tbd_process(struct Tbd *tbd, const double *spec, const struct SweepMeta *meta,
+		struct TbdDetection *dets);
+
+/** Copy the processing cost into @stats.
+ */
+void tbd_stats(const struct Tbd *tbd, struct TbdStats *stats);
+
+#endif
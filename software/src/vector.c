@@ -1,12 +1,18 @@
 #include "vector.h"
-#include <stdlib.h>
+#include "pool.h"
+#include <string.h>
 
 #define INIT_SIZE 8
 
 struct Vector *vector_new()
 {
-	unsigned char *buf = malloc(INIT_SIZE * sizeof(unsigned char));
-	struct Vector *vec = malloc(sizeof(struct Vector));
+	unsigned char *buf = pool_alloc(POOL_COMMANDS, INIT_SIZE * sizeof(unsigned char));
+	struct Vector *vec = pool_alloc(POOL_COMMANDS, sizeof(struct Vector));
+	if (buf == NULL || vec == NULL) {
+		pool_free(buf);
+		pool_free(vec);
+		return NULL;
+	}
 	vec->buf = buf;
 	vec->size = 0;
 	vec->capacity = INIT_SIZE;
@@ -16,21 +22,26 @@ struct Vector *vector_new()
 
 void vector_free(struct Vector *vec)
 {
-	free(vec->buf);
-	free(vec);
+	if (vec == NULL) {
+		return;
+	}
+	pool_free(vec->buf);
+	pool_free(vec);
 }
 
 size_t vector_push(struct Vector *vec, unsigned char *data, size_t size)
 {
-	while (vec->size + size > vec->capacity) {
-		vector_resize(vec, 2 * vec->capacity);
+	size_t capacity = vec->capacity;
+	while (vec->size + size > capacity) {
+		capacity *= 2;
 	}
-
-	for (size_t i = 0; i < size; ++i) {
-		vec->buf[vec->size] = data[i];
-		++vec->size;
+	if (capacity != vec->capacity && !vector_resize(vec, capacity)) {
+		return 0;
 	}
 
+	memcpy(vec->buf + vec->size, data, size);
+	vec->size += size;
+
 	return size;
 }
 
@@ -42,15 +53,11 @@ size_t vector_resize(struct Vector *vec, size_t newsize)
 		return 0;
 	}
 
-	unsigned char *newbuf = malloc(newsize * sizeof(unsigned char));
+	/* keeps the block when it is already large enough */
+	unsigned char *newbuf = pool_realloc(POOL_COMMANDS, vec->buf, newsize * sizeof(unsigned char));
 	if (newbuf == NULL) {
 		return 0;
 	}
-
-	for (size_t i = 0; i < vec->size; ++i) {
-		newbuf[i] = vec->buf[i];
-	}
-	free(vec->buf);
 	vec->buf = newbuf;
 
 	vec->capacity = newsize;
@@ -60,10 +67,9 @@ size_t vector_resize(struct Vector *vec, size_t newsize)
 
 void vector_reverse(struct Vector *vec)
 {
-	unsigned char *newbuf = malloc(vec->capacity * sizeof(unsigned char));
-	for (size_t i = 0; i < vec->size; ++i) {
-		newbuf[i] = vec->buf[vec->size - i - 1];
+	for (size_t i = 0; i < vec->size / 2; ++i) {
+		unsigned char tmp = vec->buf[i];
+		vec->buf[i] = vec->buf[vec->size - i - 1];
+		vec->buf[vec->size - i - 1] = tmp;
 	}
-	free(vec->buf);
-	vec->buf = newbuf;
 }
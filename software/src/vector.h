@@ -12,6 +12,9 @@ struct Vector {
 	size_t capacity;
 };
 
+/** Returns NULL if the command pool is exhausted.
+ *
+ */
 struct Vector *vector_new();
 
 void vector_free(struct Vector *vec);
@@ -0,0 +1,331 @@
+#include "vibration.h"
+#include "pool.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRUE 1
+#define FALSE 0
+
+struct VibrationBin {
+	int bin;
+	int have_prev;
+	double prev_re;
+	double prev_im;
+	/* unwrapped phase (rad) and the displacement it last gave (m) */
+	double phase;
+	double x_last;
+	/* displacement window, indexed by sweep index modulo nwin */
+	double *win;
+	int count;
+	/* sliding DFT of the window relative to the absolute sweep index,
+	 * interleaved real/imaginary */
+	double *dft;
+	/* DFT of the window being filled, which replaces @dft once full */
+	double *next_dft;
+	/* running sums for the window's least-squares line, with the
+	 * oldest value at index 0 */
+	double sum;
+	double sum_n;
+	double next_sum;
+	double next_sum_n;
+};
+
+struct Vibration {
+	struct VibrationBin *bins;
+	int nbins;
+	int nwin;
+	int nfreq;
+	int detrend;
+	double wavelength;
+	double sweep_rate;
+	/* index of the next window value, counted from the last restart */
+	uint64_t t;
+	/* sequence number expected next */
+	uint64_t next_seq;
+	int have_seq;
+	/* e^{j2pi m/nwin} for m=0..nwin-1, interleaved */
+	double *twiddle;
+	/* DFT of the ramp n=0..nwin-1, interleaved */
+	double *ramp;
+	/* sum of n and n^2 over the window */
+	double ramp_sum;
+	double ramp_sum2;
+};
+
+/**
+ * Append the displacement @x to the window of @vbin at the current
+ * index.
+ */
+static void insert(struct Vibration *vib, struct VibrationBin *vbin, double x);
+/**
+ * Advance to the next index, replacing the sliding DFTs and line sums
+ * by the freshly accumulated ones when a window completes.
+ */
+static void advance(struct Vibration *vib);
+/**
+ * Forget the displacement history of every bin.
+ */
+static void restart(struct Vibration *vib);
+
+struct Vibration *vibration_new(const int *bins, int nbins, int nwin, double wavelength,
+				double sweep_rate, int detrend)
+{
+	if (nbins <= 0 || nwin < 4) {
+		return NULL;
+	}
+
+	struct Vibration *vib = pool_calloc(POOL_DSP, 1, sizeof(struct Vibration));
+	if (vib == NULL) {
+		return NULL;
+	}
+	vib->nbins = nbins;
+	vib->nwin = nwin;
+	vib->nfreq = nwin / 2 + 1;
+	vib->detrend = detrend;
+	vib->wavelength = wavelength;
+	vib->sweep_rate = sweep_rate;
+	vib->twiddle = pool_alloc(POOL_DSP, 2 * nwin * sizeof(double));
+	vib->ramp = pool_alloc(POOL_DSP, 2 * vib->nfreq * sizeof(double));
+	vib->bins = pool_calloc(POOL_DSP, nbins, sizeof(struct VibrationBin));
+	if (vib->twiddle == NULL || vib->ramp == NULL || vib->bins == NULL) {
+		vibration_free(vib);
+		return NULL;
+	}
+
+	for (int m = 0; m < nwin; ++m) {
+		vib->twiddle[2 * m] = cos(2 * M_PI * m / nwin);
+		vib->twiddle[2 * m + 1] = sin(2 * M_PI * m / nwin);
+	}
+	for (int k = 0; k < vib->nfreq; ++k) {
+		double theta = 2 * M_PI * k / nwin;
+		/* sum_n n e^{-j theta n} = -N / (1 - e^{-j theta}) for k != 0 */
+		if (k == 0) {
+			vib->ramp[0] = nwin * (nwin - 1) / 2.0;
+			vib->ramp[1] = 0;
+		} else {
+			double dre = 1 - cos(theta);
+			double dim = sin(theta);
+			double mag2 = dre * dre + dim * dim;
+			vib->ramp[2 * k] = -nwin * dre / mag2;
+			vib->ramp[2 * k + 1] = nwin * dim / mag2;
+		}
+	}
+	vib->ramp_sum = nwin * (nwin - 1) / 2.0;
+	vib->ramp_sum2 = (nwin - 1) * nwin * (2.0 * nwin - 1) / 6.0;
+
+	for (int i = 0; i < nbins; ++i) {
+		struct VibrationBin *vbin = &vib->bins[i];
+		vbin->bin = bins[i];
+		vbin->win = pool_calloc(POOL_DSP, nwin, sizeof(double));
+		vbin->dft = pool_calloc(POOL_DSP, 2 * vib->nfreq, sizeof(double));
+		vbin->next_dft = pool_calloc(POOL_DSP, 2 * vib->nfreq, sizeof(double));
+		if (vbin->win == NULL || vbin->dft == NULL || vbin->next_dft == NULL) {
+			vibration_free(vib);
+			return NULL;
+		}
+	}
+
+	return vib;
+}
+
+void vibration_free(struct Vibration *vib)
+{
+	if (vib == NULL) {
+		return;
+	}
+	if (vib->bins) {
+		for (int i = 0; i < vib->nbins; ++i) {
+			pool_free(vib->bins[i].win);
+			pool_free(vib->bins[i].dft);
+			pool_free(vib->bins[i].next_dft);
+		}
+	}
+	pool_free(vib->bins);
+	pool_free(vib->twiddle);
+	pool_free(vib->ramp);
+	pool_free(vib);
+}
+
+void vibration_push(struct Vibration *vib, const double *spec, int nspec,
+		    const struct SweepMeta *meta)
+{
+	double scale = vib->wavelength / (4 * M_PI);
+
+	/* sweeps missing before this one */
+	uint64_t gap = 0;
+	if (meta) {
+		if (vib->have_seq && meta->seq > vib->next_seq) {
+			gap = meta->seq - vib->next_seq;
+		}
+		vib->next_seq = meta->seq + 1;
+		vib->have_seq = TRUE;
+	}
+	if (gap >= (uint64_t)vib->nwin) {
+		restart(vib);
+		gap = 0;
+	}
+
+	for (uint64_t g = 0; g <= gap; ++g) {
+		for (int i = 0; i < vib->nbins; ++i) {
+			struct VibrationBin *vbin = &vib->bins[i];
+			if (vbin->bin < 0 || vbin->bin >= nspec) {
+				continue;
+			}
+			if (g == 0) {
+				double re = spec[2 * vbin->bin];
+				double im = spec[2 * vbin->bin + 1];
+
+				/* The phase increment is the argument of cur *
+				 * conj(prev), which is already wrapped to (-pi,
+				 * pi]. Across a gap this assumes less than a
+				 * quarter wavelength of motion. */
+				if (vbin->have_prev) {
+					double dre = re * vbin->prev_re + im * vbin->prev_im;
+					double dim = im * vbin->prev_re - re * vbin->prev_im;
+					vbin->phase += atan2(dim, dre);
+				}
+				vbin->prev_re = re;
+				vbin->prev_im = im;
+				if (!vbin->have_prev) {
+					vbin->x_last = scale * vbin->phase;
+					vbin->have_prev = TRUE;
+				}
+			}
+			/* the missing sweeps lie on the line to this one */
+			double x_new = scale * vbin->phase;
+			insert(vib, vbin,
+			       vbin->x_last + (x_new - vbin->x_last) * (g + 1) / (gap + 1));
+			if (g == gap) {
+				vbin->x_last = x_new;
+			}
+		}
+		advance(vib);
+	}
+}
+
+int vibration_peak(struct Vibration *vib, int idx, double *freq, double *amp)
+{
+	struct VibrationBin *vbin = &vib->bins[idx];
+	if (vbin->count < vib->nwin) {
+		return FALSE;
+	}
+
+	double nwin = vib->nwin;
+	double slope = 0;
+	if (vib->detrend == VIBRATION_DETREND_LINEAR) {
+		slope = (nwin * vbin->sum_n - vib->ramp_sum * vbin->sum) /
+			(nwin * vib->ramp_sum2 - vib->ramp_sum * vib->ramp_sum);
+	}
+
+	/* the oldest value has index t - nwin, so rotating by
+	 * e^{j2pi k t/nwin} refers the DFT to the start of the window */
+	int head = (int)(vib->t % vib->nwin);
+	int m = 0;
+	int kstart = vib->detrend == VIBRATION_DETREND_NONE ? 0 : 1;
+	int kmax = kstart;
+	double mag2_max = -1;
+	for (int k = 0; k < vib->nfreq; ++k, m = (m + head) % vib->nwin) {
+		if (k < kstart) {
+			continue;
+		}
+		double tr = vib->twiddle[2 * m];
+		double ti = vib->twiddle[2 * m + 1];
+		double yr = vbin->dft[2 * k];
+		double yi = vbin->dft[2 * k + 1];
+		double re = yr * tr - yi * ti - slope * vib->ramp[2 * k];
+		double im = yr * ti + yi * tr - slope * vib->ramp[2 * k + 1];
+		double mag2 = re * re + im * im;
+		if (mag2 > mag2_max) {
+			mag2_max = mag2;
+			kmax = k;
+		}
+	}
+
+	*freq = kmax * vib->sweep_rate / nwin;
+	/* a sinusoid of amplitude A at bin k has |X_k| = A N / 2 */
+	*amp = (kmax == 0 ? 1 : 2) * sqrt(mag2_max) / nwin;
+	return TRUE;
+}
+
+double vibration_displacement(struct Vibration *vib, int idx)
+{
+	return vib->wavelength / (4 * M_PI) * vib->bins[idx].phase;
+}
+
+void insert(struct Vibration *vib, struct VibrationBin *vbin, double x)
+{
+	int nwin = vib->nwin;
+	int slot = (int)(vib->t % nwin);
+	double x_old = vbin->win[slot];
+	double diff = x - x_old;
+	vbin->win[slot] = x;
+	if (vbin->count < nwin) {
+		++vbin->count;
+	}
+
+	/* shifting the window re-indexes every value down by one */
+	vbin->sum_n += x_old - vbin->sum + (nwin - 1) * x;
+	vbin->sum += diff;
+	/* the window being filled started at slot 0 */
+	vbin->next_sum += x;
+	vbin->next_sum_n += slot * x;
+
+	/* both DFTs gain e^{-j2pi k t/nwin} times the new value, and the
+	 * sliding one loses the value it replaces, which had the same
+	 * twiddle */
+	double *dft = vbin->dft;
+	double *next_dft = vbin->next_dft;
+	const double *twiddle = vib->twiddle;
+	int m = 0;
+	for (int k = 0; k < vib->nfreq; ++k) {
+		double tr = twiddle[2 * m];
+		double ti = twiddle[2 * m + 1];
+		dft[2 * k] += diff * tr;
+		dft[2 * k + 1] -= diff * ti;
+		next_dft[2 * k] += x * tr;
+		next_dft[2 * k + 1] -= x * ti;
+		m += slot;
+		if (m >= nwin) {
+			m -= nwin;
+		}
+	}
+}
+
+void advance(struct Vibration *vib)
+{
+	if (++vib->t % vib->nwin) {
+		return;
+	}
+	size_t nbytes = 2 * vib->nfreq * sizeof(double);
+	for (int i = 0; i < vib->nbins; ++i) {
+		struct VibrationBin *vbin = &vib->bins[i];
+		double *dft = vbin->dft;
+		vbin->dft = vbin->next_dft;
+		vbin->next_dft = dft;
+		memset(vbin->next_dft, 0, nbytes);
+		vbin->sum = vbin->next_sum;
+		vbin->sum_n = vbin->next_sum_n;
+		vbin->next_sum = 0;
+		vbin->next_sum_n = 0;
+	}
+}
+
+void restart(struct Vibration *vib)
+{
+	size_t nbytes = 2 * vib->nfreq * sizeof(double);
+	vib->t = 0;
+	for (int i = 0; i < vib->nbins; ++i) {
+		struct VibrationBin *vbin = &vib->bins[i];
+		memset(vbin->win, 0, vib->nwin * sizeof(double));
+		memset(vbin->dft, 0, nbytes);
+		memset(vbin->next_dft, 0, nbytes);
+		vbin->count = 0;
+		vbin->sum = 0;
+		vbin->sum_n = 0;
+		vbin->next_sum = 0;
+		vbin->next_sum_n = 0;
+		/* the phase cannot be unwrapped across the gap */
+		vbin->have_prev = FALSE;
+	}
+}
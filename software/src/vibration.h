@@ -0,0 +1,66 @@
+#ifndef __VIBRATION_H__
+#define __VIBRATION_H__
+
+#include "sweep.h"
+
+#define VIBRATION_DETREND_NONE 0
+#define VIBRATION_DETREND_DC 1
+#define VIBRATION_DETREND_LINEAR 2
+
+/** Sweep-to-sweep phase tracker for a set of range bins.
+ *
+ * The phase of each selected bin is unwrapped across sweeps and
+ * converted to a displacement. The displacement history is kept in a
+ * window of @nwin sweeps whose spectrum is updated with a sliding
+ * DFT, so each bin costs a fixed amount of work per sweep regardless
+ * of how long it has been tracked.
+ *
+ * The sliding DFT is kept relative to the absolute sweep index rather
+ * than rotated every sweep, so each update is a single multiply-add
+ * per frequency. A second DFT of the window being filled is
+ * accumulated alongside and replaces the sliding one whenever a window
+ * completes, which discards accumulated rounding error without a
+ * recomputation spike.
+ *
+ * Sweeps missing from the sequence numbers, e.g. dropped by the host,
+ * are filled in by linear interpolation so the window stays uniformly
+ * spaced in time. A gap of a full window or more restarts it.
+ */
+struct Vibration;
+
+/** Create a monitor for @nbins range bins.
+ *
+ * @bins are the range bin indices to track. @nwin is the number of
+ * sweeps in the displacement window (its spectrum has nwin/2+1
+ * bins). @wavelength is the carrier wavelength (m) and @sweep_rate
+ * the sweep repetition rate (Hz). @detrend is one of
+ * VIBRATION_DETREND_*.
+ *
+ * Returns NULL on failure.
+ */
+struct Vibration *vibration_new(const int *bins, int nbins, int nwin, double wavelength,
+				double sweep_rate, int detrend);
+
+void vibration_free(struct Vibration *vib);
+
+/** Push the next sweep.
+ *
+ * @spec is the complex range spectrum with interleaved real and
+ * imaginary values and @nspec complex bins. @meta supplies the
+ * sequence number, and may be NULL if no sweeps are ever missing.
+ */
+void vibration_push(struct Vibration *vib, const double *spec, int nspec,
+		    const struct SweepMeta *meta);
+
+/** Dominant vibration frequency (Hz) and amplitude (m) of the @idx-th
+ * tracked bin.
+ *
+ * Returns 0 while the displacement window is not yet full.
+ */
+int vibration_peak(struct Vibration *vib, int idx, double *freq, double *amp);
+
+/** Latest displacement (m) of the @idx-th tracked bin.
+ */
+double vibration_displacement(struct Vibration *vib, int idx);
+
+#endif
@@ -0,0 +1,236 @@
+#include "zone.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TRUE 1
+#define FALSE 0
+#define ZONE_MAX_CALLBACKS 8
+#define NS_TO_S 1e-9
+#define S_TO_US 1e6
+
+struct Zone {
+	int lo;
+	int hi;
+	double on;
+	double off;
+	int active;
+};
+
+struct Zones {
+	struct Zone *zones;
+	int nzones;
+	zone_cb cb[ZONE_MAX_CALLBACKS];
+	void *userdata[ZONE_MAX_CALLBACKS];
+	int ncb;
+	int cfar;
+	int efd;
+	/* guards the queue and latency, which are read by other threads */
+	pthread_mutex_t mutex;
+	struct ZoneEvent queue[ZONE_QUEUE_LEN];
+	int head;
+	int nqueue;
+	struct ZoneLatency lat;
+};
+
+/**
+ * Update zone @idx whose strongest bin is @bin with magnitude @peak.
+ * Returns TRUE if it changed state.
+ */
+static int update_zone(struct Zones *zones, int idx, int bin, double peak,
+		       const struct SweepMeta *meta);
+static void emit(struct Zones *zones, struct ZoneEvent *ev);
+
+struct Zones *zones_new()
+{
+	struct Zones *zones = calloc(1, sizeof(struct Zones));
+	if (zones == NULL) {
+		return NULL;
+	}
+	zones->efd = -1;
+	pthread_mutex_init(&zones->mutex, NULL);
+	return zones;
+}
+
+void zones_free(struct Zones *zones)
+{
+	if (zones == NULL) {
+		return;
+	}
+	if (zones->efd >= 0) {
+		close(zones->efd);
+	}
+	pthread_mutex_destroy(&zones->mutex);
+	free(zones->zones);
+	free(zones);
+}
+
+int zones_add(struct Zones *zones, int lo, int hi, double on, double off)
+{
+	if (lo < 0 || hi < lo || off > on) {
+		return -1;
+	}
+	struct Zone *grown = realloc(zones->zones, (zones->nzones + 1) * sizeof(struct Zone));
+	if (grown == NULL) {
+		return -1;
+	}
+	zones->zones = grown;
+	zones->zones[zones->nzones] = (struct Zone){lo, hi, on, off, FALSE};
+	return zones->nzones++;
+}
+
+void zones_set_cfar(struct Zones *zones, int cfar) { zones->cfar = cfar; }
+
+int zones_add_callback(struct Zones *zones, zone_cb cb, void *userdata)
+{
+	if (zones->ncb == ZONE_MAX_CALLBACKS) {
+		return FALSE;
+	}
+	zones->cb[zones->ncb] = cb;
+	zones->userdata[zones->ncb] = userdata;
+	++zones->ncb;
+	return TRUE;
+}
+
+int zones_eventfd(struct Zones *zones)
+{
+	if (zones->efd < 0) {
+		zones->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	}
+	return zones->efd;
+}
+
+int zones_eval(struct Zones *zones, const double *spec, int len, const struct SweepMeta *meta)
+{
+	int nevents = 0;
+	for (int i = 0; i < zones->nzones; ++i) {
+		struct Zone *zone = &zones->zones[i];
+		int hi = zone->hi < len ? zone->hi : len - 1;
+		int bin = zone->lo;
+		double peak = 0;
+		for (int j = zone->lo; j <= hi; ++j) {
+			if (spec[j] > peak) {
+				peak = spec[j];
+				bin = j;
+			}
+		}
+		nevents += update_zone(zones, i, bin, peak, meta);
+	}
+	return nevents;
+}
+
+int zones_eval_int(struct Zones *zones, const int *spec, int len, const struct SweepMeta *meta)
+{
+	int nevents = 0;
+	for (int i = 0; i < zones->nzones; ++i) {
+		struct Zone *zone = &zones->zones[i];
+		int hi = zone->hi < len ? zone->hi : len - 1;
+		int bin = zone->lo;
+		int peak = 0;
+		for (int j = zone->lo; j <= hi; ++j) {
+			if (spec[j] > peak) {
+				peak = spec[j];
+				bin = j;
+			}
+		}
+		nevents += update_zone(zones, i, bin, peak, meta);
+	}
+	return nevents;
+}
+
+int update_zone(struct Zones *zones, int idx, int bin, double peak, const struct SweepMeta *meta)
+{
+	struct Zone *zone = &zones->zones[idx];
+	double scale = 1;
+	if (zones->cfar) {
+		if (meta == NULL || meta->noise_floor <= 0) {
+			return FALSE;
+		}
+		scale = meta->noise_floor;
+	}
+	if (zone->active ? peak >= zone->off * scale : peak <= zone->on * scale) {
+		return FALSE;
+	}
+	zone->active = !zone->active;
+
+	struct ZoneEvent ev = {
+		.zone = idx,
+		.entered = zone->active,
+		.bin = bin,
+		.peak = peak,
+	};
+	if (meta) {
+		ev.meta = *meta;
+	}
+	emit(zones, &ev);
+	return TRUE;
+}
+
+void emit(struct Zones *zones, struct ZoneEvent *ev)
+{
+	struct timespec tspec;
+	clock_gettime(CLOCK_MONOTONIC, &tspec);
+	ev->latency = tspec.tv_sec + NS_TO_S * tspec.tv_nsec - ev->meta.time;
+
+	for (int i = 0; i < zones->ncb; ++i) {
+		zones->cb[i](ev, zones->userdata[i]);
+	}
+
+	pthread_mutex_lock(&zones->mutex);
+	int tail = (zones->head + zones->nqueue) % ZONE_QUEUE_LEN;
+	zones->queue[tail] = *ev;
+	if (zones->nqueue < ZONE_QUEUE_LEN) {
+		++zones->nqueue;
+	} else {
+		zones->head = (zones->head + 1) % ZONE_QUEUE_LEN;
+	}
+
+	/* sweeps without a receive time, e.g. from a file, have no
+	 * meaningful latency */
+	if (ev->meta.time > 0) {
+		struct ZoneLatency *lat = &zones->lat;
+		++lat->count;
+		lat->mean += (ev->latency - lat->mean) / lat->count;
+		if (ev->latency > lat->max) {
+			lat->max = ev->latency;
+		}
+		int bucket = 0;
+		for (uint64_t us = (uint64_t)(ev->latency * S_TO_US); us > 1; us >>= 1) {
+			++bucket;
+		}
+		++lat->hist[bucket < ZONE_LATENCY_BUCKETS ? bucket : ZONE_LATENCY_BUCKETS - 1];
+	}
+	pthread_mutex_unlock(&zones->mutex);
+
+	/* only once the event is queued, so that a consumer woken by the
+	 * fd always finds it */
+	if (zones->efd >= 0) {
+		uint64_t one = 1;
+		if (write(zones->efd, &one, sizeof(one)) != sizeof(one)) {
+			/* the counter is saturated, so the fd is readable anyway */
+		}
+	}
+}
+
+int zones_pop(struct Zones *zones, struct ZoneEvent *ev)
+{
+	pthread_mutex_lock(&zones->mutex);
+	if (zones->nqueue == 0) {
+		pthread_mutex_unlock(&zones->mutex);
+		return FALSE;
+	}
+	*ev = zones->queue[zones->head];
+	zones->head = (zones->head + 1) % ZONE_QUEUE_LEN;
+	--zones->nqueue;
+	pthread_mutex_unlock(&zones->mutex);
+	return TRUE;
+}
+
+void zones_latency(struct Zones *zones, struct ZoneLatency *lat)
+{
+	pthread_mutex_lock(&zones->mutex);
+	*lat = zones->lat;
+	pthread_mutex_unlock(&zones->mutex);
+}
@@ -0,0 +1,98 @@
+#ifndef __ZONE_H__
+#define __ZONE_H__
+
+#include "sweep.h"
+#include <stdint.h>
+
+/* Pending events kept for zones_pop. Older events are overwritten. */
+#define ZONE_QUEUE_LEN 64
+/* Alert latency histogram buckets, in powers of 2 of microseconds. */
+#define ZONE_LATENCY_BUCKETS 24
+
+/** A zone was entered or left.
+ */
+struct ZoneEvent {
+	/* Index of the zone, in the order zones_add was called. */
+	int zone;
+	/* 1 when the zone was entered, 0 when it was left. */
+	int entered;
+	/* Strongest bin in the zone and its magnitude. */
+	int bin;
+	double peak;
+	/* Metadata of the triggering sweep. */
+	struct SweepMeta meta;
+	/* Time (s) from the sweep's stop flags to the event. */
+	double latency;
+};
+
+/** Latency from stop flags to alert over all events.
+ */
+struct ZoneLatency {
+	uint64_t count;
+	double mean;
+	double max;
+	/* Events with a latency of less than 2^(i+1) us. */
+	uint64_t hist[ZONE_LATENCY_BUCKETS];
+};
+
+/** Range-band detection zones.
+ *
+ * Each zone is a range of spectrum bins. It is entered when any of its
+ * bins exceeds the zone's on threshold and left once all of them fall
+ * below the off threshold. Events are delivered to registered
+ * callbacks on the evaluating thread, signalled on an eventfd and
+ * queued for zones_pop, in that order. Evaluation costs one pass over
+ * the bins of each zone.
+ */
+struct Zones;
+
+typedef void (*zone_cb)(const struct ZoneEvent *ev, void *userdata);
+
+/** Returns NULL on failure.
+ */
+struct Zones *zones_new();
+
+void zones_free(struct Zones *zones);
+
+/** Add a zone covering bins [@lo, @hi]. @off must not exceed @on.
+ * Returns the zone index or -1 on failure.
+ */
+int zones_add(struct Zones *zones, int lo, int hi, double on, double off);
+
+/** With @cfar set, the on and off thresholds of every zone are ratios
+ * to the sweep's noise floor from its metadata rather than absolute
+ * magnitudes, making each zone an order-statistic CFAR detector whose
+ * reference cells are the whole sweep. Sweeps without a noise floor
+ * are then ignored.
+ */
+void zones_set_cfar(struct Zones *zones, int cfar);
+
+/** Call @cb for each event. Callbacks run on the evaluating thread
+ * (the producer thread for zones given to fmcw_set_zones) and must
+ * return quickly. Returns 0 on failure.
+ */
+int zones_add_callback(struct Zones *zones, zone_cb cb, void *userdata);
+
+/** An eventfd that becomes readable when events are queued. Reading
+ * it clears it. Returns -1 on failure.
+ */
+int zones_eventfd(struct Zones *zones);
+
+/** Evaluate the magnitude spectrum @spec of @len bins. @meta is the
+ * sweep's metadata, whose time is used to measure latency. Returns the
+ * number of events.
+ */
+int zones_eval(struct Zones *zones, const double *spec, int len, const struct SweepMeta *meta);
+int zones_eval_int(struct Zones *zones, const int *spec, int len, const struct SweepMeta *meta);
+
+/** Remove the oldest queued event into @ev. Returns 0 if there is
+ * none. Safe to call from any thread.
+ */
+int zones_pop(struct Zones *zones, struct ZoneEvent *ev);
+
+/** Copy the latency statistics into @lat. Safe to call from any
+ * thread.
+ */
+void zones_latency(struct Zones *zones, struct ZoneLatency *lat);
+
+#endif
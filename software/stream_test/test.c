@@ -3,40 +3,99 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/utsname.h>
 #include <time.h>
 #include <unistd.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
-/* Test write streaming from FPGA to host PC.
+/* Benchmark write streaming from FPGA to host PC.
  *
  * The FPGA sends an 8-bit counter that increments on each FTDI 60MHz
  * clock period. The first transmission value is 1, which should be
  * received by the host. The host PC checks for any lost bytes and
- * measures the transmission speed. This check does not try to be
- * smart about error-detection. If a bit is flipped, for instance it
- * will incorrectly state that all bytes between the last transmitted
- * value and this one were dropped. Similarly, since the subsequent
- * value will not be 1 greater than the error value, it will state
- * that all those bytes were dropped as well. It will not know if more
- * than 1 full packet was dropped.
+ * measures the transmission speed, the time between libftdi callbacks
+ * and the CPU time spent per MB received. An optional busy-wait in
+ * each callback simulates the processing load of a real consumer.
+ * Results are written as JSON so that runs on different machines and
+ * with different libftdi settings can be compared.
+ *
+ * This check does not try to be smart about error-detection. If a bit
+ * is flipped, for instance it will incorrectly state that all bytes
+ * between the last transmitted value and this one were dropped.
+ * Similarly, since the subsequent value will not be 1 greater than
+ * the error value, it will state that all those bytes were dropped as
+ * well. It will not know if more than 1 full packet was dropped.
  */
 
 #define PACKETS_PER_TRANSFER 8
 #define TRANSFERS_PER_CALLBACK 256
 #define CHUNKSIZE 16384
-/* Capture data for 60s unless user provides a value. */
+#define LATENCY 2
+/* Capture data for 10s unless user provides a value. */
 #define CAPTURE_DEFAULT 10
-/* Disable logging runtime statistics for much higher
- * throughputs. Final statistics will still be presented. */
-#define DISABLE_RUNTIME_STATS 0
+/* Drops no further apart than this many bytes (one USB 2.0 bulk
+ * packet) belong to the same burst. */
+#define BURST_GAP 512
+/* The latency histogram has HIST_SUB buckets per power of 2 of
+ * nanoseconds, which bounds the percentile error to 1/HIST_SUB. */
+#define HIST_SUB_BITS 3
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_OCTAVES 40
+#define HIST_BUCKETS (HIST_OCTAVES * HIST_SUB)
+/* Dropped bytes per burst, in powers of 2. */
+#define BURST_BUCKETS 24
+
+#if defined(__AVX2__)
+#define SIMD_NAME "avx2"
+#define SIMD_WIDTH 32
+#elif defined(__SSE2__)
+#define SIMD_NAME "sse2"
+#define SIMD_WIDTH 16
+#else
+#define SIMD_NAME "scalar"
+#define SIMD_WIDTH 1
+#endif
 
-static u_long rx_bytes;
-static u_long err_bytes;
+struct Settings {
+	double capture_time;
+	int packets_per_transfer;
+	int transfers_per_callback;
+	int chunksize;
+	int latency;
+	/* Consumer busy time (ns) per KiB received. */
+	double load_ns_per_kib;
+};
+
+static struct Settings settings;
+static uint64_t rx_bytes;
+static uint64_t err_bytes;
+static uint64_t drop_events;
+static uint64_t callbacks;
 static uint8_t last;
-/* Amount of time to test capture (in s). */
-static double capture_time;
 static struct timespec tp_start;
 static struct timespec tp_stop;
 static int capture_done;
+/* Inter-callback latency. */
+static uint64_t lat_hist[HIST_BUCKETS];
+static uint64_t lat_max;
+static uint64_t lat_sum;
+static struct timespec tp_last_cb;
+/* Drop bursts. */
+static uint64_t bursts;
+static uint64_t burst_bytes;
+static uint64_t burst_max;
+static uint64_t burst_hist[BURST_BUCKETS];
+static uint64_t last_drop_pos;
+static int in_burst;
+
+static uint64_t ts_ns(const struct timespec *tp)
+{
+	return (uint64_t)tp->tv_sec * 1000000000ull + (uint64_t)tp->tv_nsec;
+}
 
 /* Elapsed time in seconds. */
 static double elapsed_time()
@@ -55,29 +114,171 @@ static uint8_t missing(uint8_t curr, uint8_t last)
 	return curr - 1 + (UINT8_MAX - last);
 }
 
+static int log2_floor(uint64_t val)
+{
+	int bits = 0;
+	while (val >>= 1) {
+		++bits;
+	}
+	return bits;
+}
+
+/* Histogram bucket for @ns. Values below HIST_SUB get a bucket each,
+ * above that each octave is split into HIST_SUB linear buckets. */
+static int hist_bucket(uint64_t ns)
+{
+	if (ns < HIST_SUB) {
+		return (int)ns;
+	}
+	int octave = log2_floor(ns) - HIST_SUB_BITS + 1;
+	int sub = (int)(ns >> (octave - 1)) & (HIST_SUB - 1);
+	int bucket = octave * HIST_SUB + sub;
+	return bucket < HIST_BUCKETS ? bucket : HIST_BUCKETS - 1;
+}
+
+/* Upper bound (ns) of the values in @bucket. */
+static uint64_t hist_value(int bucket)
+{
+	if (bucket < HIST_SUB) {
+		return (uint64_t)bucket;
+	}
+	int octave = bucket / HIST_SUB;
+	int sub = bucket % HIST_SUB;
+	return ((uint64_t)(HIST_SUB + sub + 1) << (octave - 1)) - 1;
+}
+
+static uint64_t hist_percentile(double pct)
+{
+	uint64_t total = 0;
+	for (int i = 0; i < HIST_BUCKETS; ++i) {
+		total += lat_hist[i];
+	}
+	if (total == 0) {
+		return 0;
+	}
+	uint64_t rank = (uint64_t)(pct / 100 * (total - 1)) + 1;
+	uint64_t seen = 0;
+	for (int i = 0; i < HIST_BUCKETS; ++i) {
+		seen += lat_hist[i];
+		if (seen >= rank) {
+			uint64_t val = hist_value(i);
+			return val < lat_max ? val : lat_max;
+		}
+	}
+	return lat_max;
+}
+
+static void end_burst()
+{
+	if (!in_burst) {
+		return;
+	}
+	++bursts;
+	if (burst_bytes > burst_max) {
+		burst_max = burst_bytes;
+	}
+	int bucket = log2_floor(burst_bytes);
+	++burst_hist[bucket < BURST_BUCKETS ? bucket : BURST_BUCKETS - 1];
+	in_burst = 0;
+	burst_bytes = 0;
+}
+
+static void record_drop(uint64_t pos, int num_missing)
+{
+	if (in_burst && pos - last_drop_pos > BURST_GAP) {
+		end_burst();
+	}
+	in_burst = 1;
+	burst_bytes += num_missing;
+	last_drop_pos = pos;
+	err_bytes += num_missing;
+	++drop_events;
+}
+
+/* Check whole registers of @buffer from @i against the expected
+ * counter ramp, stopping at the first register containing an error.
+ * Returns the index of that register. */
+static int check_vector(const uint8_t *buffer, int i, int length)
+{
+#if defined(__AVX2__)
+	const __m256i ramp = _mm256_setr_epi8(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16,
+					      17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30,
+					      31, 32);
+	for (; i + SIMD_WIDTH <= length; i += SIMD_WIDTH) {
+		__m256i expect = _mm256_add_epi8(_mm256_set1_epi8((char)last), ramp);
+		__m256i data = _mm256_loadu_si256((const __m256i *)(buffer + i));
+		if ((uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, expect)) != UINT32_MAX) {
+			break;
+		}
+		last = buffer[i + SIMD_WIDTH - 1];
+	}
+#elif defined(__SSE2__)
+	const __m128i ramp = _mm_setr_epi8(1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16);
+	for (; i + SIMD_WIDTH <= length; i += SIMD_WIDTH) {
+		__m128i expect = _mm_add_epi8(_mm_set1_epi8((char)last), ramp);
+		__m128i data = _mm_loadu_si128((const __m128i *)(buffer + i));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(data, expect)) != 0xFFFF) {
+			break;
+		}
+		last = buffer[i + SIMD_WIDTH - 1];
+	}
+#endif
+	return i;
+}
+
+/* Check that @buffer continues the counter from last. A register
+ * containing an error, and the tail of the buffer, are checked byte
+ * by byte to locate the drops. */
+static void check_counter(const uint8_t *buffer, int length)
+{
+	int i = 0;
+	while (i < length) {
+		i = check_vector(buffer, i, length);
+		int end = i + SIMD_WIDTH < length ? i + SIMD_WIDTH : length;
+		for (; i < end; ++i) {
+			uint8_t val = buffer[i];
+			if (val != (uint8_t)(last + 1)) {
+				record_drop(rx_bytes + i, missing(val, last));
+			}
+			last = val;
+		}
+	}
+}
+
+/* Simulate a consumer that needs @ns nanoseconds for this callback. */
+static void consumer_load(uint64_t ns)
+{
+	struct timespec tp;
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	uint64_t deadline = ts_ns(&tp) + ns;
+	do {
+		clock_gettime(CLOCK_MONOTONIC, &tp);
+	} while (ts_ns(&tp) < deadline);
+}
+
 static int callback(uint8_t *buffer, int length, FTDIProgressInfo *progress, void *userdata)
 {
-	uint8_t val;
 	FILE *logfile = (FILE *)userdata;
+	struct timespec tp_cb;
 
 	if (capture_done) {
 		return 1;
 	}
 
-	for (int i = 0; i < length; ++i) {
-		val = (uint8_t)(*(buffer + i));
-		if (val != (uint8_t)(last + 1)) {
-			int num_missing;
-			num_missing = missing(val, last);
-			err_bytes += num_missing;
-#if !DISABLE_RUNTIME_STATS
-			printf("Dropped %u byte(s) at address %u (0x%08x).\n", num_missing,
-			       rx_bytes, rx_bytes);
-#endif
+	clock_gettime(CLOCK_MONOTONIC, &tp_cb);
+	if (callbacks) {
+		uint64_t delta = ts_ns(&tp_cb) - ts_ns(&tp_last_cb);
+		++lat_hist[hist_bucket(delta)];
+		lat_sum += delta;
+		if (delta > lat_max) {
+			lat_max = delta;
 		}
-		last = val;
-		++rx_bytes;
 	}
+	tp_last_cb = tp_cb;
+	++callbacks;
+
+	check_counter(buffer, length);
+	rx_bytes += length;
 
 	if (logfile != NULL) {
 		int ret = fwrite(buffer, 1, length, logfile);
@@ -87,44 +288,157 @@ static int callback(uint8_t *buffer, int length, FTDIProgressInfo *progress, voi
 		}
 	}
 
+	if (settings.load_ns_per_kib > 0) {
+		consumer_load((uint64_t)(settings.load_ns_per_kib * length / 1024));
+	}
+
 	clock_gettime(CLOCK_MONOTONIC, &tp_stop);
-	if (elapsed_time() > capture_time) {
+	if (elapsed_time() > settings.capture_time) {
 		capture_done = 1;
 		return 1;
 	}
 	return 0;
 }
 
-static void print_statistics()
+static double cpu_time(const struct rusage *usage)
 {
-	double t_elapse;
+	return usage->ru_utime.tv_sec + 1e-6 * usage->ru_utime.tv_usec + usage->ru_stime.tv_sec +
+	       1e-6 * usage->ru_stime.tv_usec;
+}
 
-	printf("%u bytes dropped out of %u total bytes received (%.2f%%).\n", err_bytes, rx_bytes,
-	       100 * (double)err_bytes / (double)rx_bytes);
-	t_elapse = elapsed_time();
-	printf("Elapsed time: %fs\n", t_elapse);
-	printf("Achieved throughput: %.4eB/s\n", (double)rx_bytes / t_elapse);
+/* Copy the CPU model name into @buf, or "unknown". */
+static void cpu_model(char *buf, int len)
+{
+	char line[256];
+	FILE *cpuinfo = fopen("/proc/cpuinfo", "r");
+	snprintf(buf, len, "unknown");
+	if (cpuinfo == NULL) {
+		return;
+	}
+	while (fgets(line, sizeof(line), cpuinfo)) {
+		char *colon = strchr(line, ':');
+		if (strncmp(line, "model name", 10) == 0 && colon) {
+			snprintf(buf, len, "%s", colon + 2);
+			buf[strcspn(buf, "\n")] = '\0';
+			break;
+		}
+	}
+	fclose(cpuinfo);
+}
+
+/* Write @str as a JSON string, escaping quotes, backslashes and
+ * control characters. */
+static void json_string(FILE *out, const char *str)
+{
+	fputc('"', out);
+	for (; *str; ++str) {
+		if (*str == '"' || *str == '\\') {
+			fprintf(out, "\\%c", *str);
+		} else if ((unsigned char)*str < 0x20) {
+			fprintf(out, "\\u%04x", *str);
+		} else {
+			fputc(*str, out);
+		}
+	}
+	fputc('"', out);
+}
+
+static void print_statistics(FILE *out, const struct rusage *usage_start,
+			     const struct rusage *usage_stop, int read_ret)
+{
+	double t_elapse = elapsed_time();
+	double cpu = cpu_time(usage_stop) - cpu_time(usage_start);
+	double mb = rx_bytes / 1e6;
+	struct ftdi_version_info version = ftdi_get_library_version();
+	struct utsname uts;
+	char model[128];
+
+	end_burst();
+	uname(&uts);
+	cpu_model(model, sizeof(model));
+
+	fprintf(out, "{\n  \"host\": {\"hostname\": ");
+	json_string(out, uts.nodename);
+	fprintf(out, ", \"kernel\": ");
+	json_string(out, uts.release);
+	fprintf(out, ", \"cpu\": ");
+	json_string(out, model);
+	fprintf(out, ", \"libftdi\": ");
+	json_string(out, version.version_str);
+	fprintf(out, ", \"check\": \"%s\"},\n", SIMD_NAME);
+
+	fprintf(out,
+		"  \"settings\": {\"capture_s\": %g, \"packets_per_transfer\": %d, "
+		"\"transfers_per_callback\": %d, \"chunksize\": %d, \"latency_ms\": %d, "
+		"\"load_ns_per_kib\": %g},\n",
+		settings.capture_time, settings.packets_per_transfer,
+		settings.transfers_per_callback, settings.chunksize, settings.latency,
+		settings.load_ns_per_kib);
+
+	fprintf(out,
+		"  \"throughput\": {\"elapsed_s\": %f, \"bytes\": %llu, \"bytes_per_s\": %.4e, "
+		"\"readstream_status\": %d},\n",
+		t_elapse, (unsigned long long)rx_bytes, t_elapse > 0 ? rx_bytes / t_elapse : 0.0,
+		read_ret);
+
+	fprintf(out,
+		"  \"cpu\": {\"seconds\": %f, \"seconds_per_mb\": %.6e, \"utilization\": %f},\n",
+		cpu, mb > 0 ? cpu / mb : 0.0, t_elapse > 0 ? cpu / t_elapse : 0.0);
+
+	fprintf(out,
+		"  \"callback_interval_ns\": {\"count\": %llu, \"mean\": %.1f, \"p50\": %llu, "
+		"\"p90\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu},\n",
+		(unsigned long long)callbacks,
+		callbacks > 1 ? (double)lat_sum / (callbacks - 1) : 0.0,
+		(unsigned long long)hist_percentile(50), (unsigned long long)hist_percentile(90),
+		(unsigned long long)hist_percentile(99), (unsigned long long)hist_percentile(99.9),
+		(unsigned long long)lat_max);
+
+	fprintf(out,
+		"  \"drops\": {\"bytes\": %llu, \"fraction\": %.4e, \"events\": %llu, "
+		"\"bursts\": %llu, \"max_burst_bytes\": %llu, \"burst_bytes_log2_hist\": [",
+		(unsigned long long)err_bytes, rx_bytes ? (double)err_bytes / rx_bytes : 0.0,
+		(unsigned long long)drop_events, (unsigned long long)bursts,
+		(unsigned long long)burst_max);
+	for (int i = 0; i < BURST_BUCKETS; ++i) {
+		fprintf(out, "%s%llu", i ? ", " : "", (unsigned long long)burst_hist[i]);
+	}
+	fprintf(out, "]}\n}\n");
 }
 
 int main(int argc, char **argv)
 {
 	struct ftdi_context *ftdi = NULL;
+	struct rusage usage_start, usage_stop;
 	int read_ret;
 	int opt;
 	FILE *logfile = NULL;
+	FILE *out = stdout;
 
-	capture_time = CAPTURE_DEFAULT;
-	while ((opt = getopt(argc, argv, "t:l:h")) != -1) {
+	settings.capture_time = CAPTURE_DEFAULT;
+	settings.packets_per_transfer = PACKETS_PER_TRANSFER;
+	settings.transfers_per_callback = TRANSFERS_PER_CALLBACK;
+	settings.chunksize = CHUNKSIZE;
+	settings.latency = LATENCY;
+	settings.load_ns_per_kib = 0;
+	while ((opt = getopt(argc, argv, "t:l:o:w:p:n:c:m:h")) != -1) {
 		switch (opt) {
 		case 'h':
 			printf("Usage: %s [OPTION]\n"
 			       "  -t  capture time (in seconds)\n"
 			       "  -l  log file\n"
+			       "  -o  JSON results file (default stdout)\n"
+			       "  -w  simulated consumer load (ns per KiB received)\n"
+			       "  -p  USB packets per transfer (default %d)\n"
+			       "  -n  transfers in flight (default %d)\n"
+			       "  -c  read chunksize (default %d)\n"
+			       "  -m  FTDI latency timer (ms, default %d)\n"
 			       "  -h  display this message and exit\n",
-			       argv[0]);
+			       argv[0], PACKETS_PER_TRANSFER, TRANSFERS_PER_CALLBACK, CHUNKSIZE,
+			       LATENCY);
 			return 0;
 		case 't':
-			capture_time = (double)atoi(optarg);
+			settings.capture_time = atof(optarg);
 			break;
 		case 'l':
 			logfile = fopen(optarg, "w");
@@ -133,32 +447,50 @@ int main(int argc, char **argv)
 				return 1;
 			}
 			break;
+		case 'o':
+			out = fopen(optarg, "w");
+			if (out == NULL) {
+				fprintf(stderr, "Failed to open results file. Terminating.\n");
+				return 1;
+			}
+			break;
+		case 'w':
+			settings.load_ns_per_kib = atof(optarg);
+			break;
+		case 'p':
+			settings.packets_per_transfer = atoi(optarg);
+			break;
+		case 'n':
+			settings.transfers_per_callback = atoi(optarg);
+			break;
+		case 'c':
+			settings.chunksize = atoi(optarg);
+			break;
+		case 'm':
+			settings.latency = atoi(optarg);
+			break;
 		}
 	}
 
 	if ((ftdi = ftdi_new()) == 0) {
 		fprintf(stderr, "ftdi_new failed\n");
-		fclose(logfile);
 		exit(1);
 	}
 
 	if (ftdi_set_interface(ftdi, INTERFACE_A) < 0) {
 		fprintf(stderr, "ftdi_set_interface failed\n");
-		fclose(logfile);
 		ftdi_free(ftdi);
 		exit(1);
 	}
 
 	if (ftdi_usb_open_desc(ftdi, 0x0403, 0x6010, NULL, NULL) < 0) {
 		fprintf(stderr, "Can't open ftdi device: %s\n", ftdi_get_error_string(ftdi));
-		fclose(logfile);
 		ftdi_free(ftdi);
 		exit(1);
 	}
 
-	if (ftdi_set_latency_timer(ftdi, 2)) {
+	if (ftdi_set_latency_timer(ftdi, settings.latency)) {
 		fprintf(stderr, "Can't set latency, Error %s\n", ftdi_get_error_string(ftdi));
-		fclose(logfile);
 		ftdi_usb_close(ftdi);
 		ftdi_free(ftdi);
 		exit(1);
@@ -168,7 +500,6 @@ int main(int argc, char **argv)
 	if (ftdi_set_bitmode(ftdi, 0xff, BITMODE_SYNCFF) < 0) {
 		fprintf(stderr, "Can't set synchronous fifo mode, Error %s\n",
 			ftdi_get_error_string(ftdi));
-		fclose(logfile);
 		ftdi_usb_close(ftdi);
 		ftdi_free(ftdi);
 		exit(1);
@@ -176,22 +507,28 @@ int main(int argc, char **argv)
 
 	/* Unfortunately this is maxed out on linux as 16KB even
 	 * though FTDI recommends setting it to 64KB. */
-	ftdi_read_data_set_chunksize(ftdi, CHUNKSIZE);
+	ftdi_read_data_set_chunksize(ftdi, settings.chunksize);
 
 	if (ftdi_setflowctrl(ftdi, SIO_RTS_CTS_HS) < 0) {
 		fprintf(stderr, "Unable to set flow control %s\n", ftdi_get_error_string(ftdi));
-		fclose(logfile);
 		ftdi_usb_close(ftdi);
 		ftdi_free(ftdi);
 		exit(1);
 	}
 
+	getrusage(RUSAGE_SELF, &usage_start);
 	clock_gettime(CLOCK_MONOTONIC, &tp_start);
-	read_ret = ftdi_readstream(ftdi, callback, logfile, PACKETS_PER_TRANSFER,
-				   TRANSFERS_PER_CALLBACK);
-	print_statistics();
-	fclose(logfile);
+	read_ret = ftdi_readstream(ftdi, callback, logfile, settings.packets_per_transfer,
+				   settings.transfers_per_callback);
+	getrusage(RUSAGE_SELF, &usage_stop);
+	print_statistics(out, &usage_start, &usage_stop, read_ret);
+	if (out != stdout) {
+		fclose(out);
+	}
+	if (logfile) {
+		fclose(logfile);
+	}
 	ftdi_usb_close(ftdi);
 	ftdi_free(ftdi);
-	return 0;
+	return read_ret < 0;
 }